@@ -33,6 +33,7 @@
 
 #include <common.h>
 #include <command.h>
+#include <cpu_work.h>
 #include <fthread.h>
 #include <asm/system.h>
 #include <asm/cache.h>
@@ -47,6 +48,9 @@ int cleanup_before_linux_select(int flags)
 #ifdef CONFIG_FTHREAD
 	fthread_shutdown();
 #endif
+#ifdef CONFIG_CPU_WORK
+	cpu_work_shutdown();
+#endif
 #ifdef CONFIG_BOOTSTAGE_FDT
 	if (flag == BOOTM_STATE_OS_FAKE_GO)
 		bootstage_fdt_add_report();
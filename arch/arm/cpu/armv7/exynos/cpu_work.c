@@ -0,0 +1,159 @@
+/*
+ * Secondary CPU support for the cpu_work dispatcher on Exynos5420
+ *
+ * Copyright (c) 2013 The Chromium OS Authors.
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#include <common.h>
+#include <cpu_work.h>
+#include <asm/io.h>
+#include <asm/system.h>
+#include <asm/arch/cpu.h>
+#include <asm/arch/system.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/*
+ * We only use the other CPUs in the boot cluster. The other cluster would
+ * need a cluster switch to bring up, which is more trouble than it is worth.
+ */
+#define CPUS_PER_CLUSTER	4
+
+/* Hotplug jump address read by the iRAM wait code (see lowlevel.S) */
+#define HOTPLUG_ADDR		(CONFIG_EXYNOS_RELOCATE_CODE_BASE + 0x1C)
+
+/* Value for ARM_COREn_CONFIG/STATUS meaning the core is powered up */
+#define CORE_LOCAL_PWR_EN	0x3
+
+void exynos_cpu_work_entry(void);
+void exynos_cpu_work_exit(u32 core_config_reg, u32 hotplug_addr)
+	__attribute__((noreturn));
+
+static u8 exynos_cpu_work_stack[CPUS_PER_CLUSTER][CONFIG_CPU_WORK_STACK_SIZE]
+	__aligned(8);
+u32 exynos_cpu_work_stack_top[CPUS_PER_CLUSTER];
+
+/* Page table address for the secondary CPUs (the same as the boot CPU's) */
+static u32 exynos_cpu_work_tlb_addr;
+
+/* Global data pointer for the secondary CPUs, loaded into r8 on entry */
+u32 exynos_cpu_work_gd;
+
+static u32 core_config_reg(int cpu)
+{
+	u32 mpidr;
+
+	/* Physical core number is cluster * 4 + cpu */
+	mrc_mpafr(mpidr);
+	return ARM_CORE0_CONFIG + CORE_CONFIG_OFFSET *
+		(((mpidr >> 6) & ~3) | cpu);
+}
+
+int cpu_work_arch_num_cpus(void)
+{
+	u32 mpidr;
+
+	if (!proid_is_exynos542x())
+		return 1;
+
+	/* We number CPUs by their position in the cluster, so need CPU 0 */
+	mrc_mpafr(mpidr);
+	if (mpidr & 3)
+		return 1;
+
+	return CPUS_PER_CLUSTER;
+}
+
+int cpu_work_arch_start(int cpu)
+{
+	u32 reg = core_config_reg(cpu);
+
+	exynos_cpu_work_stack_top[cpu] =
+		(u32)exynos_cpu_work_stack[cpu + 1] & ~7;
+	exynos_cpu_work_tlb_addr = gd->arch.tlb_addr;
+	exynos_cpu_work_gd = (u32)gd;
+
+	/* Make sure the secondary CPU sees all this with its caches off */
+	flush_dcache_all();
+
+	writel((u32)exynos_cpu_work_entry, HOTPLUG_ADDR);
+	writel(CORE_LOCAL_PWR_EN, reg);
+	dsb();
+	sev();
+
+	return 0;
+}
+
+/*
+ * Called on the secondary CPU from exynos_cpu_work_entry, with the MMU and
+ * caches off. Join the boot CPU's coherency domain, turn on the MMU using
+ * the boot CPU's page tables and go and wait for work.
+ */
+void exynos_cpu_work_secondary(int cpu)
+{
+	u32 val;
+
+	/* Set ACTLR.SMP so that our caches are coherent with the others */
+	mrc_auxr(val);
+	val |= 1 << 6;
+	mcr_auxr(val);
+	isb();
+
+	val = 0;
+	mcr_tlb(val);
+	mcr_icache(val);
+	asm volatile("mcr p15, 0, %0, c2, c0, 0"
+		     : : "r" (exynos_cpu_work_tlb_addr) : "memory");
+	asm volatile("mcr p15, 0, %0, c3, c0, 0" : : "r" (~0));
+	dsb();
+
+	mrc_sctlr(val);
+	val |= CR_M | CR_C | CR_I;
+	mcr_sctlr(val);
+	isb();
+
+	cpu_work_secondary_loop(cpu);
+}
+
+void cpu_work_arch_stop(int cpu)
+{
+	/*
+	 * All secondaries are online before any is stopped, so nobody needs
+	 * the hotplug address now
+	 */
+	exynos_cpu_work_exit(core_config_reg(cpu), HOTPLUG_ADDR);
+}
+
+int cpu_work_arch_stopped(int cpu)
+{
+	return !(readl(core_config_reg(cpu) + 4) & CORE_LOCAL_PWR_EN);
+}
+
+void cpu_work_arch_notify(void)
+{
+	dsb();
+	sev();
+}
+
+void cpu_work_arch_wait(void)
+{
+	wfe();
+	dsb();
+}
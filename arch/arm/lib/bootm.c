@@ -33,6 +33,8 @@
 #include <fdt_support.h>
 #include <asm/bootm.h>
 #include <linux/compiler.h>
+#include <serial.h>
+#include <trace.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -79,10 +81,14 @@ static void announce_and_cleanup(int fake, void *dt)
 	printf("\nStarting kernel ...%s\n\n", fake ?
 		"(fake run for tracing)" : "");
 	bootstage_mark_name(BOOTSTAGE_ID_BOOTM_HANDOFF, "start_kernel");
+#ifdef CONFIG_TRACE_DRAIN
+	trace_drain();
+#endif
 
 #ifdef CONFIG_USB_DEVICE
 	udc_disconnect();
 #endif
+	serial_flush(1);
 	cleanup_before_linux();
 }
 
@@ -38,10 +38,12 @@
  */
 
 #include <common.h>
+#include <serial.h>
 
 int do_reset(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
 	puts ("resetting ...\n");
+	serial_flush(1);
 
 	udelay (50000);				/* wait 50 ms */
 
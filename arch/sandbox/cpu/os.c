@@ -21,8 +21,10 @@
 
 #include <dirent.h>
 #include <errno.h>
+#include <execinfo.h>
 #include <fcntl.h>
 #include <getopt.h>
+#include <signal.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -99,6 +101,8 @@ int os_open(const char *pathname, int os_flags)
 
 	if (os_flags & OS_O_CREAT)
 		flags |= O_CREAT;
+	if (os_flags & OS_O_TRUNC)
+		flags |= O_TRUNC;
 
 	return open(pathname, flags, 0777);
 }
@@ -432,6 +436,85 @@ int os_write_ram_buf(const char *fname)
 	return 0;
 }
 
+/* State of the sampling profiler */
+static uintptr_t *os_prof_buf;		/* Sample buffer */
+static int os_prof_size;		/* Number of samples in buffer */
+static int os_prof_depth;		/* Maximum call depth per sample */
+static volatile unsigned long os_prof_count;	/* Samples taken */
+
+/* Frames to skip: this handler and the kernel's signal trampoline */
+#define OS_PROF_SKIP_FRAMES	2
+#define OS_PROF_MAX_FRAMES	64
+
+static void os_prof_handler(int sig)
+{
+	void *frames[OS_PROF_MAX_FRAMES];
+	uintptr_t *sample;
+	int count, i;
+
+	count = backtrace(frames, OS_PROF_MAX_FRAMES) - OS_PROF_SKIP_FRAMES;
+	if (count <= 0)
+		return;
+	if (count > os_prof_depth)
+		count = os_prof_depth;
+	sample = os_prof_buf + (os_prof_count % os_prof_size) *
+			(os_prof_depth + 1);
+	sample[0] = count;
+	for (i = 0; i < count; i++)
+		sample[i + 1] = (uintptr_t)frames[i + OS_PROF_SKIP_FRAMES];
+	os_prof_count++;
+}
+
+int os_profile_start(uintptr_t *buf, int size, int depth, int interval_us)
+{
+	struct itimerval timer;
+	struct sigaction act;
+	void *frame;
+
+	/* A zero interval would disarm the timer rather than sample */
+	if (os_prof_buf || !size || !depth || interval_us <= 0)
+		return -1;
+	os_prof_buf = buf;
+	os_prof_size = size;
+	os_prof_depth = depth;
+	os_prof_count = 0;
+
+	/* The first call to backtrace() may allocate, so do it here */
+	backtrace(&frame, 1);
+
+	memset(&act, '\0', sizeof(act));
+	act.sa_handler = os_prof_handler;
+	act.sa_flags = SA_RESTART;
+	sigemptyset(&act.sa_mask);
+	if (sigaction(SIGPROF, &act, NULL))
+		goto err;
+
+	timer.it_interval.tv_sec = interval_us / 1000000;
+	timer.it_interval.tv_usec = interval_us % 1000000;
+	timer.it_value = timer.it_interval;
+	if (setitimer(ITIMER_PROF, &timer, NULL))
+		goto err;
+
+	return 0;
+err:
+	os_prof_buf = NULL;
+	return -1;
+}
+
+unsigned long os_profile_stop(void)
+{
+	struct itimerval timer;
+
+	if (!os_prof_buf)
+		return 0;
+	memset(&timer, '\0', sizeof(timer));
+	setitimer(ITIMER_PROF, &timer, NULL);
+	signal(SIGPROF, SIG_DFL);
+	os_prof_buf = NULL;
+
+	return os_prof_count;
+}
+
 int os_read_ram_buf(const char *fname)
 {
 	struct sandbox_state *state = state_get_current();
@@ -20,6 +20,7 @@
  */
 
 #include <common.h>
+#include <hush.h>
 #include <os.h>
 #include <asm/getopt.h>
 #include <asm/sections.h>
@@ -91,6 +92,10 @@ int sandbox_main_loop_init(void)
 
 	/* Execute command if required */
 	if (state->cmd) {
+#ifdef CONFIG_SYS_HUSH_PARSER
+		/* This runs before main_loop(), which normally starts hush */
+		u_boot_hush_start();
+#endif
 		run_command_list(state->cmd, -1, 0);
 		if (!state->interactive)
 			os_exit(state->exit_type);
@@ -175,11 +180,37 @@ static int sandbox_cmdline_cb_ignore_missing(struct sandbox_state *state,
 SANDBOX_CMDLINE_OPT_SHORT(ignore_missing, 'n', 0,
 			  "Ignore missing state on read");
 
+#ifdef CONFIG_TRACE_DRAIN
+static int sandbox_cmdline_cb_trace_file(struct sandbox_state *state,
+					 const char *arg)
+{
+	state->trace_fname = arg;
+	return 0;
+}
+SANDBOX_CMDLINE_OPT_SHORT(trace_file, 't', 1,
+			  "Drain function trace records into a file");
+#endif
+
 int main(int argc, char *argv[])
 {
 	struct sandbox_state *state;
+	gd_t data;
+#ifdef CONFIG_SYS_MALLOC_F
+	char early_malloc[CONFIG_SYS_MALLOC_F_LEN] __aligned(16);
+#endif
 	int ret;
 
+	/*
+	 * Global data must outlive board_init_f(). With FTRACE its exit hook
+	 * is called after its stack frame is released. The same goes for the
+	 * pre-relocation heap, which is used after board_init_f() returns.
+	 */
+	memset(&data, '\0', sizeof(data));
+	gd = &data;
+#ifdef CONFIG_SYS_MALLOC_F
+	gd->malloc_base = (ulong)early_malloc;
+#endif
+
 	ret = state_init();
 	if (ret)
 		goto err;
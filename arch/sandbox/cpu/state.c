@@ -23,6 +23,7 @@
 #include <errno.h>
 #include <fdtdec.h>
 #include <os.h>
+#include <trace.h>
 #include <asm/state.h>
 
 /* Main state record for the sandbox */
@@ -375,6 +376,27 @@ int state_init(void)
 	return 0;
 }
 
+#ifdef CONFIG_TRACE_DRAIN
+/* Append trace chunks to the file given with --trace_file */
+int trace_drain_write(const void *buf, int size)
+{
+	if (!state->trace_fname)
+		return -ENOENT;
+	if (!state->trace_fd) {
+		state->trace_fd = os_open(state->trace_fname, OS_O_WRONLY |
+					  OS_O_CREAT | OS_O_TRUNC);
+		if (state->trace_fd < 0) {
+			state->trace_fd = 0;
+			return -EIO;
+		}
+	}
+	if (os_write(state->trace_fd, buf, size) != size)
+		return -EIO;
+
+	return 0;
+}
+#endif
+
 int state_uninit(void)
 {
 	int err;
@@ -398,6 +420,13 @@ int state_uninit(void)
 
 	if (state->state_fdt)
 		os_free(state->state_fdt);
+#ifdef CONFIG_TRACE_DRAIN
+	if (state->trace_fname) {
+		trace_drain();
+		if (state->trace_fd)
+			os_close(state->trace_fd);
+	}
+#endif
 	memset(state, '\0', sizeof (*state));
 
 	return 0;
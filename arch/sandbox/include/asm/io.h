@@ -56,4 +56,32 @@ static inline void unmap_sysmem(const void *vaddr)
 /* Map from a pointer to our RAM buffer */
 phys_addr_t map_to_sysmem(void *ptr);
 
+/* There are no memory-mapped devices, so these do nothing */
+static inline u8 readb(const volatile void *addr)
+{
+	return 0;
+}
+
+static inline u16 readw(const volatile void *addr)
+{
+	return 0;
+}
+
+static inline u32 readl(const volatile void *addr)
+{
+	return 0;
+}
+
+static inline void writeb(u8 val, volatile void *addr)
+{
+}
+
+static inline void writew(u16 val, volatile void *addr)
+{
+}
+
+static inline void writel(u32 val, volatile void *addr)
+{
+}
+
 #endif
@@ -56,6 +56,9 @@ struct sandbox_state {
 	bool read_state;		/* Read sandbox state on startup */
 	bool write_state;		/* Write sandbox state on exit */
 	bool ignore_missing_state_on_read;	/* No error if state missing */
+	const char *trace_fname;	/* File to drain function trace into */
+	int trace_fd;			/* Trace drain file, 0 if not open */
+	const char *nand_fname;		/* Filename of emulated NAND flash */
 
 	/* Pointer to information for each SPI bus/cs */
 	struct sandbox_spi_info spi[CONFIG_SANDBOX_SPI_MAX_BUS]
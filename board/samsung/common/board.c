@@ -26,6 +26,7 @@
 #include <fdtdec.h>
 #include <i2c.h>
 #include <lcd.h>
+#include <malloc.h>
 #include <spi.h>
 #include <tmu.h>
 #include <asm/io.h>
@@ -397,15 +398,32 @@ int board_is_processor_reset(void)
 
 #ifdef CONFIG_OF_CONTROL
 #define MAX_REV_GPIO_COUNT	5
+
+/* Board revision, decoded once before relocation and then cached */
+struct board_rev_cache {
+	int board_rev;
+	int subrev;
+};
+
 void board_get_full_revision(int *board_rev_out, int *subrev_out)
 {
 	struct fdt_gpio_state gpios[MAX_REV_GPIO_COUNT];
 	unsigned gpio_list[MAX_REV_GPIO_COUNT];
+	__maybe_unused struct board_rev_cache *cache;
 	int board_rev = -1;
 	int subrev = 0;
 	int count = 0;
 	int node;
 
+#ifdef CONFIG_SYS_MALLOC_F
+	/* Reading the strapping GPIOs is slow, so only do it once */
+	cache = early_cache_get(EARLY_CACHE_BOARD_REV);
+	if (cache) {
+		board_rev = cache->board_rev;
+		subrev = cache->subrev;
+		goto done;
+	}
+#endif
 	node = fdtdec_next_compatible(gd->fdt_blob, 0,
 				      COMPAT_GOOGLE_BOARD_REV);
 	if (node >= 0) {
@@ -432,6 +450,14 @@ void board_get_full_revision(int *board_rev_out, int *subrev_out)
 	} else {
 		debug("%s: No board revision information in fdt\n", __func__);
 	}
+#ifdef CONFIG_SYS_MALLOC_F
+	cache = early_cache_alloc(EARLY_CACHE_BOARD_REV, sizeof(*cache));
+	if (cache) {
+		cache->board_rev = board_rev;
+		cache->subrev = subrev;
+	}
+done:
+#endif
 
 	if (board_rev_out)
 		*board_rev_out = board_rev;
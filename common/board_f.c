@@ -29,6 +29,7 @@
 #include <common.h>
 #include <linux/compiler.h>
 #include <version.h>
+#include <console_log.h>
 #include <environment.h>
 #include <fdtdec.h>
 #include <fs.h>
@@ -284,10 +285,28 @@ static int init_func_spi(void)
 __maybe_unused
 static int zero_global_data(void)
 {
+#ifdef CONFIG_SYS_MALLOC_F
+	/* This is set up by our caller */
+	ulong malloc_base = gd->malloc_base;
+#endif
+
 	memset((void *)gd, '\0', sizeof(gd_t));
+#ifdef CONFIG_SYS_MALLOC_F
+	gd->malloc_base = malloc_base;
+#endif
+
+	return 0;
+}
+
+#ifdef CONFIG_SYS_MALLOC_F
+static int initf_malloc(void)
+{
+	gd->malloc_limit = gd->malloc_base ? CONFIG_SYS_MALLOC_F_LEN : 0;
+	gd->malloc_ptr = 0;
 
 	return 0;
 }
+#endif
 
 static int setup_mon_len(void)
 {
@@ -519,6 +538,20 @@ static int reserve_trace(void)
 	return 0;
 }
 
+#ifdef CONFIG_CONSOLE_LOG
+static int reserve_console_log(void)
+{
+	gd->dest_addr -= CONFIG_CONSOLE_LOG_SIZE;
+	gd->dest_addr &= ~(4096 - 1);
+	console_log_init(map_sysmem(gd->dest_addr, CONFIG_CONSOLE_LOG_SIZE),
+			 CONFIG_CONSOLE_LOG_SIZE);
+	debug("Reserving %dk for console log at: %08lx\n",
+	      CONFIG_CONSOLE_LOG_SIZE >> 10, gd->dest_addr);
+
+	return 0;
+}
+#endif
+
 #if defined(CONFIG_VIDEO) && (!defined(CONFIG_PPC) || defined(CONFIG_8xx)) \
 		&& !defined(CONFIG_ARM) && !defined(CONFIG_X86)
 static int reserve_video(void)
@@ -831,6 +864,9 @@ static const init_fnc_t init_sequence_f[] = {
 		!defined(CONFIG_MPC86xx) && !defined(CONFIG_X86)
 	zero_global_data,
 #endif
+#ifdef CONFIG_SYS_MALLOC_F
+	initf_malloc,
+#endif
 #ifdef CONFIG_SANDBOX
 	setup_ram_buf,
 #endif
@@ -984,6 +1020,9 @@ static const init_fnc_t init_sequence_f[] = {
 	reserve_lcd,
 #endif
 	reserve_trace,
+#ifdef CONFIG_CONSOLE_LOG
+	reserve_console_log,
+#endif
 	/* TODO: Why the dependency on CONFIG_8xx? */
 #if defined(CONFIG_VIDEO) && (!defined(CONFIG_PPC) || defined(CONFIG_8xx)) \
 		&& !defined(CONFIG_ARM) && !defined(CONFIG_X86)
@@ -1021,10 +1060,18 @@ static const init_fnc_t init_sequence_f[] = {
 
 void board_init_f(ulong boot_flags)
 {
-#ifndef CONFIG_X86
+	/* Sandbox returns from this function, so sets up gd in its caller */
+#if !defined(CONFIG_X86) && !defined(CONFIG_SANDBOX)
 	gd_t data;
+#ifdef CONFIG_SYS_MALLOC_F
+	/* Pre-relocation heap, which stays put when we relocate */
+	char early_malloc[CONFIG_SYS_MALLOC_F_LEN] __aligned(16);
+#endif
 
 	gd = &data;
+#ifdef CONFIG_SYS_MALLOC_F
+	gd->malloc_base = (ulong)early_malloc;
+#endif
 #endif
 
 	gd->flags = boot_flags;
@@ -31,6 +31,7 @@
 #if defined(CONFIG_CMD_BEDBUG)
 #include <bedbug/type.h>
 #endif
+#include <command.h>
 #ifdef CONFIG_HAS_DATAFLASH
 #include <dataflash.h>
 #endif
@@ -283,6 +284,28 @@ static int initr_malloc(void)
 	return 0;
 }
 
+#ifdef CONFIG_SYS_CMD_LOOKUP_HASH
+static int initr_cmd_hash(void)
+{
+	/* Without the index, command lookup is just slower */
+	if (cmd_hash_build())
+		debug("%s: Cannot build command index\n", __func__);
+
+	return 0;
+}
+#endif
+
+#ifdef CONFIG_FDTDEC_INDEX
+static int initr_fdtdec_index(void)
+{
+	/* Without an index, lookups are just slower, so this is not fatal */
+	if (fdtdec_index_build(gd->fdt_blob))
+		debug("%s: Cannot build device tree index\n", __func__);
+
+	return 0;
+}
+#endif
+
 __weak int power_init_board(void)
 {
 	return 0;
@@ -793,6 +816,12 @@ static const init_fnc_t init_sequence_r[] = {
 #endif
 	initr_barrier,
 	initr_malloc,
+#ifdef CONFIG_FDTDEC_INDEX
+	initr_fdtdec_index,
+#endif
+#ifdef CONFIG_SYS_CMD_LOOKUP_HASH
+	initr_cmd_hash,
+#endif
 	bootstage_relocate,
 #ifdef CONFIG_ARCH_EARLY_INIT_R
 	arch_early_init_r,
@@ -29,6 +29,7 @@
  */
 
 #include <common.h>
+#include <errno.h>
 #include <fdtdec.h>
 #include <fdt_support.h>
 #include <libfdt.h>
@@ -48,6 +49,33 @@ struct bootstage_record {
 static struct bootstage_record record[BOOTSTAGE_ID_COUNT] = { {1} };
 static int next_id __attribute__((section(".data"))) = BOOTSTAGE_ID_USER;
 
+#ifdef CONFIG_BOOTSTAGE_SPANS
+/*
+ * A span is a timed region of code, which may be nested inside other spans
+ * and may happen many times. Spans are kept in a ring so that the most
+ * recent CONFIG_BOOTSTAGE_SPAN_COUNT are available.
+ */
+struct bootstage_span {
+	const char *name;
+	const char *device;	/* Device name, or NULL if none */
+	ulong bytes;		/* Number of bytes processed, 0 if unknown */
+	uint32_t start_us;
+	uint32_t duration_us;	/* Time taken, -1U if not yet ended */
+	int seq;		/* Sequence number of this span */
+	int depth;		/* Nesting depth, 0 for top level */
+};
+
+static struct bootstage_span span[CONFIG_BOOTSTAGE_SPAN_COUNT];
+static int span_seq;		/* Sequence number of next span */
+static int span_depth;		/* Current nesting depth */
+
+/*
+ * Span for each bootstage id used with bootstage_start(), plus 1. This is
+ * written before relocation, so must not be in .bss
+ */
+static int accum_span[BOOTSTAGE_ID_COUNT] __attribute__((section(".data")));
+#endif
+
 enum {
 	BOOTSTAGE_VERSION	= 0,
 	BOOTSTAGE_MAGIC		= 0xb00757a3,
@@ -154,12 +182,76 @@ ulong bootstage_mark_code(const char *file, const char *func, int linenum)
 	return bootstage_mark_name(BOOTSTAGE_ID_ALLOC, str);
 }
 
+#ifdef CONFIG_BOOTSTAGE_SPANS
+static struct bootstage_span *find_span(int seq)
+{
+	struct bootstage_span *sp;
+
+	if (seq < 0)
+		return NULL;
+	sp = &span[seq % CONFIG_BOOTSTAGE_SPAN_COUNT];
+
+	/* The span may have been overwritten by a newer one */
+	return sp->seq == seq ? sp : NULL;
+}
+
+int bootstage_span_begin(const char *name)
+{
+	struct bootstage_span *sp;
+
+	/* Before relocation we have no BSS */
+	if (!(gd->flags & GD_FLG_RELOC))
+		return -1;
+
+	sp = &span[span_seq % CONFIG_BOOTSTAGE_SPAN_COUNT];
+	sp->name = name;
+	sp->device = NULL;
+	sp->bytes = 0;
+	sp->seq = span_seq;
+	sp->depth = span_depth++;
+	sp->duration_us = -1U;
+	sp->start_us = timer_get_us();
+
+	return span_seq++;
+}
+
+void bootstage_span_args(int seq, const char *device, ulong bytes)
+{
+	struct bootstage_span *sp = find_span(seq);
+
+	if (sp) {
+		sp->device = device;
+		sp->bytes = bytes;
+	}
+}
+
+uint32_t bootstage_span_end(int seq)
+{
+	uint32_t now = timer_get_us();
+	struct bootstage_span *sp;
+
+	if (seq < 0)
+		return 0;
+	if (span_depth)
+		span_depth--;
+	sp = find_span(seq);
+	if (!sp)
+		return 0;
+	sp->duration_us = now - sp->start_us;
+
+	return sp->duration_us;
+}
+#endif
+
 uint32_t bootstage_start(enum bootstage_id id, const char *name)
 {
 	struct bootstage_record *rec = &record[id];
 
 	rec->start_us = timer_get_us();
 	rec->name = name;
+#ifdef CONFIG_BOOTSTAGE_SPANS
+	accum_span[id] = bootstage_span_begin(name) + 1;
+#endif
 	return rec->start_us;
 }
 
@@ -170,6 +262,10 @@ uint32_t bootstage_accum(enum bootstage_id id)
 
 	duration = (uint32_t)timer_get_us() - rec->start_us;
 	rec->time_us += duration;
+#ifdef CONFIG_BOOTSTAGE_SPANS
+	bootstage_span_end(accum_span[id] - 1);
+	accum_span[id] = 0;
+#endif
 	return duration;
 }
 
@@ -331,6 +427,7 @@ void bootstage_report(void)
 	gd->flags = old_flags;
 #endif
 }
+
 /**
  * Append data to a memory buffer
  *
@@ -353,6 +450,129 @@ static void append_data(char **ptrp, char *end, const void *data, int size)
 	memcpy(ptr, data, size);
 }
 
+#ifdef CONFIG_BOOTSTAGE_SPANS
+void bootstage_span_report(void)
+{
+	struct bootstage_span *sp;
+	int seq;
+
+	puts("Spans in microseconds:\n");
+	printf("%11s%11s  %s\n", "Start", "Duration", "Span");
+	seq = max(span_seq - CONFIG_BOOTSTAGE_SPAN_COUNT, 0);
+	for (; seq < span_seq; seq++) {
+		sp = find_span(seq);
+		print_grouped_ull(sp->start_us, BOOTSTAGE_DIGITS);
+		if (sp->duration_us == -1U)
+			printf("%11s", "-");
+		else
+			print_grouped_ull(sp->duration_us, BOOTSTAGE_DIGITS);
+		printf("  %*s%s", sp->depth * 2, "",
+		       sp->name ? sp->name : "?");
+		if (sp->device)
+			printf(" %s", sp->device);
+		if (sp->bytes) {
+			putc(' ');
+			print_size(sp->bytes, "");
+		}
+		putc('\n');
+	}
+	if (span_seq > CONFIG_BOOTSTAGE_SPAN_COUNT)
+		printf("(%d older spans dropped)\n",
+		       span_seq - CONFIG_BOOTSTAGE_SPAN_COUNT);
+}
+
+/* Output state for bootstage_export_json() */
+struct json_out {
+	char *ptr;
+	char *end;
+	int len;		/* Total length needed so far */
+};
+
+static void json_printf(struct json_out *out, const char *fmt, ...)
+{
+	char buf[80];
+	va_list args;
+	int len;
+
+	va_start(args, fmt);
+	vscnprintf(buf, sizeof(buf), fmt, args);
+	va_end(args);
+	len = strlen(buf);
+	append_data(&out->ptr, out->end, buf, len);
+	out->len += len;
+}
+
+/* Output a string, escaping characters which JSON does not allow */
+static void json_string(struct json_out *out, const char *str)
+{
+	json_printf(out, "\"");
+	for (; *str; str++) {
+		if (*str == '"' || *str == '\\')
+			json_printf(out, "\\%c", *str);
+		else if ((unsigned char)*str < ' ')
+			json_printf(out, "\\u%04x", (unsigned char)*str);
+		else
+			json_printf(out, "%c", *str);
+	}
+	json_printf(out, "\"");
+}
+
+int bootstage_export_json(char *buf, int size)
+{
+	struct json_out out = { .ptr = buf, .end = buf + size };
+	struct bootstage_record *rec;
+	struct bootstage_span *sp;
+	const char *sep = "";
+	char name[20];
+	int seq, id;
+
+	json_printf(&out, "{\"traceEvents\":[\n");
+
+	/* Spans become complete events, nested by their timing */
+	seq = max(span_seq - CONFIG_BOOTSTAGE_SPAN_COUNT, 0);
+	for (; seq < span_seq; seq++) {
+		sp = find_span(seq);
+		if (sp->duration_us == -1U)
+			continue;
+		json_printf(&out, "%s{\"name\":", sep);
+		json_string(&out, sp->name ? sp->name : "?");
+		json_printf(&out, ",\"ph\":\"X\",\"ts\":%u,\"dur\":%u",
+			    sp->start_us, sp->duration_us);
+		json_printf(&out, ",\"pid\":0,\"tid\":0,\"args\":{");
+		json_printf(&out, "\"depth\":%d", sp->depth);
+		if (sp->device) {
+			json_printf(&out, ",\"device\":");
+			json_string(&out, sp->device);
+		}
+		if (sp->bytes)
+			json_printf(&out, ",\"bytes\":%lu", sp->bytes);
+		json_printf(&out, "}}");
+		sep = ",\n";
+	}
+
+	/* Bootstage marks become instant events; record 0 is just a marker */
+	for (id = 1, rec = record + 1; id < BOOTSTAGE_ID_COUNT; id++, rec++) {
+		if (!rec->time_us || rec->start_us)
+			continue;
+		json_printf(&out, "%s{\"name\":", sep);
+		json_string(&out, get_record_name(name, sizeof(name), rec));
+		json_printf(&out, ",\"ph\":\"i\",\"s\":\"g\",\"ts\":%lu",
+			    rec->time_us);
+		json_printf(&out, ",\"pid\":0,\"tid\":0}");
+		sep = ",\n";
+	}
+	json_printf(&out, "\n]}\n");
+
+	if (out.len > size) {
+		debug("%s: Need %d bytes for JSON output\n", __func__,
+		      out.len);
+		return -ENOSPC;
+	}
+
+	return out.len;
+}
+#endif
+
 int bootstage_stash(void *base, int size)
 {
 	struct bootstage_hdr *hdr = (struct bootstage_hdr *)base;
@@ -27,6 +27,74 @@
 #include <errno.h>
 #include <bouncebuf.h>
 
+/*
+ * Bounce buffers are allocated and freed for every transfer, so keep a few
+ * around for reuse rather than going back to memalign() each time.
+ * Buffers larger than CONFIG_BOUNCE_BUFFER_POOL_MAX are not kept.
+ */
+#ifndef CONFIG_BOUNCE_BUFFER_POOL_COUNT
+#define CONFIG_BOUNCE_BUFFER_POOL_COUNT	4
+#endif
+
+#ifndef CONFIG_BOUNCE_BUFFER_POOL_MAX
+#define CONFIG_BOUNCE_BUFFER_POOL_MAX	(1 << 20)
+#endif
+
+struct bounce_pool_entry {
+	void *buf;		/* Buffer, aligned to ARCH_DMA_MINALIGN */
+	size_t size;		/* Size of buffer in bytes */
+	int busy;		/* 1 if currently in use */
+};
+
+static struct bounce_pool_entry bounce_pool[CONFIG_BOUNCE_BUFFER_POOL_COUNT];
+
+static void *bounce_alloc(size_t size)
+{
+	struct bounce_pool_entry *entry, *spare = NULL;
+	int i;
+
+	if (size > CONFIG_BOUNCE_BUFFER_POOL_MAX)
+		return memalign(ARCH_DMA_MINALIGN, size);
+
+	for (i = 0, entry = bounce_pool; i < CONFIG_BOUNCE_BUFFER_POOL_COUNT;
+	     i++, entry++) {
+		if (entry->busy)
+			continue;
+		if (entry->size >= size) {
+			entry->busy = 1;
+			return entry->buf;
+		}
+		if (!spare || entry->size < spare->size)
+			spare = entry;
+	}
+	if (!spare)
+		return memalign(ARCH_DMA_MINALIGN, size);
+
+	/* Replace the smallest free buffer with one that is large enough */
+	free(spare->buf);
+	spare->size = 0;
+	spare->buf = memalign(ARCH_DMA_MINALIGN, size);
+	if (!spare->buf)
+		return NULL;
+	spare->size = size;
+	spare->busy = 1;
+
+	return spare->buf;
+}
+
+static void bounce_free(void *buf)
+{
+	int i;
+
+	for (i = 0; i < CONFIG_BOUNCE_BUFFER_POOL_COUNT; i++) {
+		if (bounce_pool[i].buf == buf) {
+			bounce_pool[i].busy = 0;
+			return;
+		}
+	}
+	free(buf);
+}
+
 static int addr_aligned(struct bounce_buffer *state)
 {
 	const ulong align_mask = ARCH_DMA_MINALIGN - 1;
@@ -47,18 +115,86 @@ static int addr_aligned(struct bounce_buffer *state)
 	return 1;
 }
 
+static void add_segment(struct bounce_buffer *state, void *addr, size_t len)
+{
+	if (len) {
+		state->seg[state->num_segs].addr = addr;
+		state->seg[state->num_segs].len = len;
+		state->num_segs++;
+	}
+}
+
+/*
+ * Set up a split transfer: the cache-line-aligned middle of the user
+ * buffer is used in place, and only the partial cache lines at each end
+ * are bounced, through a single buffer of two cache lines.
+ *
+ * Returns 0 if OK, 1 if the buffer is too small to split, -ENOMEM if out
+ * of memory.
+ */
+static int bounce_buffer_split(struct bounce_buffer *state)
+{
+	const ulong align = ARCH_DMA_MINALIGN;
+	ulong start = (ulong)state->user_buffer;
+	ulong end = start + state->len;
+	ulong mid_start = ALIGN(start, align);
+	ulong mid_end = end & ~(align - 1);
+	void *head, *tail;
+
+	if (mid_end <= mid_start)
+		return 1;
+
+	/*
+	 * If the hardware is only reading, the cache flush below is enough.
+	 * Flushing whole cache lines does no harm to data outside the buffer.
+	 */
+	if (!(state->flags & GEN_BB_WRITE)) {
+		add_segment(state, state->user_buffer, state->len);
+		flush_dcache_range(start & ~(align - 1), ALIGN(end, align));
+		return 0;
+	}
+
+	state->edge_buffer = bounce_alloc(align * 2);
+	if (!state->edge_buffer)
+		return -ENOMEM;
+	head = state->edge_buffer + align - (mid_start - start);
+	tail = state->edge_buffer + align;
+	if (state->flags & GEN_BB_READ) {
+		memcpy(head, state->user_buffer, mid_start - start);
+		memcpy(tail, (void *)mid_end, end - mid_end);
+	}
+	add_segment(state, head, mid_start - start);
+	add_segment(state, (void *)mid_start, mid_end - mid_start);
+	add_segment(state, tail, end - mid_end);
+
+	flush_dcache_range((ulong)state->edge_buffer,
+			   (ulong)state->edge_buffer + align * 2);
+	flush_dcache_range(mid_start, mid_end);
+
+	return 0;
+}
+
 int bounce_buffer_start(struct bounce_buffer *state, void *data,
 			size_t len, unsigned int flags)
 {
+	int ret;
+
 	state->user_buffer = data;
 	state->bounce_buffer = data;
+	state->edge_buffer = NULL;
 	state->len = len;
 	state->len_aligned = roundup(len, ARCH_DMA_MINALIGN);
 	state->flags = flags;
+	state->num_segs = 0;
 
 	if (!addr_aligned(state)) {
-		state->bounce_buffer = memalign(ARCH_DMA_MINALIGN,
-						state->len_aligned);
+		if (flags & GEN_BB_SPLIT) {
+			ret = bounce_buffer_split(state);
+			if (ret <= 0)
+				return ret;
+		}
+
+		state->bounce_buffer = bounce_alloc(state->len_aligned);
 		if (!state->bounce_buffer)
 			return -ENOMEM;
 
@@ -66,6 +202,7 @@ int bounce_buffer_start(struct bounce_buffer *state, void *data,
 			memcpy(state->bounce_buffer, state->user_buffer,
 				state->len);
 	}
+	add_segment(state, state->bounce_buffer, state->len);
 
 	/*
 	 * Flush data to RAM so DMA reads can pick it up,
@@ -78,8 +215,32 @@ int bounce_buffer_start(struct bounce_buffer *state, void *data,
 	return 0;
 }
 
+/* Finish off a transfer set up by bounce_buffer_split() */
+static void bounce_buffer_stop_split(struct bounce_buffer *state)
+{
+	const ulong align = ARCH_DMA_MINALIGN;
+	ulong start = (ulong)state->user_buffer;
+	ulong end = start + state->len;
+	ulong mid_start = ALIGN(start, align);
+	ulong mid_end = end & ~(align - 1);
+
+	invalidate_dcache_range(mid_start, mid_end);
+	invalidate_dcache_range((ulong)state->edge_buffer,
+				(ulong)state->edge_buffer + align * 2);
+	memcpy(state->user_buffer,
+	       state->edge_buffer + align - (mid_start - start),
+	       mid_start - start);
+	memcpy((void *)mid_end, state->edge_buffer + align, end - mid_end);
+	bounce_free(state->edge_buffer);
+}
+
 int bounce_buffer_stop(struct bounce_buffer *state)
 {
+	if (state->edge_buffer) {
+		bounce_buffer_stop_split(state);
+		return 0;
+	}
+
 	if (state->flags & GEN_BB_WRITE) {
 		/* Invalidate cache so that CPU can see any newly DMA'd data */
 		invalidate_dcache_range((unsigned long)state->bounce_buffer,
@@ -93,7 +254,7 @@ int bounce_buffer_stop(struct bounce_buffer *state)
 	if (state->flags & GEN_BB_WRITE)
 		memcpy(state->user_buffer, state->bounce_buffer, state->len);
 
-	free(state->bounce_buffer);
+	bounce_free(state->bounce_buffer);
 
 	return 0;
 }
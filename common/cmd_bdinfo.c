@@ -75,6 +75,16 @@ static void print_lnum(const char *name, unsigned long long value)
 	printf("%-12s= 0x%.8llX\n", name, value);
 }
 
+__maybe_unused
+static void print_malloc_f(void)
+{
+#ifdef CONFIG_SYS_MALLOC_F
+	print_num("early malloc", gd->malloc_base);
+	print_num("-> size", gd->malloc_limit);
+	print_num("-> used", gd->malloc_ptr);
+#endif
+}
+
 __maybe_unused
 static void print_mhz(const char *name, unsigned long hz)
 {
@@ -395,6 +405,7 @@ int do_bdinfo(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 #if defined(CONFIG_LCD) || defined(CONFIG_VIDEO)
 	print_num("FB base  ", gd->fb_base);
 #endif
+	print_malloc_f();
 	/*
 	 * TODO: Currently only support for davinci SOC's is added.
 	 * Remove this check once all the board implement this.
@@ -483,6 +494,7 @@ int do_bdinfo(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 #if defined(CONFIG_LCD) || defined(CONFIG_VIDEO)
 	print_num("FB base  ", gd->fb_base);
 #endif
+	print_malloc_f();
 	return 0;
 }
 
@@ -21,6 +21,12 @@
  */
 
 #include <common.h>
+#include <errno.h>
+#include <malloc.h>
+#include <asm/io.h>
+#ifdef CONFIG_SANDBOX
+#include <os.h>
+#endif
 
 #ifndef CONFIG_BOOTSTAGE_STASH
 #define CONFIG_BOOTSTAGE_STASH		-1UL
@@ -79,10 +85,91 @@ static int do_bootstage_stash(cmd_tbl_t *cmdtp, int flag, int argc,
 	return 0;
 }
 
+#ifdef CONFIG_BOOTSTAGE_SPANS
+static int do_bootstage_spans(cmd_tbl_t *cmdtp, int flag, int argc,
+			      char * const argv[])
+{
+	bootstage_span_report();
+
+	return 0;
+}
+
+#ifdef CONFIG_SANDBOX
+static int export_to_file(const char *fname)
+{
+	int size = 1 << 20;
+	char *buf;
+	int ret, fd;
+
+	buf = malloc(size);
+	if (!buf) {
+		printf("Out of memory\n");
+		return 1;
+	}
+	ret = bootstage_export_json(buf, size);
+	if (ret < 0) {
+		printf("Export failed (err=%d)\n", ret);
+		free(buf);
+		return 1;
+	}
+	fd = os_open(fname, OS_O_WRONLY | OS_O_CREAT | OS_O_TRUNC);
+	if (fd < 0) {
+		printf("Cannot open '%s'\n", fname);
+		free(buf);
+		return 1;
+	}
+	if (os_write(fd, buf, ret) != ret)
+		ret = -EIO;
+	os_close(fd);
+	free(buf);
+	if (ret < 0) {
+		printf("Cannot write '%s'\n", fname);
+		return 1;
+	}
+	printf("Exported %d bytes to '%s'\n", ret, fname);
+
+	return 0;
+}
+#endif
+
+static int do_bootstage_export(cmd_tbl_t *cmdtp, int flag, int argc,
+			       char * const argv[])
+{
+	ulong addr, size;
+	char *buf;
+	int ret;
+
+#ifdef CONFIG_SANDBOX
+	if (argc == 3 && !strcmp(argv[1], "-f"))
+		return export_to_file(argv[2]);
+#endif
+	if (argc != 3)
+		return CMD_RET_USAGE;
+	addr = simple_strtoul(argv[1], NULL, 16);
+	size = simple_strtoul(argv[2], NULL, 16);
+
+	buf = map_sysmem(addr, size);
+	ret = bootstage_export_json(buf, size);
+	unmap_sysmem(buf);
+	if (ret < 0) {
+		printf("Export failed (err=%d)\n", ret);
+		return 1;
+	}
+	printf("Exported %d bytes\n", ret);
+	setenv_hex("filesize", ret);
+
+	return 0;
+}
+#endif
+
 U_BOOT_SUBCMD_START(cmd_bootstage_sub)
 	U_BOOT_CMD_MKENT(report, 2, 1, do_bootstage_report, "", "")
 	U_BOOT_CMD_MKENT(stash, 4, 0, do_bootstage_stash, "", "")
 	U_BOOT_CMD_MKENT(unstash, 4, 0, do_bootstage_stash, "", "")
+#ifdef CONFIG_BOOTSTAGE_SPANS
+	U_BOOT_CMD_MKENT(spans, 2, 1, do_bootstage_spans, "", "")
+	U_BOOT_CMD_MKENT(export, 3, 0, do_bootstage_export, "", "")
+#endif
 U_BOOT_SUBCMD_END
 
 /*
@@ -113,4 +200,11 @@ U_BOOT_CMD(bootstage, 4, 1, do_boostage,
 	"report                      - Print a report\n"
 	"stash [<start> [<size>]]    - Stash data into memory\n"
 	"unstash [<start> [<size>]]  - Unstash data from memory"
+#ifdef CONFIG_BOOTSTAGE_SPANS
+	"\nspans                       - List recorded spans\n"
+	"export <start> <size>       - Export trace-event JSON to memory"
+#ifdef CONFIG_SANDBOX
+	"\nexport -f <file>            - Export trace-event JSON to a file"
+#endif
+#endif
 );
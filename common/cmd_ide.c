@@ -959,6 +959,8 @@ ulong ide_write(int device, ulong blknr, lbaint_t blkcnt, const void *buffer)
 	ulong n = 0;
 	unsigned char c;
 
+	part_efi_note_write(&ide_dev_desc[device], blknr, blkcnt);
+
 #ifdef CONFIG_LBA48
 	unsigned char lba48 = 0;
 
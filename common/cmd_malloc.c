@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2013 The Chromium OS Authors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#include <common.h>
+#include <command.h>
+#include <malloc.h>
+#include <mempool.h>
+
+static int do_malloc_stats(cmd_tbl_t *cmdtp, int flag, int argc,
+			   char * const argv[])
+{
+	struct mallinfo info;
+	ulong outside_top;
+
+	info = mallinfo();
+	printf("Heap:      %08lx - %08lx, size %#lx\n", mem_malloc_start,
+	       mem_malloc_end, mem_malloc_end - mem_malloc_start);
+	printf("Used:      %#x bytes, peak %#x\n", info.uordblks,
+	       info.usmblks);
+	printf("Free:      %#x bytes in %d chunks, top chunk %#x\n",
+	       info.fordblks, info.ordblks, info.keepcost);
+	printf("Untouched: %#lx bytes above the break\n",
+	       mem_malloc_end - mem_malloc_brk);
+
+	/* Free space which is not in the top chunk is fragmented */
+	outside_top = info.fordblks - info.keepcost;
+	printf("Fragments: %#lx bytes (%lu%% of free space)\n", outside_top,
+	       info.fordblks ? outside_top * 100 / info.fordblks : 0);
+	printf("\n");
+	mem_pool_print_stats();
+	printf("\n");
+	arena_print_stats();
+
+	return 0;
+}
+
+static cmd_tbl_t cmd_malloc_sub[] = {
+	U_BOOT_CMD_MKENT(stats, 1, 0, do_malloc_stats, "", "")
+};
+
+static int do_malloc(cmd_tbl_t *cmdtp, int flag, int argc,
+		     char * const argv[])
+{
+	cmd_tbl_t *c;
+
+	if (argc < 2)
+		return CMD_RET_USAGE;
+
+	/* Strip off leading 'malloc' command argument */
+	argc--;
+	argv++;
+
+	c = find_cmd_tbl(argv[0], cmd_malloc_sub, ARRAY_SIZE(cmd_malloc_sub));
+	if (c)
+		return c->cmd(cmdtp, flag, argc, argv);
+	else
+		return CMD_RET_USAGE;
+}
+
+U_BOOT_CMD(
+	malloc,	2,	1,	do_malloc,
+	"malloc information",
+	"stats - show heap usage, fragmentation and pool/arena statistics"
+);
@@ -89,6 +89,12 @@ int do_part(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 		return do_part_uuid(argc - 2, argv + 2);
 	else if (!strcmp(argv[1], "list"))
 		return do_part_list(argc - 2, argv + 2);
+#ifdef CONFIG_EFI_PARTITION_CACHE
+	else if (!strcmp(argv[1], "cache")) {
+		part_efi_print_cache_stats();
+		return 0;
+	}
+#endif
 
 	return CMD_RET_USAGE;
 }
@@ -102,4 +108,8 @@ U_BOOT_CMD(
 	"    - set environment variable to partition UUID\n"
 	"part list <interface> <dev>\n"
 	"    - print a device's partition table"
+#ifdef CONFIG_EFI_PARTITION_CACHE
+	"\npart cache\n"
+	"    - show GPT cache statistics"
+#endif
 );
@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2013 The Chromium OS Authors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+/*
+ * Sampling profiler for sandbox. This uses a SIGPROF timer to record the
+ * call stack at regular intervals, which is much cheaper than function
+ * tracing and needs no special build.
+ */
+
+#include <common.h>
+#include <command.h>
+#include <malloc.h>
+#include <os.h>
+#include <trace.h>
+#include <asm/sections.h>
+
+/* Number of samples to keep; older samples are overwritten */
+#ifndef CONFIG_PROFILE_SAMPLES
+#define CONFIG_PROFILE_SAMPLES	10000
+#endif
+
+/* Maximum number of functions to record in each sample */
+#define PROFILE_DEPTH		32
+
+/* Default time between samples in microseconds */
+#define PROFILE_INTERVAL_US	1000
+
+static uintptr_t *prof_buf;		/* Sample buffer */
+static unsigned long prof_count;	/* Samples taken in the last run */
+static int prof_running;
+
+static int do_profile_start(cmd_tbl_t *cmdtp, int flag, int argc,
+			    char * const argv[])
+{
+	int interval_us = PROFILE_INTERVAL_US;
+
+	if (prof_running) {
+		printf("Profiler already running\n");
+		return 1;
+	}
+	if (argc > 1) {
+		interval_us = simple_strtoul(argv[1], NULL, 10);
+		if (interval_us <= 0)
+			return CMD_RET_USAGE;
+	}
+	if (!prof_buf) {
+		prof_buf = malloc(CONFIG_PROFILE_SAMPLES * (PROFILE_DEPTH + 1) *
+				  sizeof(uintptr_t));
+		if (!prof_buf) {
+			printf("Out of memory\n");
+			return 1;
+		}
+	}
+	if (os_profile_start(prof_buf, CONFIG_PROFILE_SAMPLES, PROFILE_DEPTH,
+			     interval_us)) {
+		printf("Cannot start profiler\n");
+		return 1;
+	}
+	prof_running = 1;
+
+	return 0;
+}
+
+static int do_profile_stop(cmd_tbl_t *cmdtp, int flag, int argc,
+			   char * const argv[])
+{
+	if (!prof_running) {
+		printf("Profiler not running\n");
+		return 1;
+	}
+	prof_count = os_profile_stop();
+	prof_running = 0;
+	printf("%lu samples", prof_count);
+	if (prof_count > CONFIG_PROFILE_SAMPLES)
+		printf(" (%lu oldest dropped)",
+		       prof_count - CONFIG_PROFILE_SAMPLES);
+	printf("\n");
+
+	return 0;
+}
+
+/* Write the samples to a file in the same format as 'trace calls' */
+static int do_profile_save(cmd_tbl_t *cmdtp, int flag, int argc,
+			   char * const argv[])
+{
+	struct trace_output_hdr hdr;
+	unsigned long first, i;
+	uint32_t rec[PROFILE_DEPTH + 1];
+	uintptr_t *sample;
+	int count, fd, j;
+
+	if (argc < 2)
+		return CMD_RET_USAGE;
+	if (prof_running) {
+		printf("Stop the profiler first\n");
+		return 1;
+	}
+	fd = os_open(argv[1], OS_O_WRONLY | OS_O_CREAT | OS_O_TRUNC);
+	if (fd < 0) {
+		printf("Cannot open '%s'\n", argv[1]);
+		return 1;
+	}
+
+	first = 0;
+	if (prof_count > CONFIG_PROFILE_SAMPLES)
+		first = prof_count - CONFIG_PROFILE_SAMPLES;
+	hdr.type = TRACE_CHUNK_SAMPLES;
+	hdr.rec_count = prof_count - first;
+	os_write(fd, &hdr, sizeof(hdr));
+
+	/* Write each sample as offsets from the start of U-Boot's text */
+	for (i = first; i < prof_count; i++) {
+		sample = prof_buf + (i % CONFIG_PROFILE_SAMPLES) *
+				(PROFILE_DEPTH + 1);
+		count = sample[0];
+		rec[0] = count;
+		for (j = 0; j < count; j++)
+			rec[j + 1] = sample[j + 1] - (uintptr_t)&_init;
+		os_write(fd, rec, (count + 1) * sizeof(uint32_t));
+	}
+	os_close(fd);
+	printf("%u samples written to '%s'\n", hdr.rec_count, argv[1]);
+
+	return 0;
+}
+
+static cmd_tbl_t cmd_profile_sub[] = {
+	U_BOOT_CMD_MKENT(start, 2, 0, do_profile_start, "", "")
+	U_BOOT_CMD_MKENT(stop, 1, 0, do_profile_stop, "", "")
+	U_BOOT_CMD_MKENT(save, 2, 0, do_profile_save, "", "")
+};
+
+static int do_profile(cmd_tbl_t *cmdtp, int flag, int argc,
+		      char * const argv[])
+{
+	cmd_tbl_t *c;
+
+	if (argc < 2)
+		return CMD_RET_USAGE;
+
+	/* Strip off leading 'profile' command argument */
+	argc--;
+	argv++;
+
+	c = find_cmd_tbl(argv[0], cmd_profile_sub,
+			 ARRAY_SIZE(cmd_profile_sub));
+	if (c)
+		return c->cmd(cmdtp, flag, argc, argv);
+	else
+		return CMD_RET_USAGE;
+}
+
+U_BOOT_CMD(
+	profile,	3,	0,	do_profile,
+	"sampling profiler",
+	"start [<interval_us>]  - start taking samples\n"
+	"profile stop                   - stop taking samples\n"
+	"profile save <file>            - save samples for proftool"
+);
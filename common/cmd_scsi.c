@@ -435,6 +435,7 @@ static ulong scsi_write(int device, ulong blknr,
 	unsigned short smallblks;
 	ccb* pccb = (ccb *)&tempccb;
 	device &= 0xff;
+	part_efi_note_write(&scsi_dev_desc[device], blknr, blkcnt);
 	/* Setup  device
 	 */
 	pccb->target = scsi_dev_desc[device].target;
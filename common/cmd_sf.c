@@ -133,43 +133,12 @@ static int do_spi_flash_probe(int argc, char * const argv[])
 	return 0;
 }
 
-/**
- * Write a block of data to SPI flash, first checking if it is different from
- * what is already there.
- *
- * If the data being written is the same, then *skipped is incremented by len.
- *
- * @param flash		flash context pointer
- * @param offset	flash offset to write
- * @param len		number of bytes to write
- * @param buf		buffer to write from
- * @param cmp_buf	read buffer to use to compare data
- * @param skipped	Count of skipped data (incremented by this function)
- * @return NULL if OK, else a string containing the stage which failed
- */
-static const char *spi_flash_update_block(struct spi_flash *flash, u32 offset,
-		size_t len, const char *buf, char *cmp_buf, size_t *skipped)
-{
-	debug("offset=%#x, sector_size=%#x, len=%#zx\n",
-		offset, flash->sector_size, len);
-	if (spi_flash_read(flash, offset, len, cmp_buf))
-		return "read";
-	if (memcmp(cmp_buf, buf, len) == 0) {
-		debug("Skip region %x size %zx: no change\n",
-			offset, len);
-		*skipped += len;
-		return NULL;
-	}
-	if (spi_flash_erase(flash, offset, len))
-		return "erase";
-	if (spi_flash_write(flash, offset, len, buf))
-		return "write";
-	return NULL;
-}
+/* Amount to update between progress reports */
+#define SF_UPDATE_CHUNK		(64 << 10)
 
 /**
- * Update an area of SPI flash by erasing and writing any blocks which need
- * to change. Existing blocks with the correct data are left unchanged.
+ * Update an area of SPI flash, erasing and programming only what needs to
+ * change. Existing blocks with the correct data are left unchanged.
  *
  * @param flash		flash context pointer
  * @param offset	flash offset to write
@@ -177,52 +146,41 @@ static const char *spi_flash_update_block(struct spi_flash *flash, u32 offset,
  * @param buf		buffer to write from
  * @return 0 if ok, 1 on error
  */
-static int spi_flash_update(struct spi_flash *flash, u32 offset,
-		size_t len, const char *buf)
+static int sf_update(struct spi_flash *flash, u32 offset, size_t len,
+		     const char *buf)
 {
-	const char *err_oper = NULL;
-	char *cmp_buf;
-	const char *end = buf + len;
-	size_t todo;		/* number of bytes to do in this pass */
-	size_t skipped = 0;	/* statistics */
+	struct spi_flash_update_stats stats;
 	const ulong start_time = get_timer(0);
-	size_t scale = 1;
-	const char *start_buf = buf;
+	ulong last_update = start_time;
+	size_t done, todo;
 	ulong delta;
 
-	if (end - buf >= 200)
-		scale = (end - buf) / 100;
-	cmp_buf = malloc(flash->sector_size);
-	if (cmp_buf) {
-		ulong last_update = get_timer(0);
-
-		for (; buf < end && !err_oper; buf += todo, offset += todo) {
-			todo = min(end - buf, flash->sector_size);
-			if (get_timer(last_update) > 100) {
-				printf("   \rUpdating, %zu%% %lu B/s",
-					100 - (end - buf) / scale,
-					bytes_per_second(buf - start_buf,
-							 start_time));
-				last_update = get_timer(0);
-			}
-			err_oper = spi_flash_update_block(flash, offset, todo,
-					buf, cmp_buf, &skipped);
+	memset(&stats, '\0', sizeof(stats));
+	for (done = 0; done < len; done += todo) {
+		/* Keep chunks aligned so that 64KB blocks can be erased */
+		todo = min(len - done, SF_UPDATE_CHUNK -
+			   (offset + done) % SF_UPDATE_CHUNK);
+		if (get_timer(last_update) > 100) {
+			printf("   \rUpdating, %zu%% %lu B/s",
+			       done * 100 / len,
+			       bytes_per_second(done, start_time));
+			last_update = get_timer(0);
+		}
+		if (spi_flash_update(flash, offset + done, todo, buf + done,
+				     &stats)) {
+			putc('\r');
+			printf("SPI flash update failed at %#zx\n",
+			       offset + done);
+			return 1;
 		}
-	} else {
-		err_oper = "malloc";
 	}
-	free(cmp_buf);
 	putc('\r');
-	if (err_oper) {
-		printf("SPI flash failed in %s step\n", err_oper);
-		return 1;
-	}
 
 	delta = get_timer(start_time);
-	printf("%zu bytes written, %zu bytes skipped", len - skipped,
-		skipped);
-	printf(" in %ld.%lds, speed %ld B/s\n",
-		delta / 1000, delta % 1000, bytes_per_second(len, start_time));
+	printf("%zu bytes erased, %zu bytes programmed, %zu bytes unchanged",
+	       stats.erased, stats.programmed, stats.unchanged);
+	printf(" in %ld.%03lds, speed %ld B/s\n",
+	       delta / 1000, delta % 1000, bytes_per_second(len, start_time));
 
 	return 0;
 }
@@ -263,7 +221,7 @@ static int do_spi_flash_read_write(int argc, char * const argv[])
 	}
 
 	if (strcmp(argv[0], "update") == 0)
-		ret = spi_flash_update(flash, offset, len, buf);
+		ret = sf_update(flash, offset, len, buf);
 	else if (strcmp(argv[0], "read") == 0)
 		ret = spi_flash_read(flash, offset, len, buf);
 	else
@@ -283,6 +241,7 @@ static int do_spi_flash_erase(int argc, char * const argv[])
 {
 	unsigned long offset;
 	unsigned long len;
+	ulong start_ms, delta;
 	char *endp;
 	int ret;
 
@@ -304,11 +263,16 @@ static int do_spi_flash_erase(int argc, char * const argv[])
 		return 1;
 	}
 
+	start_ms = get_timer(0);
 	ret = spi_flash_erase(flash, offset, len);
 	if (ret) {
 		printf("SPI flash %s failed\n", argv[0]);
 		return 1;
 	}
+	delta = get_timer(start_ms);
+	printf("SF: %lu bytes @ %#lx erased in %ld.%03lds, speed %lu B/s\n",
+	       len, offset, delta / 1000, delta % 1000,
+	       bytes_per_second(len, start_ms));
 
 	return 0;
 }
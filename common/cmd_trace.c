@@ -111,8 +111,20 @@ int do_trace(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 		if (create_func_list(argc, argv))
 			return cmd_usage(cmdtp);
 		break;
+#ifdef CONFIG_TRACE_DRAIN
+	case 'd':
+		if (trace_drain()) {
+			printf("Trace drain failed\n");
+			return 1;
+		}
+		break;
+#endif
 	case 's':
 		trace_print_stats();
+#ifdef CONFIG_TRACE_STATS
+		trace_print_top(argc > 2 ? simple_strtoul(argv[2], NULL, 10) :
+				20);
+#endif
 		break;
 	default:
 		return CMD_RET_USAGE;
@@ -124,10 +136,13 @@ int do_trace(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 U_BOOT_CMD(
 	trace,	4,	1,	do_trace,
 	"trace utility commands",
-	"stats                        - display tracing statistics\n"
+	"stats [<count>]              - display tracing statistics\n"
 	"trace pause                        - pause tracing\n"
 	"trace resume                       - resume tracing\n"
 	"trace funclist [<addr> <size>]     - dump function list into buffer\n"
 	"trace calls  [<addr> <size>]       "
 		"- dump function call trace into buffer"
+#ifdef CONFIG_TRACE_DRAIN
+	"\ntrace drain                        - drain buffered calls"
+#endif
 );
@@ -21,6 +21,7 @@
 #include <linux/mtd/partitions.h>
 #include <ubi_uboot.h>
 #include <asm/errno.h>
+#include <asm/io.h>
 #include <jffs2/load_kernel.h>
 
 #undef ubi_msg
@@ -318,7 +319,7 @@ int ubi_volume_read(char *volume, char *buf, size_t size)
 {
 	int err, lnum, off, len, tbuf_size;
 	void *tbuf;
-	unsigned long long tmp;
+	uint64_t tmp;
 	struct ubi_volume *vol;
 	loff_t offp = 0;
 
@@ -500,6 +501,7 @@ static int do_ubi(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
 	size_t size = 0;
 	ulong addr = 0;
+	void *buf;
 
 	if (argc < 2)
 		return CMD_RET_USAGE;
@@ -564,7 +566,7 @@ static int do_ubi(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 		/* Use maximum available size */
 		if (!size) {
 			size = ubi->avail_pebs * ubi->leb_size;
-			printf("No size specified -> Using max size (%u)\n", size);
+			printf("No size specified -> Using max size (%zu)\n", size);
 		}
 		/* E.g., create volume */
 		if (argc == 3)
@@ -588,9 +590,11 @@ static int do_ubi(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 		addr = simple_strtoul(argv[2], NULL, 16);
 		size = simple_strtoul(argv[4], NULL, 16);
 
-		ret = ubi_volume_write(argv[3], (void *)addr, size);
+		buf = map_sysmem(addr, size);
+		ret = ubi_volume_write(argv[3], buf, size);
+		unmap_sysmem(buf);
 		if (!ret) {
-			printf("%d bytes written to volume %s\n", size,
+			printf("%zu bytes written to volume %s\n", size,
 			       argv[3]);
 		}
 
@@ -613,10 +617,16 @@ static int do_ubi(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 		}
 
 		if (argc == 3) {
-			printf("Read %d bytes from volume %s to %lx\n", size,
+			int ret;
+
+			printf("Read %zu bytes from volume %s to %lx\n", size,
 			       argv[3], addr);
 
-			return ubi_volume_read(argv[3], (char *)addr, size);
+			buf = map_sysmem(addr, size);
+			ret = ubi_volume_read(argv[3], buf, size);
+			unmap_sysmem(buf);
+
+			return ret;
 		}
 	}
 
@@ -27,6 +27,7 @@
 
 #include <common.h>
 #include <command.h>
+#include <malloc.h>
 #include <linux/ctype.h>
 
 /*
@@ -137,10 +138,97 @@ cmd_tbl_t *find_cmd_tbl (const char *cmd, cmd_tbl_t *table, int table_len)
 	return NULL;	/* not found or ambiguous command */
 }
 
+#ifdef CONFIG_SYS_CMD_LOOKUP_HASH
+struct cmd_hash_entry {
+	uint hash;		/* Hash of the command name */
+	cmd_tbl_t *cmdtp;	/* Command, or NULL if this slot is empty */
+};
+
+/* Open-addressed hash of the command table, built by cmd_hash_build() */
+static struct cmd_hash_entry *cmd_hash;
+static uint cmd_hash_mask;
+
+/* FNV-1a hash of the first len characters of a command name */
+static uint cmd_hash_name(const char *name, int len)
+{
+	uint hash = 2166136261u;
+
+	while (len--)
+		hash = (hash ^ (uchar)*name++) * 16777619;
+
+	return hash;
+}
+
+int cmd_hash_build(void)
+{
+	cmd_tbl_t *start = ll_entry_start(cmd_tbl_t, cmd);
+	const int count = ll_entry_count(cmd_tbl_t, cmd);
+	struct cmd_hash_entry *entry;
+	cmd_tbl_t *cmdtp;
+	uint size, idx;
+
+	/* Keep the table at most half full so that probe chains are short */
+	for (size = 16; size < count * 2; size <<= 1)
+		;
+	free(cmd_hash);
+	cmd_hash = calloc(size, sizeof(*cmd_hash));
+	if (!cmd_hash)
+		return -1;
+	cmd_hash_mask = size - 1;
+
+	/* Insert in table order, so a duplicate name finds the first entry */
+	for (cmdtp = start; cmdtp != start + count; cmdtp++) {
+		uint hash = cmd_hash_name(cmdtp->name, strlen(cmdtp->name));
+
+		for (idx = hash & cmd_hash_mask; cmd_hash[idx].cmdtp;
+		     idx = (idx + 1) & cmd_hash_mask)
+			;
+		entry = &cmd_hash[idx];
+		entry->hash = hash;
+		entry->cmdtp = cmdtp;
+	}
+
+	return 0;
+}
+
+/* Look up a command by its full name, ignoring any '.' suffix */
+static cmd_tbl_t *cmd_hash_find(const char *cmd)
+{
+	struct cmd_hash_entry *entry;
+	const char *p;
+	uint hash, idx;
+	int len;
+
+	p = strchr(cmd, '.');
+	len = p ? p - cmd : strlen(cmd);
+	hash = cmd_hash_name(cmd, len);
+	for (idx = hash & cmd_hash_mask; cmd_hash[idx].cmdtp;
+	     idx = (idx + 1) & cmd_hash_mask) {
+		entry = &cmd_hash[idx];
+		if (entry->hash == hash &&
+		    !strncmp(cmd, entry->cmdtp->name, len) &&
+		    !entry->cmdtp->name[len])
+			return entry->cmdtp;
+	}
+
+	return NULL;
+}
+#endif
+
 cmd_tbl_t *find_cmd (const char *cmd)
 {
 	cmd_tbl_t *start = ll_entry_start(cmd_tbl_t, cmd);
 	const int len = ll_entry_count(cmd_tbl_t, cmd);
+
+#ifdef CONFIG_SYS_CMD_LOOKUP_HASH
+	/* Abbreviations and unknown commands still need the full search */
+	if (cmd_hash && cmd) {
+		cmd_tbl_t *cmdtp = cmd_hash_find(cmd);
+
+		if (cmdtp)
+			return cmdtp;
+	}
+#endif
 	return find_cmd_tbl(cmd, start, len);
 }
 
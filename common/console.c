@@ -22,6 +22,7 @@
  */
 
 #include <common.h>
+#include <console_log.h>
 #include <fdtdec.h>
 #include <stdarg.h>
 #include <malloc.h>
@@ -499,6 +500,7 @@ void putc(const char c)
 		return;
 	}
 #endif
+	console_log_putc(c);
 
 #ifdef CONFIG_SILENT_CONSOLE
 	if (gd->flags & GD_FLG_SILENT)
@@ -537,6 +539,7 @@ void puts(const char *s)
 		return;
 	}
 #endif
+	console_log_puts(s);
 
 #ifdef CONFIG_SILENT_CONSOLE
 	if (gd->flags & GD_FLG_SILENT)
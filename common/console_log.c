@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2013 The Chromium OS Authors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+/*
+ * Console output is recorded in memory reserved at the top of RAM, which
+ * is handed to the OS at boot. This lets the OS show what U-Boot printed
+ * even when the console was silent. The log is set up before relocation,
+ * so it must not use BSS or data; all state is in the log header.
+ */
+
+#include <common.h>
+#include <console_log.h>
+#include <errno.h>
+#include <fdt_support.h>
+#include <libfdt.h>
+#include <asm/io.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+int console_log_init(void *buf, ulong size)
+{
+	struct console_log_hdr *hdr = buf;
+
+	if (size <= sizeof(*hdr))
+		return -EINVAL;
+	hdr->magic = CONSOLE_LOG_MAGIC;
+	hdr->size = size - sizeof(*hdr);
+	hdr->next = 0;
+	hdr->flags = 0;
+	gd->console_log = hdr;
+
+	return 0;
+}
+
+static void log_char(struct console_log_hdr *hdr, const char c)
+{
+	char *text = (char *)(hdr + 1);
+
+	text[hdr->next++] = c;
+	if (hdr->next == hdr->size) {
+		hdr->next = 0;
+		hdr->flags |= CONSOLE_LOG_WRAPPED;
+	}
+}
+
+void console_log_putc(const char c)
+{
+	struct console_log_hdr *hdr = gd->console_log;
+	char stamp[24];
+	ulong us;
+	char *p;
+
+	if (!hdr)
+		return;
+	if (!(hdr->flags & CONSOLE_LOG_IN_LINE)) {
+		us = timer_get_us();
+		sprintf(stamp, "[%5lu.%06lu] ", us / 1000000, us % 1000000);
+		for (p = stamp; *p; p++)
+			log_char(hdr, *p);
+		hdr->flags |= CONSOLE_LOG_IN_LINE;
+	}
+	log_char(hdr, c);
+	if (c == '\n')
+		hdr->flags &= ~CONSOLE_LOG_IN_LINE;
+}
+
+void console_log_puts(const char *s)
+{
+	if (!gd->console_log)
+		return;
+	while (*s)
+		console_log_putc(*s++);
+}
+
+int console_log_fdt_setup(void *blob, struct lmb *lmb)
+{
+	struct console_log_hdr *hdr = gd->console_log;
+	u8 reg[16];
+	ulong addr, size;
+	int node, ret, len;
+
+	if (!hdr)
+		return 0;
+	addr = map_to_sysmem(hdr);
+	size = sizeof(*hdr) + hdr->size;
+	len = fdt_pack_reg(blob, reg, addr, size);
+	if (len < 0)
+		return len;
+	lmb_reserve(lmb, addr, size);
+	ret = fdt_add_mem_rsv(blob, addr, size);
+	if (ret)
+		return ret;
+
+	node = fdt_ensure_chosen(blob);
+	if (node < 0)
+		return node;
+	node = fdt_ensure_subnode(blob, node, "u-boot-console-log");
+	if (node < 0)
+		return node;
+	ret = fdt_setprop_string(blob, node, "compatible",
+				 "u-boot,console-log");
+	if (!ret)
+		ret = fdt_setprop(blob, node, "reg", reg, len);
+
+	return ret;
+}
@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2013 The Chromium OS Authors.
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#include <common.h>
+#include <cpu_work.h>
+#include <linux/compiler.h>
+
+/* Time to wait for a secondary CPU to come up or go down */
+#define CPU_WORK_TIMEOUT_MS	100
+
+/*
+ * Each secondary CPU has a mailbox. The boot CPU fills in @work and the
+ * secondary CPU clears it once the work is complete.
+ */
+struct cpu_work_slot {
+	struct cpu_work *volatile work;
+	volatile int online;
+};
+
+/* Special work item used to ask a secondary CPU to stop */
+static struct cpu_work cpu_work_stop;
+
+static struct cpu_work_slot cpu_work_slot[CONFIG_CPU_WORK_MAX_CPUS];
+static int cpu_work_cpus;	/* Number of CPUs running, 0 if not inited */
+
+int __weak cpu_work_arch_num_cpus(void)
+{
+	return 1;
+}
+
+int __weak cpu_work_arch_start(int cpu)
+{
+	return -1;
+}
+
+void __weak cpu_work_arch_stop(int cpu)
+{
+	hang();
+}
+
+int __weak cpu_work_arch_stopped(int cpu)
+{
+	return 1;
+}
+
+void __weak cpu_work_arch_notify(void)
+{
+}
+
+void __weak cpu_work_arch_wait(void)
+{
+}
+
+void cpu_work_secondary_loop(int cpu)
+{
+	struct cpu_work_slot *slot = &cpu_work_slot[cpu];
+	struct cpu_work *work;
+
+	slot->online = 1;
+	cpu_work_arch_notify();
+	for (;;) {
+		work = slot->work;
+		if (!work) {
+			cpu_work_arch_wait();
+			continue;
+		}
+		if (work == &cpu_work_stop)
+			break;
+		work->ret = work->func(work->arg);
+		cpu_work_arch_notify();
+		slot->work = NULL;
+		work->done = 1;
+		cpu_work_arch_notify();
+	}
+
+	slot->online = 0;
+	slot->work = NULL;
+	cpu_work_arch_notify();
+	cpu_work_arch_stop(cpu);
+	hang();
+}
+
+int cpu_work_init(void)
+{
+	int num_cpus;
+	ulong start;
+	int cpu;
+
+	if (cpu_work_cpus)
+		return cpu_work_cpus;
+
+	num_cpus = min(cpu_work_arch_num_cpus(), CONFIG_CPU_WORK_MAX_CPUS);
+	cpu_work_cpus = 1;
+	for (cpu = 1; cpu < num_cpus; cpu++) {
+		if (cpu_work_arch_start(cpu)) {
+			debug("%s: CPU %d failed to start\n", __func__, cpu);
+			continue;
+		}
+		start = get_timer(0);
+		while (!cpu_work_slot[cpu].online) {
+			if (get_timer(start) > CPU_WORK_TIMEOUT_MS) {
+				printf("CPU %d did not come online\n", cpu);
+				break;
+			}
+		}
+		if (cpu_work_slot[cpu].online)
+			cpu_work_cpus++;
+	}
+	debug("%s: %d CPUs available for work\n", __func__, cpu_work_cpus);
+
+	return cpu_work_cpus;
+}
+
+void cpu_work_shutdown(void)
+{
+	struct cpu_work_slot *slot;
+	ulong start;
+	int cpu;
+
+	if (cpu_work_cpus <= 1)
+		return;
+
+	for (cpu = 1; cpu < CONFIG_CPU_WORK_MAX_CPUS; cpu++) {
+		slot = &cpu_work_slot[cpu];
+		if (!slot->online)
+			continue;
+		while (slot->work)
+			cpu_work_arch_wait();
+		slot->work = &cpu_work_stop;
+		cpu_work_arch_notify();
+		start = get_timer(0);
+		while (slot->online || !cpu_work_arch_stopped(cpu)) {
+			if (get_timer(start) > CPU_WORK_TIMEOUT_MS) {
+				printf("CPU %d did not stop\n", cpu);
+				break;
+			}
+		}
+	}
+	cpu_work_cpus = 0;
+}
+
+void cpu_work_post(struct cpu_work *work)
+{
+	struct cpu_work_slot *slot;
+	int cpu;
+
+	cpu_work_init();
+	work->done = 0;
+	for (cpu = 1; cpu < CONFIG_CPU_WORK_MAX_CPUS; cpu++) {
+		slot = &cpu_work_slot[cpu];
+		if (slot->online && !slot->work) {
+			slot->work = work;
+			cpu_work_arch_notify();
+			return;
+		}
+	}
+
+	/* Nobody is free, so do it ourselves */
+	work->ret = work->func(work->arg);
+	work->done = 1;
+}
+
+int cpu_work_wait(struct cpu_work *work)
+{
+	while (!work->done)
+		cpu_work_arch_wait();
+
+	return work->ret;
+}
+
+int cpu_work_run(struct cpu_work *work, int count)
+{
+	int ret = 0;
+	int i;
+
+	for (i = 0; i < count; i++)
+		cpu_work_post(&work[i]);
+	for (i = 0; i < count; i++) {
+		cpu_work_wait(&work[i]);
+		if (work[i].ret && !ret)
+			ret = work[i].ret;
+	}
+
+	return ret;
+}
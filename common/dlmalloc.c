@@ -930,7 +930,7 @@ struct mallinfo mALLINFo();
 #endif	/* 0 */			/* Moved to malloc.h */
 
 #include <malloc.h>
-#ifdef DEBUG
+#if defined(DEBUG) || defined(CONFIG_CMD_MALLOC)
 #if __STD_C
 static void malloc_update_mallinfo (void);
 void malloc_stats (void);
@@ -938,7 +938,7 @@ void malloc_stats (void);
 static void malloc_update_mallinfo ();
 void malloc_stats();
 #endif
-#endif	/* DEBUG */
+#endif	/* DEBUG || CONFIG_CMD_MALLOC */
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -1501,6 +1501,12 @@ ulong mem_malloc_start = 0;
 ulong mem_malloc_end = 0;
 ulong mem_malloc_brk = 0;
 
+/*
+ * The variables above are in .bss, which on ARM overlays the relocation
+ * data until U-Boot has relocated, so check gd instead.
+ */
+#define MALLOC_READY()	(gd->flags & GD_FLG_FULL_MALLOC_INIT)
+
 void *sbrk(ptrdiff_t increment)
 {
 	ulong old = mem_malloc_brk;
@@ -1530,6 +1536,7 @@ void mem_malloc_init(ulong start, ulong size)
 	memset((void *)mem_malloc_start, 0, size);
 
 	malloc_bin_reloc();
+	gd->flags |= GD_FLG_FULL_MALLOC_INIT;
 }
 
 /* field-extraction macros */
@@ -1619,9 +1626,9 @@ static struct mallinfo current_mallinfo = {  0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
 
 /* Tracking mmaps */
 
-#ifdef DEBUG
+#if defined(DEBUG) || defined(CONFIG_CMD_MALLOC)
 static unsigned int n_mmaps = 0;
-#endif	/* DEBUG */
+#endif	/* DEBUG || CONFIG_CMD_MALLOC */
 static unsigned long mmapped_mem = 0;
 #if HAVE_MMAP
 static unsigned int max_n_mmaps = 0;
@@ -2175,9 +2182,13 @@ Void_t* mALLOc(bytes) size_t bytes;
   INTERNAL_SIZE_T nb;
 
   /* check if mem_malloc_init() was run */
-  if ((mem_malloc_start == 0) && (mem_malloc_end == 0)) {
+  if (!MALLOC_READY()) {
     /* not initialized yet */
+#ifdef CONFIG_SYS_MALLOC_F
+    return malloc_simple(bytes);
+#else
     return NULL;
+#endif
   }
 
   if ((long)bytes < 0) return NULL;
@@ -2440,6 +2451,14 @@ void fREe(mem) Void_t* mem;
   if (mem == NULL)                              /* free(0) has no effect */
     return;
 
+#ifdef CONFIG_SYS_MALLOC_F
+  /* memory from the pre-relocation heap is never freed */
+  if (malloc_simple_owns(mem))
+    return;
+#endif
+  if (!MALLOC_READY())
+    return;
+
   p = mem2chunk(mem);
   hd = p->size;
 
@@ -2588,6 +2607,23 @@ Void_t* rEALLOc(oldmem, bytes) Void_t* oldmem; size_t bytes;
   /* realloc of null is supposed to be same as malloc */
   if (oldmem == NULL) return mALLOc(bytes);
 
+#ifdef CONFIG_SYS_MALLOC_F
+  /*
+   * The size of memory from the pre-relocation heap is not recorded, so
+   * copy as much as could have been allocated.
+   */
+  if (malloc_simple_owns(oldmem)) {
+    ulong avail = gd->malloc_base + gd->malloc_limit - (ulong)oldmem;
+
+    newmem = mALLOc(bytes);
+    if (newmem)
+      memmove(newmem, oldmem, min(bytes, (size_t)avail));
+    return newmem;
+  }
+#endif
+  if (!MALLOC_READY())
+    return NULL;
+
   newp    = oldp    = mem2chunk(oldmem);
   newsize = oldsize = chunksize(oldp);
 
@@ -2789,6 +2825,14 @@ Void_t* mEMALIGn(alignment, bytes) size_t alignment; size_t bytes;
 
   if ((long)bytes < 0) return NULL;
 
+  if (!MALLOC_READY()) {
+#ifdef CONFIG_SYS_MALLOC_F
+    return memalign_simple(alignment, bytes);
+#else
+    return NULL;
+#endif
+  }
+
   /* If need less alignment than we give anyway, just relay to malloc */
 
   if (alignment <= MALLOC_ALIGNMENT) return mALLOc(bytes);
@@ -2933,6 +2977,13 @@ Void_t* cALLOc(n, elem_size) size_t n; size_t elem_size;
     return NULL;
   else
   {
+#ifdef CONFIG_SYS_MALLOC_F
+    /* memory from the pre-relocation heap is not a chunk */
+    if (malloc_simple_owns(mem)) {
+      MALLOC_ZERO(mem, sz);
+      return mem;
+    }
+#endif
     p = mem2chunk(mem);
 
     /* Two optional cases in which clearing not necessary */
@@ -3096,7 +3147,7 @@ size_t malloc_usable_size(mem) Void_t* mem;
 
 /* Utility to update current_mallinfo for malloc_stats and mallinfo() */
 
-#ifdef DEBUG
+#if defined(DEBUG) || defined(CONFIG_CMD_MALLOC)
 static void malloc_update_mallinfo()
 {
   int i;
@@ -3132,9 +3183,10 @@ static void malloc_update_mallinfo()
   current_mallinfo.hblks = n_mmaps;
   current_mallinfo.hblkhd = mmapped_mem;
   current_mallinfo.keepcost = chunksize(top);
+  current_mallinfo.usmblks = max_total_mem;
 
 }
-#endif	/* DEBUG */
+#endif	/* DEBUG || CONFIG_CMD_MALLOC */
 
 
 
@@ -3153,7 +3205,7 @@ static void malloc_update_mallinfo()
 
 */
 
-#ifdef DEBUG
+#if defined(DEBUG) || defined(CONFIG_CMD_MALLOC)
 void malloc_stats()
 {
   malloc_update_mallinfo();
@@ -3168,19 +3220,19 @@ void malloc_stats()
 	  (unsigned int)max_n_mmaps);
 #endif
 }
-#endif	/* DEBUG */
+#endif	/* DEBUG || CONFIG_CMD_MALLOC */
 
 /*
   mallinfo returns a copy of updated current mallinfo.
 */
 
-#ifdef DEBUG
+#if defined(DEBUG) || defined(CONFIG_CMD_MALLOC)
 struct mallinfo mALLINFo()
 {
   malloc_update_mallinfo();
   return current_mallinfo;
 }
-#endif	/* DEBUG */
+#endif	/* DEBUG || CONFIG_CMD_MALLOC */
 
 
 
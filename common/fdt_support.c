@@ -380,6 +380,20 @@ static void write_cell(u8 *addr, u64 val, int size)
 	}
 }
 
+int fdt_pack_reg(void *blob, u8 *buf, u64 address, u64 size)
+{
+	int addr_cell_len = get_cells_len(blob, "#address-cells");
+	int size_cell_len = get_cells_len(blob, "#size-cells");
+
+	if ((addr_cell_len == 4 && address >> 32) ||
+	    (size_cell_len == 4 && size >> 32))
+		return -FDT_ERR_NOSPACE;
+	write_cell(buf, address, addr_cell_len);
+	write_cell(buf + addr_cell_len, size, size_cell_len);
+
+	return addr_cell_len + size_cell_len;
+}
+
 #ifdef CONFIG_NR_DRAM_BANKS
 #define MEMORY_BANKS_MAX CONFIG_NR_DRAM_BANKS
 #else
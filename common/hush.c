@@ -344,6 +344,9 @@ struct in_str {
 #endif
 	int (*get) (struct in_str *);
 	int (*peek) (struct in_str *);
+#ifdef CONFIG_HUSH_PARSE_CACHE
+	struct hush_cache *cache;	/* keep parsed lines here, or NULL */
+#endif
 };
 #define b_getch(input) ((input)->get(input))
 #define b_peek(input) ((input)->peek(input))
@@ -450,6 +453,9 @@ static int free_pipe(struct pipe *pi, int indent);
 static int setup_redirects(struct child_prog *prog, int squirrel[]);
 #endif
 static int run_list_real(struct pipe *pi);
+#ifdef CONFIG_HUSH_PARSE_CACHE
+static int run_list_timed(struct pipe *pi);
+#endif
 #ifndef __U_BOOT__
 static void pseudo_exec(struct child_prog *child) __attribute__ ((noreturn));
 #endif
@@ -1153,6 +1159,9 @@ static void setup_file_in_str(struct in_str *i)
 	i->file = f;
 #endif
 	i->p = NULL;
+#ifdef CONFIG_HUSH_PARSE_CACHE
+	i->cache = NULL;
+#endif
 }
 
 static void setup_string_in_str(struct in_str *i, const char *s)
@@ -1162,6 +1171,9 @@ static void setup_string_in_str(struct in_str *i, const char *s)
 	i->__promptme=1;
 	i->promptmode=1;
 	i->p = s;
+#ifdef CONFIG_HUSH_PARSE_CACHE
+	i->cache = NULL;
+#endif
 }
 
 #ifndef __U_BOOT__
@@ -1531,6 +1543,7 @@ static int run_pipe_real(struct pipe *pi)
 	struct child_prog *child;
 	struct built_in_command *x;
 	char *p;
+	int sp;
 # if __GNUC__
 	/* Avoid longjmp clobbering */
 	(void) &i;
@@ -1543,6 +1556,7 @@ static int run_pipe_real(struct pipe *pi)
 	int flag = do_repeat ? CMD_FLAG_REPEAT : 0;
 	struct child_prog *child;
 	char *p;
+	int sp;
 # if __GNUC__
 	/* Avoid longjmp clobbering */
 	(void) &i;
@@ -1609,6 +1623,8 @@ static int run_pipe_real(struct pipe *pi)
 			}
 			return EXIT_SUCCESS;   /* don't worry about errors in set_local_var() yet */
 		}
+		/* Count in sp, since a parsed pipe may be run again */
+		sp = child->sp;
 		for (i = 0; is_assignment(child->argv[i]); i++) {
 			p = insert_var_value(child->argv[i]);
 #ifndef __U_BOOT__
@@ -1617,11 +1633,11 @@ static int run_pipe_real(struct pipe *pi)
 			set_local_var(p, 0);
 #endif
 			if (p != child->argv[i]) {
-				child->sp--;
+				sp--;
 				free(p);
 			}
 		}
-		if (child->sp) {
+		if (sp) {
 			char * str = NULL;
 
 			str = make_string((child->argv + i));
@@ -1753,6 +1769,7 @@ static int run_list_real(struct pipe *pi)
 	char *save_name = NULL;
 	char **list = NULL;
 	char **save_list = NULL;
+	struct pipe *loop_pi = NULL;
 	struct pipe *rpipe;
 	int flag_rep = 0;
 #ifndef __U_BOOT__
@@ -1792,7 +1809,8 @@ static int run_list_real(struct pipe *pi)
 				/* check Ctrl-C */
 				ctrlc();
 				if ((had_ctrlc())) {
-					return 1;
+					rcode = 1;
+					goto out;
 				}
 #endif
 				flag_restore = 0;
@@ -1821,6 +1839,7 @@ static int run_list_real(struct pipe *pi)
 				list = make_list_in(pi->next->progs->argv,
 					pi->progs->argv[0]);
 				save_list = list;
+				loop_pi = pi;
 				save_name = pi->progs->argv[0];
 				pi->progs->argv[0] = NULL;
 				flag_rep = 1;
@@ -1892,7 +1911,8 @@ static int run_list_real(struct pipe *pi)
 #else
 		if (rcode < -1) {
 			last_return_code = -rcode - 2;
-			return -2;	/* exit */
+			rcode = -2;	/* exit */
+			goto out;
 		}
 		last_return_code=(rcode == 0) ? 0 : 1;
 #endif
@@ -1910,6 +1930,19 @@ static int run_list_real(struct pipe *pi)
 			skip_more_in_this_rmode=rmode;
 #ifndef __U_BOOT__
 		checkjobs(NULL);
+#endif
+	}
+out:
+	/* If we left a 'for' loop early, put back its variable name */
+	if (list) {
+		free(loop_pi->progs->argv[0]);
+		while (*list)
+			free(*list++);
+		free(save_list);
+		loop_pi->progs->argv[0] = save_name;
+#ifndef __U_BOOT__
+		loop_pi->progs->glob_result.gl_pathv[0] =
+			loop_pi->progs->argv[0];
 #endif
 	}
 	return rcode;
@@ -2010,7 +2043,11 @@ static int run_list(struct pipe *pi)
 #ifndef __U_BOOT__
 	if (fake_mode==0) {
 #endif
+#ifdef CONFIG_HUSH_PARSE_CACHE
+		rcode = run_list_timed(pi);
+#else
 		rcode = run_list_real(pi);
+#endif
 #ifndef __U_BOOT__
 	}
 #endif
@@ -3156,6 +3193,202 @@ static void update_ifs_map(void)
 	mapset(ifs, 2);            /* also flow through if quoted */
 }
 
+#ifdef CONFIG_HUSH_PARSE_CACHE
+#ifndef CONFIG_HUSH_PARSE_CACHE_SIZE
+#define CONFIG_HUSH_PARSE_CACHE_SIZE	16
+#endif
+
+/**
+ * An environment variable's script, parsed ready to run again
+ *
+ * @name:	Variable name, or NULL if this entry is not in use
+ * @text:	Script which was parsed, to check that it has not changed
+ * @flag:	Parser flags it was parsed with (FLAG_...)
+ * @error:	Non-zero if some of the script could not be parsed or run,
+ *		so the entry must not be used
+ * @busy:	Non-zero while the script is running. Running a pipe list
+ *		changes it temporarily (e.g. the 'for' loop variable), so a
+ *		script which runs itself must parse its own copy
+ * @line_count:	Number of lines in @line
+ * @line:	Pipe list for each line of the script
+ * @runs:	Number of times the parsed script has been reused
+ * @last_used:	Value of hush_cache_clock when last used, for eviction
+ */
+struct hush_cache {
+	char *name;
+	char *text;
+	int flag;
+	int error;
+	int busy;
+	int line_count;
+	struct pipe **line;
+	uint runs;
+	ulong last_used;
+};
+
+static struct hush_cache hush_cache[CONFIG_HUSH_PARSE_CACHE_SIZE];
+static ulong hush_cache_clock;
+
+/* Where the time goes, shown by 'hush stats' */
+static struct {
+	ulong parse_lines;	/* Lines parsed from strings */
+	ulong parse_us;		/* Time spent parsing them */
+	ulong run_lists;	/* Outermost pipe lists run */
+	ulong run_us;		/* Time spent running them, less parsing */
+	ulong hits;		/* Scripts run from the cache */
+	ulong misses;		/* Scripts which had to be parsed */
+} hush_stats;
+static int hush_run_depth;
+
+/* Run a pipe list, timing it if it is not part of another list */
+static int run_list_timed(struct pipe *pi)
+{
+	ulong start, parse_us;
+	int rcode;
+
+	if (hush_run_depth)
+		return run_list_real(pi);
+	hush_run_depth++;
+	start = timer_get_us();
+	parse_us = hush_stats.parse_us;
+	rcode = run_list_real(pi);
+	hush_stats.run_us += timer_get_us() - start -
+		(hush_stats.parse_us - parse_us);
+	hush_stats.run_lists++;
+	hush_run_depth--;
+
+	return rcode;
+}
+
+static void hush_cache_free(struct hush_cache *hc)
+{
+	int i;
+
+	for (i = 0; i < hc->line_count; i++)
+		free_pipe_list(hc->line[i], 0);
+	free(hc->line);
+	free(hc->name);
+	free(hc->text);
+	memset(hc, '\0', sizeof(*hc));
+}
+
+static void hush_cache_add_line(struct hush_cache *hc, struct pipe *pi)
+{
+	hc->line = xrealloc(hc->line, (hc->line_count + 1) * sizeof(pi));
+	hc->line[hc->line_count++] = pi;
+}
+
+/**
+ * Find the cache entry to use for a script
+ *
+ * @name:	Variable holding the script
+ * @s:		Script
+ * @flag:	Parser flags (FLAG_...)
+ * @return entry holding the parsed script, an empty entry to parse it
+ * into, or NULL if it cannot be cached
+ */
+static struct hush_cache *hush_cache_find(const char *name, const char *s,
+					  int flag)
+{
+	struct hush_cache *hc, *lru = NULL;
+
+	for (hc = hush_cache; hc < hush_cache + ARRAY_SIZE(hush_cache); hc++) {
+		if (hc->name && !strcmp(hc->name, name)) {
+			if (hc->busy)
+				return NULL;
+			if (hc->flag == flag && !strcmp(hc->text, s))
+				return hc;
+			/* The variable has changed, so parse it again */
+			hush_cache_free(hc);
+			return hc;
+		}
+		if (!hc->busy && (!lru || hc->last_used < lru->last_used))
+			lru = hc;
+	}
+	if (lru)
+		hush_cache_free(lru);
+
+	return lru;
+}
+
+/* Parse and run a script, keeping the parsed lines in the cache entry */
+static int hush_cache_record(struct hush_cache *hc, const char *name,
+			     const char *s, int flag)
+{
+	struct in_str input;
+	char *buf, *p;
+	int rcode;
+
+	hc->name = xmalloc(strlen(name) + 1);
+	strcpy(hc->name, name);
+	hc->text = xmalloc(strlen(s) + 1);
+	strcpy(hc->text, s);
+	hc->flag = flag;
+
+	/* Like parse_string_outer(), make sure there is a final newline */
+	buf = xmalloc(strlen(s) + 2);
+	strcpy(buf, s);
+	p = strchr(s, '\n');
+	if (!p || p[1])
+		strcat(buf, "\n");
+	setup_string_in_str(&input, buf);
+	input.cache = hc;
+	rcode = parse_stream_outer(&input, flag);
+	free(buf);
+	if (hc->error)
+		hush_cache_free(hc);
+
+	return rcode;
+}
+
+/* Run a script from the cache, just as parse_stream_outer() would */
+static int hush_cache_run(struct hush_cache *hc)
+{
+	int code = 0;
+	int i;
+
+	hc->runs++;
+	for (i = 0; i < hc->line_count; i++) {
+		code = run_list_timed(hc->line[i]);
+		if (code == -2) {	/* exit */
+			code = 0;
+			break;
+		}
+		if (code == -1)
+			flag_repeat = 0;
+	}
+
+	return (code != 0) ? 1 : 0;
+}
+
+int parse_var_outer(const char *name, const char *s, int flag)
+{
+	struct hush_cache *hc;
+	int rcode;
+
+	if (!s || !*s)
+		return 1;
+
+	/* IFS changes how scripts are parsed, so do not cache them */
+	hc = getenv("IFS") ? NULL : hush_cache_find(name, s, flag);
+	if (!hc)
+		return parse_string_outer(s, flag);
+
+	hc->busy++;
+	hc->last_used = ++hush_cache_clock;
+	if (hc->name) {
+		hush_stats.hits++;
+		rcode = hush_cache_run(hc);
+	} else {
+		hush_stats.misses++;
+		rcode = hush_cache_record(hc, name, s, flag);
+	}
+	hc->busy--;
+
+	return rcode;
+}
+#endif /* CONFIG_HUSH_PARSE_CACHE */
+
 /* most recursion does not come through here, the exeception is
  * from builtin_source() */
 static int parse_stream_outer(struct in_str *inp, int flag)
@@ -3166,6 +3399,9 @@ static int parse_stream_outer(struct in_str *inp, int flag)
 	int rcode;
 #ifdef __U_BOOT__
 	int code = 0;
+#endif
+#ifdef CONFIG_HUSH_PARSE_CACHE
+	ulong start;
 #endif
 	do {
 		ctx.type = flag;
@@ -3173,7 +3409,17 @@ static int parse_stream_outer(struct in_str *inp, int flag)
 		update_ifs_map();
 		if (!(flag & FLAG_PARSE_SEMICOLON) || (flag & FLAG_REPARSING)) mapset((uchar *)";$&|", 0);
 		inp->promptmode=1;
+#ifdef CONFIG_HUSH_PARSE_CACHE
+		/* Don't count the time spent waiting for the user to type */
+		start = timer_get_us();
+		rcode = parse_stream(&temp, &ctx, inp, '\n');
+		if (inp->get == static_get) {
+			hush_stats.parse_us += timer_get_us() - start;
+			hush_stats.parse_lines++;
+		}
+#else
 		rcode = parse_stream(&temp, &ctx, inp, '\n');
+#endif
 #ifdef __U_BOOT__
 		if (rcode == 1) flag_repeat = 0;
 #endif
@@ -3189,6 +3435,12 @@ static int parse_stream_outer(struct in_str *inp, int flag)
 #ifndef __U_BOOT__
 			run_list(ctx.list_head);
 #else
+#ifdef CONFIG_HUSH_PARSE_CACHE
+			if (inp->cache) {
+				code = run_list_timed(ctx.list_head);
+				hush_cache_add_line(inp->cache, ctx.list_head);
+			} else
+#endif
 			code = run_list(ctx.list_head);
 			if (code == -2) {	/* exit */
 				b_free(&temp);
@@ -3198,6 +3450,11 @@ static int parse_stream_outer(struct in_str *inp, int flag)
 					printf("exit not allowed from main input shell.\n");
 					continue;
 				}
+#ifdef CONFIG_HUSH_PARSE_CACHE
+				/* The rest of the script was never parsed */
+				if (inp->cache && !(flag & FLAG_EXIT_FROM_LOOP))
+					inp->cache->error = 1;
+#endif
 				break;
 			}
 			if (code == -1)
@@ -3216,6 +3473,10 @@ static int parse_stream_outer(struct in_str *inp, int flag)
 			temp.quote = 0;
 			inp->p = NULL;
 			free_pipe_list(ctx.list_head,0);
+#ifdef CONFIG_HUSH_PARSE_CACHE
+			if (inp->cache)
+				inp->cache->error = 1;
+#endif
 		}
 		b_free(&temp);
 	} while (rcode != -1 && !(flag & FLAG_EXIT_FROM_LOOP));   /* loop on syntax errors, return on EOF */
@@ -3675,5 +3936,72 @@ U_BOOT_CMD(
 	"    - print value of hushshell variable 'name'"
 );
 
+#ifdef CONFIG_HUSH_PARSE_CACHE
+static int do_hush_stats(cmd_tbl_t *cmdtp, int flag, int argc,
+			 char * const argv[])
+{
+	struct hush_cache *hc;
+
+	printf("Parsed:  %lu lines in %lu us\n", hush_stats.parse_lines,
+	       hush_stats.parse_us);
+	printf("Ran:     %lu lists in %lu us, not counting parsing\n",
+	       hush_stats.run_lists, hush_stats.run_us);
+	printf("Scripts: %lu from cache, %lu parsed\n\n", hush_stats.hits,
+	       hush_stats.misses);
+	printf("%-24s %6s %6s\n", "Variable", "Lines", "Reused");
+	for (hc = hush_cache; hc < hush_cache + ARRAY_SIZE(hush_cache); hc++) {
+		if (hc->name && !hc->busy)
+			printf("%-24s %6d %6u\n", hc->name, hc->line_count,
+			       hc->runs);
+	}
+
+	return 0;
+}
+
+static int do_hush_flush(cmd_tbl_t *cmdtp, int flag, int argc,
+			 char * const argv[])
+{
+	struct hush_cache *hc;
+
+	for (hc = hush_cache; hc < hush_cache + ARRAY_SIZE(hush_cache); hc++) {
+		if (!hc->busy)
+			hush_cache_free(hc);
+	}
+	memset(&hush_stats, '\0', sizeof(hush_stats));
+
+	return 0;
+}
+
+static cmd_tbl_t cmd_hush_sub[] = {
+	U_BOOT_CMD_MKENT(stats, 1, 0, do_hush_stats, "", "")
+	U_BOOT_CMD_MKENT(flush, 1, 0, do_hush_flush, "", "")
+};
+
+static int do_hush(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	cmd_tbl_t *c;
+
+	if (argc < 2)
+		return CMD_RET_USAGE;
+
+	/* Strip off leading 'hush' command argument */
+	argc--;
+	argv++;
+
+	c = find_cmd_tbl(argv[0], cmd_hush_sub, ARRAY_SIZE(cmd_hush_sub));
+	if (c)
+		return c->cmd(cmdtp, flag, argc, argv);
+	else
+		return CMD_RET_USAGE;
+}
+
+U_BOOT_CMD(
+	hush,	2,	1,	do_hush,
+	"hush parse cache",
+	"stats - show parse and run times and the cached scripts\n"
+	"hush flush - empty the cache and reset the times"
+);
+#endif
+
 #endif
 /****************************************************************************/
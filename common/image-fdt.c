@@ -26,6 +26,7 @@
  */
 
 #include <common.h>
+#include <console_log.h>
 #include <fdt_support.h>
 #include <errno.h>
 #include <image.h>
@@ -509,6 +510,8 @@ int image_setup_libfdt(bootm_headers_t *images, void *blob,
 	if (IMAGE_OF_BOARD_SETUP)
 		ft_board_setup(blob, gd->bd);
 	fdt_fixup_ethernet(blob);
+	if (console_log_fdt_setup(blob, lmb))
+		puts("WARNING: could not pass console log to OS\n");
 
 	/* Delete the old LMB reservation */
 	lmb_free(lmb, (phys_addr_t)(u32)(uintptr_t)blob,
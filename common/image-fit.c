@@ -31,6 +31,7 @@
 #include <time.h>
 #else
 #include <common.h>
+#include <cpu_work.h>
 #include <errno.h>
 #include <malloc.h>
 #include <asm/io.h>
@@ -898,6 +899,158 @@ int calculate_hash(const void *data, int data_len, const char *algo,
 	return 0;
 }
 
+#if defined(CONFIG_FIT_PARALLEL_HASH) && !defined(USE_HOSTCC)
+/**
+ * struct fit_hash_job - a hash calculated in parallel with others
+ *
+ * @work:	Work item used to run the calculation
+ * @noffset:	Hash node offset that this hash is for
+ * @algo:	Hash algorithm name
+ * @data:	Image data to hash
+ * @size:	Size of image data
+ * @value:	Calculated hash value
+ * @value_len:	Length of calculated hash value
+ */
+struct fit_hash_job {
+	struct cpu_work work;
+	int noffset;
+	char *algo;
+	const void *data;
+	size_t size;
+	uint8_t value[FIT_MAX_HASH_LEN];
+	int value_len;
+};
+
+/* Hashes precalculated by fit_all_image_verify(), used by fit_image_verify() */
+static struct fit_hash_job *fit_hash_jobs;
+static int fit_hash_job_count;
+
+static int fit_hash_job_run(void *arg)
+{
+	struct fit_hash_job *job = arg;
+
+	return calculate_hash(job->data, job->size, job->algo, job->value,
+			      &job->value_len);
+}
+
+static struct fit_hash_job *fit_hash_find_job(int noffset)
+{
+	int i;
+
+	for (i = 0; i < fit_hash_job_count; i++) {
+		if (fit_hash_jobs[i].noffset == noffset)
+			return &fit_hash_jobs[i];
+	}
+
+	return NULL;
+}
+
+/**
+ * fit_hash_add_jobs() - Add a job for each hash node in an image
+ *
+ * @fit:	pointer to the FIT format image header
+ * @image_noffset: component image node offset
+ * @jobs:	Array of jobs to fill in, or NULL to just count them
+ * @return number of jobs added
+ */
+static int fit_hash_add_jobs(const void *fit, int image_noffset,
+			     struct fit_hash_job *jobs)
+{
+	const void *data;
+	size_t size;
+	char *algo;
+	int noffset;
+	int ignore;
+	int count = 0;
+
+	if (fit_image_get_data(fit, image_noffset, &data, &size))
+		return 0;
+
+	for (noffset = fdt_first_subnode(fit, image_noffset);
+	     noffset >= 0;
+	     noffset = fdt_next_subnode(fit, noffset)) {
+		const char *name = fit_get_name(fit, noffset, NULL);
+
+		if (strncmp(name, FIT_HASH_NODENAME,
+			    strlen(FIT_HASH_NODENAME)))
+			continue;
+		if (fit_image_hash_get_algo(fit, noffset, &algo))
+			continue;
+		if (IMAGE_ENABLE_IGNORE) {
+			fit_image_hash_get_ignore(fit, noffset, &ignore);
+			if (ignore)
+				continue;
+		}
+		if (jobs) {
+			struct fit_hash_job *job = &jobs[count];
+
+			job->work.func = fit_hash_job_run;
+			job->work.arg = job;
+			job->noffset = noffset;
+			job->algo = algo;
+			job->data = data;
+			job->size = size;
+		}
+		count++;
+	}
+
+	return count;
+}
+
+/**
+ * fit_hash_prepare() - Calculate all image hashes in a FIT in parallel
+ *
+ * The results are stored for use by fit_image_check_hash(). Call
+ * fit_hash_release() when done.
+ *
+ * @fit:	pointer to the FIT format image header
+ * @images_noffset: offset of the images parent node
+ */
+static void fit_hash_prepare(const void *fit, int images_noffset)
+{
+	struct fit_hash_job *jobs;
+	int noffset;
+	int count;
+	int i;
+
+	count = 0;
+	for (noffset = fdt_first_subnode(fit, images_noffset);
+	     noffset >= 0;
+	     noffset = fdt_next_subnode(fit, noffset))
+		count += fit_hash_add_jobs(fit, noffset, NULL);
+	if (!count)
+		return;
+
+	jobs = calloc(count, sizeof(*jobs));
+	if (!jobs) {
+		debug("%s: Out of memory for %d hash jobs\n", __func__,
+		      count);
+		return;
+	}
+
+	count = 0;
+	for (noffset = fdt_first_subnode(fit, images_noffset);
+	     noffset >= 0;
+	     noffset = fdt_next_subnode(fit, noffset))
+		count += fit_hash_add_jobs(fit, noffset, jobs + count);
+
+	/* Failures are reported later, when each hash is checked */
+	for (i = 0; i < count; i++)
+		cpu_work_post(&jobs[i].work);
+	for (i = 0; i < count; i++)
+		cpu_work_wait(&jobs[i].work);
+	fit_hash_jobs = jobs;
+	fit_hash_job_count = count;
+}
+
+static void fit_hash_release(void)
+{
+	free(fit_hash_jobs);
+	fit_hash_jobs = NULL;
+	fit_hash_job_count = 0;
+}
+#endif /* CONFIG_FIT_PARALLEL_HASH && !USE_HOSTCC */
+
 static int fit_image_check_hash(const void *fit, int noffset, const void *data,
 				size_t size, char **err_msgp)
 {
@@ -907,6 +1060,9 @@ static int fit_image_check_hash(const void *fit, int noffset, const void *data,
 	uint8_t *fit_value;
 	int fit_value_len;
 	int ignore;
+#if defined(CONFIG_FIT_PARALLEL_HASH) && !defined(USE_HOSTCC)
+	struct fit_hash_job *job;
+#endif
 
 	*err_msgp = NULL;
 
@@ -930,9 +1086,28 @@ static int fit_image_check_hash(const void *fit, int noffset, const void *data,
 		return -1;
 	}
 
-	if (calculate_hash(data, size, algo, value, &value_len)) {
-		*err_msgp = "Unsupported hash algorithm";
-		return -1;
+#if defined(CONFIG_FIT_PARALLEL_HASH) && !defined(USE_HOSTCC)
+	job = fit_hash_find_job(noffset);
+	if (job) {
+		if (job->work.ret) {
+			*err_msgp = "Unsupported hash algorithm";
+			return -1;
+		}
+		memcpy(value, job->value, job->value_len);
+		value_len = job->value_len;
+	} else
+#endif
+	{
+		int span = bootstage_span_begin("hash");
+		int ret;
+
+		bootstage_span_args(span, algo, size);
+		ret = calculate_hash(data, size, algo, value, &value_len);
+		bootstage_span_end(span);
+		if (ret) {
+			*err_msgp = "Unsupported hash algorithm";
+			return -1;
+		}
 	}
 
 	if (value_len != fit_value_len) {
@@ -1042,6 +1217,7 @@ int fit_all_image_verify(const void *fit)
 	int noffset;
 	int ndepth;
 	int count;
+	int ret = 1;
 
 	/* Find images parent node offset */
 	images_noffset = fdt_path_offset(fit, FIT_IMAGES_PATH);
@@ -1051,6 +1227,12 @@ int fit_all_image_verify(const void *fit)
 		return 0;
 	}
 
+	bootstage_start(BOOTSTAGE_ID_ACCUM_FIT_HASH, "fit_hash");
+#if defined(CONFIG_FIT_PARALLEL_HASH) && !defined(USE_HOSTCC)
+	/* Hash all images at once, then check them below as normal */
+	fit_hash_prepare(fit, images_noffset);
+#endif
+
 	/* Process all image subnodes, check hashes for each */
 	printf("## Checking hash(es) for FIT Image at %08lx ...\n",
 	       (ulong)fit);
@@ -1066,12 +1248,19 @@ int fit_all_image_verify(const void *fit)
 			printf("   Hash(es) for Image %u (%s): ", count++,
 			       fit_get_name(fit, noffset, NULL));
 
-			if (!fit_image_verify(fit, noffset))
-				return 0;
+			if (!fit_image_verify(fit, noffset)) {
+				ret = 0;
+				break;
+			}
 			printf("\n");
 		}
 	}
-	return 1;
+#if defined(CONFIG_FIT_PARALLEL_HASH) && !defined(USE_HOSTCC)
+	fit_hash_release();
+#endif
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_FIT_HASH);
+
+	return ret;
 }
 
 /**
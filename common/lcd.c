@@ -43,6 +43,7 @@
 #include <lcd.h>
 #include <watchdog.h>
 #include <asm/unaligned.h>
+#include <linux/compiler.h>
 
 #if defined(CONFIG_CPU_PXA25X) || defined(CONFIG_CPU_PXA27X) || \
 	defined(CONFIG_CPU_MONAHANS)
@@ -70,7 +71,8 @@
 #ifdef CONFIG_LCD_LOGO
 # include <bmp_logo.h>		/* Get logo data, width and height	*/
 # include <bmp_logo_data.h>
-# if (CONSOLE_COLOR_WHITE >= BMP_LOGO_OFFSET) && (LCD_BPP != LCD_COLOR16)
+# if (CONSOLE_COLOR_WHITE >= BMP_LOGO_OFFSET) && (LCD_BPP != LCD_COLOR16) \
+	&& (LCD_BPP != LCD_COLOR32)
 #  error Default Color Map overlaps with Logo Color Map
 # endif
 #endif
@@ -84,6 +86,13 @@
 #define CONFIG_CONSOLE_SCROLL_LINES 1
 #endif
 
+#ifdef CONFIG_LCD_HW_SCROLL
+/* Number of screens of framebuffer memory to reserve for scrolling */
+#ifndef CONFIG_LCD_HW_SCROLL_SCREENS
+#define CONFIG_LCD_HW_SCROLL_SCREENS 2
+#endif
+#endif
+
 /************************************************************************/
 /* ** CONSOLE DEFINITIONS & FUNCTIONS					*/
 /************************************************************************/
@@ -106,7 +115,8 @@
 #if LCD_BPP == LCD_MONOCHROME
 # define COLOR_MASK(c)		((c)	  | (c) << 1 | (c) << 2 | (c) << 3 | \
 				 (c) << 4 | (c) << 5 | (c) << 6 | (c) << 7)
-#elif (LCD_BPP == LCD_COLOR8) || (LCD_BPP == LCD_COLOR16)
+#elif (LCD_BPP == LCD_COLOR8) || (LCD_BPP == LCD_COLOR16) || \
+	(LCD_BPP == LCD_COLOR32)
 # define COLOR_MASK(c)		(c)
 #else
 # error Unsupported LCD BPP.
@@ -138,10 +148,118 @@ static short console_row;
 static void *lcd_console_address;
 static void *lcd_base;			/* Start of framebuffer memory	*/
 
+#ifdef CONFIG_LCD_HW_SCROLL
+/*
+ * With hardware scrolling lcd_base is the top of the visible screen, which
+ * moves down through a larger buffer as the console scrolls.
+ */
+static void *lcd_fb_start;		/* Start of the whole buffer */
+static ulong lcd_fb_size;		/* Size of the whole buffer */
+static char lcd_hw_scroll_ok;		/* 1 if the display can be panned */
+#endif
+
 static char lcd_flush_dcache;	/* 1 to flush dcache after each lcd update */
 
+#if LCD_BPP != LCD_MONOCHROME
+/* Number of 32-bit words in one row of a character, in pixels */
+#define GLYPH_ROW_WORDS		(VIDEO_FONT_WIDTH * NBITS(LCD_BPP) / 32)
+
+/*
+ * Every possible row of font bits expanded to pixels in the current
+ * foreground and background colours, so that drawing a row of a character
+ * is just a few word stores. This is rebuilt when the colours change.
+ */
+static u32 lcd_glyph_rows[1 << VIDEO_FONT_WIDTH][GLYPH_ROW_WORDS];
+static char lcd_glyph_rows_valid;
+#endif
+
+/*
+ * Area of the framebuffer changed since the last lcd_sync(), in pixels. The
+ * right and bottom edges are exclusive, so the area is empty when
+ * lcd_dirty_x1 <= lcd_dirty_x0.
+ */
+static int lcd_dirty_x0, lcd_dirty_y0;
+static int lcd_dirty_x1, lcd_dirty_y1;
+
+/* Statistics on dcache flushing, shown by the 'lcdstats' command */
+static ulong lcd_flush_bytes;	/* Number of bytes flushed */
+static ulong lcd_flush_count;	/* Number of calls to flush_dcache_range() */
+static ulong lcd_flush_start;	/* Time when statistics were reset (ms) */
+
 /************************************************************************/
 
+void lcd_mark_dirty(int x, int y, int width, int height)
+{
+	int x1 = x + width, y1 = y + height;
+
+	if (x < 0)
+		x = 0;
+	if (y < 0)
+		y = 0;
+	if (x1 > panel_info.vl_col)
+		x1 = panel_info.vl_col;
+	if (y1 > panel_info.vl_row)
+		y1 = panel_info.vl_row;
+	if (x1 <= x || y1 <= y)
+		return;
+
+	if (lcd_dirty_x1 <= lcd_dirty_x0) {
+		lcd_dirty_x0 = x;
+		lcd_dirty_y0 = y;
+		lcd_dirty_x1 = x1;
+		lcd_dirty_y1 = y1;
+	} else {
+		lcd_dirty_x0 = min(lcd_dirty_x0, x);
+		lcd_dirty_y0 = min(lcd_dirty_y0, y);
+		lcd_dirty_x1 = max(lcd_dirty_x1, x1);
+		lcd_dirty_y1 = max(lcd_dirty_y1, y1);
+	}
+}
+
+/* Mark a part of the framebuffer given by address and size as dirty */
+static void lcd_mark_dirty_bytes(void *start, ulong size)
+{
+	ulong offset = start - lcd_base;
+	int y = offset / lcd_line_length;
+
+	lcd_mark_dirty(0, y, panel_info.vl_col,
+		       DIV_ROUND_UP(offset + size, lcd_line_length) - y);
+}
+
+#if defined(CONFIG_ARM) && !defined(CONFIG_SYS_DCACHE_OFF)
+static void lcd_flush_range(ulong start, ulong end)
+{
+	start &= ~(ARCH_DMA_MINALIGN - 1);
+	end = ALIGN(end, ARCH_DMA_MINALIGN);
+	flush_dcache_range(start, end);
+	lcd_flush_bytes += end - start;
+	lcd_flush_count++;
+}
+
+/* Flush the dirty area of the framebuffer from the dcache */
+static void lcd_flush_dirty(void)
+{
+	int bpix = NBITS(panel_info.vl_bpix);
+	ulong left = lcd_dirty_x0 * bpix / 8;
+	ulong right = DIV_ROUND_UP(lcd_dirty_x1 * bpix, 8);
+	ulong line = (ulong)lcd_base + lcd_dirty_y0 * lcd_line_length;
+	int height = lcd_dirty_y1 - lcd_dirty_y0;
+	int y;
+
+	/*
+	 * For narrow areas flush each line separately, otherwise it is
+	 * quicker to flush the whole range in one go.
+	 */
+	if (height == 1 || (right - left) * 2 > lcd_line_length) {
+		lcd_flush_range(line + left,
+				line + (height - 1) * lcd_line_length + right);
+		return;
+	}
+	for (y = 0; y < height; y++, line += lcd_line_length)
+		lcd_flush_range(line + left, line + right);
+}
+#endif
+
 /* Flush LCD activity to the caches */
 void lcd_sync(void)
 {
@@ -151,12 +269,11 @@ void lcd_sync(void)
 	 * out whether it exists? For now, ARM is safe.
 	 */
 #if defined(CONFIG_ARM) && !defined(CONFIG_SYS_DCACHE_OFF)
-	int line_length;
-
-	if (lcd_flush_dcache)
-		flush_dcache_range((u32)lcd_base,
-			(u32)(lcd_base + lcd_get_size(&line_length)));
+	if (lcd_flush_dcache && lcd_dirty_x1 > lcd_dirty_x0)
+		lcd_flush_dirty();
 #endif
+	lcd_dirty_x0 = 0;
+	lcd_dirty_x1 = 0;
 }
 
 void lcd_set_flush_dcache(int flush)
@@ -166,10 +283,68 @@ void lcd_set_flush_dcache(int flush)
 
 /*----------------------------------------------------------------------*/
 
+#ifdef CONFIG_LCD_HW_SCROLL
+int __weak lcd_set_display_offset(ulong offset)
+{
+	return -1;
+}
+
+/*
+ * Scroll the console by moving the visible window down the framebuffer
+ * instead of copying the whole screen. When we reach the end of the buffer
+ * the visible part is copied back to the start, so we only copy once every
+ * few screens.
+ *
+ * Returns 0 if scrolled, -1 if the caller must scroll in software
+ */
+static int lcd_hw_scroll(int rows)
+{
+	ulong step = CONSOLE_ROW_SIZE * rows;
+	ulong keep = CONSOLE_SIZE - step;
+	int line_length;
+	ulong screen_size = lcd_get_size(&line_length);
+	void *base = lcd_base + step;
+
+	/* The whole screen moves, so anything above the console would too */
+	if (!lcd_hw_scroll_ok || lcd_console_address != lcd_base)
+		return -1;
+
+	/* Finish off anything drawn at the old position */
+	lcd_sync();
+
+	if (base + screen_size > lcd_fb_start + lcd_fb_size) {
+		base = lcd_fb_start;
+		memmove(base, lcd_base + step, keep);
+		lcd_base = base;
+		lcd_mark_dirty(0, 0, panel_info.vl_col, panel_info.vl_row);
+	} else {
+		lcd_base = base;
+		lcd_mark_dirty_bytes(lcd_base + keep, screen_size - keep);
+	}
+	lcd_console_address = lcd_base;
+
+	/* Clear the new rows, including any part row below the console */
+	memset(lcd_base + keep, COLOR_MASK(lcd_color_bg), screen_size - keep);
+	lcd_sync();
+
+	/* The new rows are in memory so we can now show them */
+	lcd_set_display_offset(lcd_base - lcd_fb_start);
+
+	return 0;
+}
+#endif
+
 static void console_scrollup(void)
 {
 	const int rows = CONFIG_CONSOLE_SCROLL_LINES;
 
+#ifdef CONFIG_LCD_HW_SCROLL
+	if (!lcd_hw_scroll(rows)) {
+		console_row -= rows;
+		return;
+	}
+#endif
+
 	/* Copy up rows ignoring those that will be overwritten */
 	memcpy(CONSOLE_ROW_FIRST,
 	       lcd_console_address + CONSOLE_ROW_SIZE * rows,
@@ -180,6 +355,7 @@ static void console_scrollup(void)
 		COLOR_MASK(lcd_color_bg),
 		CONSOLE_ROW_SIZE * rows);
 
+	lcd_mark_dirty_bytes(CONSOLE_ROW_FIRST, CONSOLE_SIZE);
 	lcd_sync();
 	console_row -= rows;
 }
@@ -284,6 +460,7 @@ void lcd_printf(const char *fmt, ...)
 /* ** Low-Level Graphics Routines					*/
 /************************************************************************/
 
+#if LCD_BPP == LCD_MONOCHROME
 static void lcd_drawchars(ushort x, ushort y, uchar *str, int count)
 {
 	uchar *dest;
@@ -293,56 +470,104 @@ static void lcd_drawchars(ushort x, ushort y, uchar *str, int count)
 	y += BMP_LOGO_HEIGHT;
 #endif
 
-#if LCD_BPP == LCD_MONOCHROME
 	ushort off  = x * (1 << LCD_BPP) % 8;
-#endif
 
 	dest = (uchar *)(lcd_base + y * lcd_line_length + x * (1 << LCD_BPP) / 8);
+	lcd_mark_dirty(x, y, count * VIDEO_FONT_WIDTH, VIDEO_FONT_HEIGHT);
 
 	for (row = 0; row < VIDEO_FONT_HEIGHT; ++row, dest += lcd_line_length) {
 		uchar *s = str;
 		int i;
-#if LCD_BPP == LCD_COLOR16
-		ushort *d = (ushort *)dest;
-#else
 		uchar *d = dest;
-#endif
-
-#if LCD_BPP == LCD_MONOCHROME
 		uchar rest = *d & -(1 << (8 - off));
 		uchar sym;
-#endif
+
 		for (i = 0; i < count; ++i) {
 			uchar c, bits;
 
 			c = *s++;
 			bits = video_fontdata[c * VIDEO_FONT_HEIGHT + row];
 
-#if LCD_BPP == LCD_MONOCHROME
 			sym  = (COLOR_MASK(lcd_color_fg) & bits) |
 				(COLOR_MASK(lcd_color_bg) & ~bits);
 
 			*d++ = rest | (sym >> off);
 			rest = sym << (8-off);
-#elif LCD_BPP == LCD_COLOR8
-			for (c = 0; c < 8; ++c) {
-				*d++ = (bits & 0x80) ?
-						lcd_color_fg : lcd_color_bg;
-				bits <<= 1;
-			}
+		}
+		*d  = rest | (*d & ((1 << (8 - off)) - 1));
+	}
+}
+#else
+/* Expand all possible rows of font bits into pixels for the current colours */
+static void lcd_build_glyph_rows(void)
+{
+	int bits, i;
+
+	for (bits = 0; bits < ARRAY_SIZE(lcd_glyph_rows); bits++) {
+#if LCD_BPP == LCD_COLOR8
+		uchar *pix = (uchar *)lcd_glyph_rows[bits];
 #elif LCD_BPP == LCD_COLOR16
-			for (c = 0; c < 8; ++c) {
-				*d++ = (bits & 0x80) ?
-						lcd_color_fg : lcd_color_bg;
-				bits <<= 1;
-			}
+		ushort *pix = (ushort *)lcd_glyph_rows[bits];
+#else
+		u32 *pix = lcd_glyph_rows[bits];
 #endif
+
+		for (i = 0; i < VIDEO_FONT_WIDTH; i++) {
+			pix[i] = bits & (1 << (VIDEO_FONT_WIDTH - 1 - i)) ?
+					lcd_color_fg : lcd_color_bg;
 		}
-#if LCD_BPP == LCD_MONOCHROME
-		*d  = rest | (*d & ((1 << (8 - off)) - 1));
+	}
+	lcd_glyph_rows_valid = 1;
+}
+
+static void lcd_drawchars(ushort x, ushort y, uchar *str, int count)
+{
+	const uchar *font;
+	uchar *dest;
+	ushort row;
+	int i, j;
+
+#if defined(CONFIG_LCD_LOGO) && !defined(CONFIG_LCD_INFO_BELOW_LOGO)
+	y += BMP_LOGO_HEIGHT;
 #endif
+
+	if (!lcd_glyph_rows_valid)
+		lcd_build_glyph_rows();
+
+	dest = (uchar *)(lcd_base + y * lcd_line_length + x * (1 << LCD_BPP) / 8);
+	lcd_mark_dirty(x, y, count * VIDEO_FONT_WIDTH, VIDEO_FONT_HEIGHT);
+
+	/* Odd panel widths may leave us unaligned, so fall back to memcpy() */
+	if (((ulong)dest | lcd_line_length) & (sizeof(u32) - 1)) {
+		for (row = 0; row < VIDEO_FONT_HEIGHT; ++row,
+		     dest += lcd_line_length) {
+			uchar *d = dest;
+
+			font = video_fontdata + row;
+			for (i = 0; i < count; ++i) {
+				memcpy(d, lcd_glyph_rows[font[str[i] *
+					VIDEO_FONT_HEIGHT]],
+				       sizeof(lcd_glyph_rows[0]));
+				d += sizeof(lcd_glyph_rows[0]);
+			}
+		}
+		return;
+	}
+
+	for (row = 0; row < VIDEO_FONT_HEIGHT; ++row, dest += lcd_line_length) {
+		u32 *d = (u32 *)dest;
+
+		font = video_fontdata + row;
+		for (i = 0; i < count; ++i) {
+			const u32 *pix;
+
+			pix = lcd_glyph_rows[font[str[i] * VIDEO_FONT_HEIGHT]];
+			for (j = 0; j < GLYPH_ROW_WORDS; j++)
+				*d++ = pix[j];
+		}
 	}
 }
+#endif /* LCD_BPP == LCD_MONOCHROME */
 
 /*----------------------------------------------------------------------*/
 
@@ -414,6 +639,21 @@ int drv_lcd_init(void)
 
 	lcd_init(lcd_base);		/* LCD initialization */
 
+#ifdef CONFIG_LCD_HW_SCROLL
+	/*
+	 * We can only pan if lcd_setmem() reserved the buffer, i.e. the
+	 * driver did not move it, and the driver supports panning.
+	 */
+	if (lcd_base == (void *)gd->fb_base && !lcd_set_display_offset(0)) {
+		int line_length;
+
+		lcd_fb_start = lcd_base;
+		lcd_fb_size = lcd_get_size(&line_length) *
+				CONFIG_LCD_HW_SCROLL_SCREENS;
+		lcd_hw_scroll_ok = 1;
+	}
+#endif
+
 	/* Device initialization */
 	memset(&lcddev, 0, sizeof(lcddev));
 
@@ -456,6 +696,14 @@ void lcd_clear(void)
 	lcd_setbgcolor(CONSOLE_COLOR_BLACK);
 #endif	/* CONFIG_SYS_WHITE_ON_BLACK */
 
+#ifdef CONFIG_LCD_HW_SCROLL
+	/* Go back to the start of the buffer */
+	if (lcd_hw_scroll_ok && lcd_base != lcd_fb_start) {
+		lcd_base = lcd_fb_start;
+		lcd_set_display_offset(0);
+	}
+#endif
+
 #ifdef	LCD_TEST_PATTERN
 	test_pattern();
 #else
@@ -470,6 +718,7 @@ void lcd_clear(void)
 
 	console_col = 0;
 	console_row = 0;
+	lcd_mark_dirty(0, 0, panel_info.vl_col, panel_info.vl_row);
 	lcd_sync();
 }
 
@@ -486,6 +735,39 @@ U_BOOT_CMD(
 	""
 );
 
+static int do_lcd_stats(cmd_tbl_t *cmdtp, int flag, int argc,
+			char *const argv[])
+{
+	ulong elapsed;
+
+	if (argc > 1) {
+		if (strcmp(argv[1], "reset"))
+			return CMD_RET_USAGE;
+		lcd_flush_bytes = 0;
+		lcd_flush_count = 0;
+		lcd_flush_start = get_timer(0);
+		return 0;
+	}
+
+	elapsed = get_timer(lcd_flush_start);
+	printf("Cache flushing: %s\n", lcd_flush_dcache ? "on" : "off");
+	printf("Flushes:        %lu\n", lcd_flush_count);
+	printf("Bytes flushed:  %lu\n", lcd_flush_bytes);
+	printf("Elapsed:        %lu ms\n", elapsed);
+	if (elapsed)
+		printf("Bytes/second:   %llu\n",
+		       (unsigned long long)lcd_flush_bytes * 1000 / elapsed);
+
+	return 0;
+}
+
+U_BOOT_CMD(
+	lcdstats,	2,	1,	do_lcd_stats,
+	"show LCD cache flush statistics",
+	"        - show bytes flushed and bytes flushed per second\n"
+	"lcdstats reset  - reset statistics"
+);
+
 /*----------------------------------------------------------------------*/
 
 static int lcd_init(void *lcdbase)
@@ -534,18 +816,28 @@ static int lcd_init(void *lcdbase)
  *
  * Note that this is running from ROM, so no write access to global data.
  */
-ulong lcd_setmem(ulong addr)
+ulong lcd_get_reserved_size(void)
 {
 	ulong size;
 	int line_length;
 
-	debug("LCD panel info: %d x %d, %d bit/pix\n", panel_info.vl_col,
-		panel_info.vl_row, NBITS(panel_info.vl_bpix));
-
 	size = lcd_get_size(&line_length);
+#ifdef CONFIG_LCD_HW_SCROLL
+	size *= CONFIG_LCD_HW_SCROLL_SCREENS;
+#endif
 
 	/* Round up to nearest full page, or MMU section if defined */
-	size = ALIGN(size, CONFIG_LCD_ALIGNMENT);
+	return ALIGN(size, CONFIG_LCD_ALIGNMENT);
+}
+
+ulong lcd_setmem(ulong addr)
+{
+	ulong size;
+
+	debug("LCD panel info: %d x %d, %d bit/pix\n", panel_info.vl_col,
+		panel_info.vl_row, NBITS(panel_info.vl_bpix));
+
+	size = lcd_get_reserved_size();
 	addr = ALIGN(addr - CONFIG_LCD_ALIGNMENT + 1, CONFIG_LCD_ALIGNMENT);
 
 	/* Allocate pages for the frame buffer. */
@@ -562,6 +854,9 @@ ulong lcd_setmem(ulong addr)
 static void lcd_setfgcolor(int color)
 {
 	lcd_color_fg = color;
+#if LCD_BPP != LCD_MONOCHROME
+	lcd_glyph_rows_valid = 0;
+#endif
 }
 
 /*----------------------------------------------------------------------*/
@@ -569,6 +864,9 @@ static void lcd_setfgcolor(int color)
 static void lcd_setbgcolor(int color)
 {
 	lcd_color_bg = color;
+#if LCD_BPP != LCD_MONOCHROME
+	lcd_glyph_rows_valid = 0;
+#endif
 }
 
 /*----------------------------------------------------------------------*/
@@ -620,6 +918,7 @@ void bitmap_plot(int x, int y)
 	uchar *bmap;
 	uchar *fb;
 	ushort *fb16;
+	u32 *fb32;
 #if defined(CONFIG_MPC823)
 	immap_t *immr = (immap_t *) CONFIG_SYS_IMMR;
 	cpm8xx_t *cp = &(immr->im_cpm);
@@ -686,6 +985,22 @@ void bitmap_plot(int x, int y)
 			fb += panel_info.vl_col;
 		}
 	}
+	else if (bpix == 32) {
+		u32 col;
+
+		/* Widen each 4-bit component of the palette to 8 bits */
+		fb32 = (u32 *)fb;
+		for (i = 0; i < BMP_LOGO_HEIGHT; ++i) {
+			for (j = 0; j < BMP_LOGO_WIDTH; j++) {
+				col = bmp_logo_palette[bmap[j] - BMP_LOGO_OFFSET];
+				fb32[j] = (((col & 0x0F00) << 8) |
+					   ((col & 0x00F0) << 4) |
+					   (col & 0x000F)) * 0x11;
+			}
+			bmap += BMP_LOGO_WIDTH;
+			fb32 += panel_info.vl_col;
+		}
+	}
 	else { /* true color mode */
 		u16 col16;
 		fb16 = (ushort *)fb;
@@ -703,6 +1018,7 @@ void bitmap_plot(int x, int y)
 	}
 
 	WATCHDOG_RESET();
+	lcd_mark_dirty(x, y, BMP_LOGO_WIDTH, BMP_LOGO_HEIGHT);
 	lcd_sync();
 }
 #else
@@ -756,24 +1072,26 @@ static void draw_unencoded_bitmap(ushort **fbp, uchar *bmap, ushort *cmap,
 static void draw_encoded_bitmap(ushort **fbp, ushort c, int cnt)
 {
 	ushort *fb = *fbp;
-	int cnt_8copy = cnt >> 3;
+	u32 c2 = c | (u32)c << 16;
+	u32 *fb32;
 
-	cnt -= cnt_8copy << 3;
-	while (cnt_8copy > 0) {
-		*fb++ = c;
-		*fb++ = c;
-		*fb++ = c;
-		*fb++ = c;
-		*fb++ = c;
-		*fb++ = c;
-		*fb++ = c;
-		*fb++ = c;
-		cnt_8copy--;
-	}
-	while (cnt > 0) {
+	/* Get to a word boundary and then write two pixels at a time */
+	if (cnt > 0 && ((ulong)fb & 2)) {
 		*fb++ = c;
 		cnt--;
 	}
+	for (fb32 = (u32 *)fb; cnt >= 8; cnt -= 8) {
+		fb32[0] = c2;
+		fb32[1] = c2;
+		fb32[2] = c2;
+		fb32[3] = c2;
+		fb32 += 4;
+	}
+	for (; cnt >= 2; cnt -= 2)
+		*fb32++ = c2;
+	fb = (ushort *)fb32;
+	if (cnt > 0)
+		*fb++ = c;
 	*fbp = fb;
 }
 
@@ -890,6 +1208,22 @@ static inline void fb_put_word(uchar **fb, uchar **from)
 #endif
 #endif /* CONFIG_BMP_16BPP */
 
+/* Convert a row of 8bpp pixels to 16bpp using the colour map */
+static void lcd_put_row_8_16(ushort *fb, const uchar *bmap,
+			     const ushort *cmap, int width)
+{
+	for (; width >= 4; width -= 4) {
+		fb[0] = cmap[bmap[0]];
+		fb[1] = cmap[bmap[1]];
+		fb[2] = cmap[bmap[2]];
+		fb[3] = cmap[bmap[3]];
+		fb += 4;
+		bmap += 4;
+	}
+	while (width-- > 0)
+		*fb++ = cmap[*bmap++];
+}
+
 int lcd_display_bitmap(ulong bmp_image, int x, int y)
 {
 #if !defined(CONFIG_MCC200)
@@ -1024,21 +1358,22 @@ int lcd_display_bitmap(ulong bmp_image, int x, int y)
 		}
 #endif
 
-		if (bpix != 16)
-			byte_width = width;
-		else
-			byte_width = width * 2;
+		if (bpix == 16) {
+			for (i = 0; i < height; ++i) {
+				WATCHDOG_RESET();
+				lcd_put_row_8_16((ushort *)fb, bmap, cmap_base,
+						 width);
+				bmap += padded_width;
+				fb -= lcd_line_length;
+			}
+			break;
+		}
 
+		byte_width = width;
 		for (i = 0; i < height; ++i) {
 			WATCHDOG_RESET();
-			for (j = 0; j < width; j++) {
-				if (bpix != 16) {
-					FB_PUT_BYTE(fb, bmap);
-				} else {
-					*(uint16_t *)fb = cmap_base[*(bmap++)];
-					fb += sizeof(uint16_t) / sizeof(*fb);
-				}
-			}
+			for (j = 0; j < width; j++)
+				FB_PUT_BYTE(fb, bmap);
 			bmap += (padded_width - width);
 			fb -= byte_width + lcd_line_length;
 		}
@@ -1074,6 +1409,7 @@ int lcd_display_bitmap(ulong bmp_image, int x, int y)
 		break;
 	};
 
+	lcd_mark_dirty(x, y, width, height);
 	lcd_sync();
 	return 0;
 }
@@ -1174,6 +1510,37 @@ void lcd_position_cursor(unsigned col, unsigned row)
 	console_row = min(row, CONSOLE_ROWS - 1);
 }
 
+void lcd_read_rect(int x, int y, int width, int height, void *buf)
+{
+	int bytes = width * NBITS(panel_info.vl_bpix) / 8;
+	uchar *fb = (uchar *)lcd_base + y * lcd_line_length +
+			x * NBITS(panel_info.vl_bpix) / 8;
+	uchar *dest = buf;
+
+	for (; height > 0; height--) {
+		memcpy(dest, fb, bytes);
+		dest += bytes;
+		fb += lcd_line_length;
+	}
+}
+
+void lcd_write_rect(int x, int y, int width, int height, const void *buf)
+{
+	int bytes = width * NBITS(panel_info.vl_bpix) / 8;
+	uchar *fb = (uchar *)lcd_base + y * lcd_line_length +
+			x * NBITS(panel_info.vl_bpix) / 8;
+	const uchar *src = buf;
+	int i;
+
+	for (i = 0; i < height; i++) {
+		memcpy(fb, src, bytes);
+		src += bytes;
+		fb += lcd_line_length;
+	}
+	lcd_mark_dirty(x, y, width, height);
+	lcd_sync();
+}
+
 int lcd_get_pixel_width(void)
 {
 	return panel_info.vl_col;
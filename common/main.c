@@ -1585,8 +1585,14 @@ int do_run (cmd_tbl_t * cmdtp, int flag, int argc, char * const argv[])
 			return 1;
 		}
 
+#ifdef CONFIG_SYS_HUSH_PARSER
+		if (parse_var_outer(argv[i], arg, FLAG_PARSE_SEMICOLON |
+				    FLAG_EXIT_FROM_LOOP) != 0)
+			return 1;
+#else
 		if (run_command(arg, flag) != 0)
 			return 1;
+#endif
 	}
 	return 0;
 }
@@ -0,0 +1,77 @@
+/*
+ * Simple pre-relocation memory allocator
+ *
+ * Copyright (c) 2013 The Chromium OS Authors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#include <common.h>
+#include <malloc.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/* Alignment of allocations, matching malloc() */
+#define MALLOC_SIMPLE_ALIGN	(2 * sizeof(size_t))
+
+void *memalign_simple(size_t align, size_t size)
+{
+	ulong addr, new_ptr;
+
+	if (!gd->malloc_limit)
+		return NULL;
+	if (align < MALLOC_SIMPLE_ALIGN)
+		align = MALLOC_SIMPLE_ALIGN;
+	addr = ALIGN(gd->malloc_base + gd->malloc_ptr, align);
+	new_ptr = addr + size - gd->malloc_base;
+	if (new_ptr > gd->malloc_limit) {
+		debug("%s: out of space for %#zx bytes (used %#lx/%#lx)\n",
+		      __func__, size, gd->malloc_ptr, gd->malloc_limit);
+		return NULL;
+	}
+	gd->malloc_ptr = new_ptr;
+
+	return (void *)addr;
+}
+
+void *malloc_simple(size_t size)
+{
+	return memalign_simple(MALLOC_SIMPLE_ALIGN, size);
+}
+
+int malloc_simple_owns(const void *ptr)
+{
+	ulong addr = (ulong)ptr;
+
+	return addr >= gd->malloc_base &&
+		addr < gd->malloc_base + gd->malloc_limit;
+}
+
+void *early_cache_get(enum early_cache_id id)
+{
+	return gd->early_cache[id];
+}
+
+void *early_cache_alloc(enum early_cache_id id, size_t size)
+{
+	void *ptr;
+
+	ptr = malloc(size);
+	if (ptr)
+		gd->early_cache[id] = ptr;
+
+	return ptr;
+}
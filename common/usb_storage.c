@@ -240,6 +240,7 @@ int usb_stor_scan(int mode)
 	usb_disable_asynch(1); /* asynch transfer not allowed */
 
 	for (i = 0; i < USB_MAX_STOR_DEV; i++) {
+		part_efi_invalidate(&usb_dev_desc[i]);
 		memset(&usb_dev_desc[i], 0, sizeof(block_dev_desc_t));
 		usb_dev_desc[i].if_type = IF_TYPE_USB;
 		usb_dev_desc[i].dev = i;
@@ -1142,6 +1143,7 @@ unsigned long usb_stor_write(int device, unsigned long blknr,
 		return 0;
 
 	device &= 0xff;
+	part_efi_note_write(&usb_dev_desc[device], blknr, blkcnt);
 	/* Setup  device */
 	debug("\nusb_write: dev %d \n", device);
 	dev = NULL;
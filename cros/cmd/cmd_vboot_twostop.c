@@ -246,14 +246,6 @@ twostop_init_cparams(struct twostop_fmap *fmap, void *gbb,
 
 #if defined(CONFIG_OF_CONTROL) && defined(CONFIG_ARM)
 
-#ifdef CONFIG_LCD
-static int lcd_fb_size(void)
-{
-	return panel_info.vl_row * panel_info.vl_col *
-		NBITS(panel_info.vl_bpix) / 8;
-}
-#endif
-
 extern uint8_t _start;
 extern uint8_t __bss_end;
 
@@ -285,8 +277,8 @@ static void setup_arch_unused_memory(memory_wipe_t *wipe,
 
 #ifdef CONFIG_LCD
 	{
-		/* Excludes the frame buffer. */
-		int fb_size = lcd_fb_size();
+		/* Excludes the frame buffer, including any scroll screens */
+		ulong fb_size = lcd_get_reserved_size();
 
 		memory_wipe_sub(wipe,
 				(uintptr_t)gd->fb_base,
@@ -68,92 +68,30 @@ static int read_spi(firmware_storage_t *file, uint32_t offset, uint32_t count,
 }
 
 /*
- * FIXME: It is a reasonable assumption that sector size = 4096 bytes.
- * Nevertheless, comparing to coding this magic number here, there should be a
- * better way (maybe rewrite driver interface?) to expose this parameter from
- * eeprom driver.
+ * Only sectors which differ are erased and only pages which differ are
+ * programmed, so rewriting a region which has barely changed is quick.
  */
-#define SECTOR_SIZE 0x1000
-
-/*
- * Align the right-exclusive range [*offset_ptr:*offset_ptr+*length_ptr) with
- * SECTOR_SIZE.
- * After alignment adjustment, both offset and length will be multiple of
- * SECTOR_SIZE, and will be larger than or equal to the original range.
- */
-static void align_to_sector(uint32_t *offset_ptr, uint32_t *length_ptr)
-{
-	VBDEBUG("before adjustment\n");
-	VBDEBUG("offset: 0x%x\n", *offset_ptr);
-	VBDEBUG("length: 0x%x\n", *length_ptr);
-
-	/* Adjust if offset is not multiple of SECTOR_SIZE */
-	if (*offset_ptr & (SECTOR_SIZE - 1ul)) {
-		*offset_ptr &= ~(SECTOR_SIZE - 1ul);
-	}
-
-	/* Adjust if length is not multiple of SECTOR_SIZE */
-	if (*length_ptr & (SECTOR_SIZE - 1ul)) {
-		*length_ptr &= ~(SECTOR_SIZE - 1ul);
-		*length_ptr += SECTOR_SIZE;
-	}
-
-	VBDEBUG("after adjustment\n");
-	VBDEBUG("offset: 0x%x\n", *offset_ptr);
-	VBDEBUG("length: 0x%x\n", *length_ptr);
-}
-
 static int write_spi(firmware_storage_t *file, uint32_t offset, uint32_t count,
 		void *buf)
 {
 	struct spi_flash *flash = file->context;
-	uint8_t static_buf[SECTOR_SIZE];
-	uint8_t *backup_buf;
-	uint32_t k, n;
-	int status, ret = -1;
-
-	/* We will erase <n> bytes starting from <k> */
-	k = offset;
-	n = count;
-	align_to_sector(&k, &n);
-
-	VBDEBUG("offset:          0x%08x\n", offset);
-	VBDEBUG("adjusted offset: 0x%08x\n", k);
-	if (k > offset) {
-		VBDEBUG("align incorrect: %08x > %08x\n", k, offset);
-		return -1;
-	}
+	struct spi_flash_update_stats stats;
+	int status;
 
-	if (border_check(flash, k, n))
+	VBDEBUG("offset=%#x, count=%#x\n", offset, count);
+	if (border_check(flash, offset, count))
 		return -1;
 
-	backup_buf = n > sizeof(static_buf) ? malloc(n) : static_buf;
-
-	if ((status = flash->read(flash, k, n, backup_buf))) {
-		VBDEBUG("cannot backup data: %d\n", status);
-		goto EXIT;
-	}
-
-	if ((status = flash->erase(flash, k, n))) {
-		VBDEBUG("SPI erase fail: %d\n", status);
-		goto EXIT;
-	}
-
-	/* combine data we want to write and backup data */
-	memcpy(backup_buf + (offset - k), buf, count);
-
-	if (flash->write(flash, k, n, backup_buf)) {
-		VBDEBUG("SPI write fail\n");
-		goto EXIT;
+	memset(&stats, '\0', sizeof(stats));
+	status = spi_flash_update(flash, offset, count, buf, &stats);
+	if (status) {
+		VBDEBUG("SPI update fail: %d\n", status);
+		return -1;
 	}
+	VBDEBUG("erased %#zx, programmed %#zx, unchanged %#zx\n",
+		stats.erased, stats.programmed, stats.unchanged);
 
-	ret = 0;
-
-EXIT:
-	if (backup_buf != static_buf)
-		free(backup_buf);
-
-	return ret;
+	return 0;
 }
 
 static int close_spi(firmware_storage_t *file)
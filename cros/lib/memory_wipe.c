@@ -11,7 +11,7 @@
 #include <common.h>
 #include <cros/common.h>
 #include <cros/memory_wipe.h>
-#include <malloc.h>
+#include <mempool.h>
 #include <physmem.h>
 
 #include <vboot_api.h>
@@ -26,11 +26,14 @@
  * starting a wipe region and starting a not wiped region.
  */
 
+/* Edges are added and removed one at a time, so keep a pool of them */
+static struct mem_pool memory_wipe_pool =
+	MEM_POOL_INIT("memory-wipe", sizeof(memory_wipe_edge_t), 32);
+
 static void memory_wipe_insert_between(memory_wipe_edge_t *before,
 	memory_wipe_edge_t *after, phys_addr_t pos)
 {
-	memory_wipe_edge_t *new_edge =
-		(memory_wipe_edge_t *)malloc(sizeof(*new_edge));
+	memory_wipe_edge_t *new_edge = mem_pool_alloc(&memory_wipe_pool);
 
 	assert(new_edge);
 	assert(before != after);
@@ -85,7 +88,7 @@ static void memory_wipe_set_region_to(memory_wipe_t *wipe_info,
 	 */
 	while (cur && cur->pos <= end) {
 		cur = cur->next;
-		free(prev->next);
+		mem_pool_free(&memory_wipe_pool, prev->next);
 		prev->next = cur;
 		wipe = !wipe;
 	}
@@ -191,6 +191,8 @@ VbError_t VbExDiskWrite(VbExDiskHandle_t handle, uint64_t lba_start,
 			(int)dev->if_type);
 		return VBERROR_DISK_WRITE_ERROR;
 	}
+	/* vboot only writes to update the GPT, so drop our cached copy */
+	part_efi_invalidate(dev);
 	if (dev->block_write(dev->dev, lba_start, lba_count, buffer)
 			!= lba_count)
 		return VBERROR_DISK_WRITE_ERROR;
@@ -19,10 +19,12 @@
 #include <cros/common.h>
 #include <cros/crossystem_data.h>
 #include <cros/cros_init.h>
+#include <malloc.h>
 #include <lzma/LzmaTypes.h>
 #include <lzma/LzmaDec.h>
 #include <lzma/LzmaTools.h>
 #include <asm/unaligned.h>
+#include <bmp_layout.h>
 
 #ifdef CONFIG_EXYNOS_DISPLAYPORT
 /* for exynos_lcd_check_next_stage() */
@@ -32,6 +34,14 @@
 #define PRINT_MAX_ROW	20
 #define PRINT_MAX_COL	80
 
+/* Maximum number of images and bytes to keep in the display cache */
+#ifndef CONFIG_CHROMEOS_DISPLAY_CACHE_ENTRIES
+#define CONFIG_CHROMEOS_DISPLAY_CACHE_ENTRIES	32
+#endif
+#ifndef CONFIG_CHROMEOS_DISPLAY_CACHE_SIZE
+#define CONFIG_CHROMEOS_DISPLAY_CACHE_SIZE	(4 << 20)
+#endif
+
 DECLARE_GLOBAL_DATA_PTR;
 
 #if defined(CONFIG_CHROMEOS_DISPLAY) && defined(CONFIG_SANDBOX)
@@ -203,9 +213,9 @@ VbError_t VbExDisplayScreen(uint32_t screen_type)
 	return VBERROR_SUCCESS;
 }
 
-VbError_t VbExDecompress(void *inbuf, uint32_t in_size,
-                         uint32_t compression_type,
-                         void *outbuf, uint32_t *out_size)
+static VbError_t decompress(void *inbuf, uint32_t in_size,
+			    uint32_t compression_type,
+			    void *outbuf, uint32_t *out_size)
 {
 	switch (compression_type) {
 	case COMPRESS_NONE:
@@ -236,9 +246,267 @@ VbError_t VbExDecompress(void *inbuf, uint32_t in_size,
 	return VBERROR_INVALID_PARAMETER;
 }
 
-#ifdef CONFIG_CHROMEOS_DISPLAY
-#include <bmp_layout.h>
+#ifdef CONFIG_CHROMEOS_DISPLAY_CACHE
+/*
+ * vboot redraws the same screens over and over, e.g. while waiting for a
+ * recovery device, and each time it decompresses every GBB image and we
+ * convert it to the panel's pixel format one pixel at a time. To avoid
+ * this we keep a cache of images already drawn, in panel format.
+ *
+ * vboot passes each image through VbExDecompress() and then hands the
+ * output buffer to VbExDisplayImage(). The GBB is read into memory once
+ * and stays put, so we identify an image by its address in the GBB. When
+ * an image is in the cache we skip decompression, and only decompress
+ * later if VbExDisplayImage() finds that it needs the data after all.
+ */
+
+/**
+ * struct image_cache_entry - an image in the display cache
+ *
+ * @src:	Address of the image data in the GBB
+ * @x:		X position where the image was drawn
+ * @y:		Y position where the image was drawn
+ * @width:	Width of the image in pixels, after clipping to the panel
+ * @height:	Height of the image in pixels, after clipping to the panel
+ * @size:	Size of the decompressed image in bytes
+ * @header:	BMP header of the decompressed image
+ * @pixels:	Image in panel format, NULL if this entry is not in use
+ * @last_used:	Value of image_cache.tick when this entry was last used
+ */
+struct image_cache_entry {
+	const void *src;
+	int x, y;
+	int width, height;
+	uint32_t size;
+	bmp_header_t header;
+	void *pixels;
+	ulong last_used;
+};
+
+/**
+ * struct image_decompress - details of the last VbExDecompress() call
+ *
+ * @inbuf:		Compressed data, in the GBB
+ * @in_size:		Size of compressed data
+ * @compression_type:	Compression type (COMPRESS_...)
+ * @outbuf:		Output buffer for decompressed data
+ * @out_size:		Size of decompressed data
+ * @deferred:		1 if we have not actually decompressed yet
+ */
+struct image_decompress {
+	void *inbuf;
+	uint32_t in_size;
+	uint32_t compression_type;
+	void *outbuf;
+	uint32_t out_size;
+	int deferred;
+};
+
+static struct {
+	struct image_cache_entry entry[CONFIG_CHROMEOS_DISPLAY_CACHE_ENTRIES];
+	ulong bytes;		/* Total size of cached pixels */
+	ulong tick;		/* Incremented each time an image is shown */
+	ulong hits;
+	ulong misses;
+	struct image_decompress last;
+} image_cache;
+
+static struct image_cache_entry *image_cache_find(const void *src,
+						  int any_pos, int x, int y)
+{
+	struct image_cache_entry *entry;
+	int i;
+
+	for (i = 0, entry = image_cache.entry;
+	     i < CONFIG_CHROMEOS_DISPLAY_CACHE_ENTRIES; i++, entry++) {
+		if (entry->pixels && entry->src == src &&
+		    (any_pos || (entry->x == x && entry->y == y)))
+			return entry;
+	}
+
+	return NULL;
+}
+
+static void image_cache_free(struct image_cache_entry *entry)
+{
+	image_cache.bytes -= entry->width * entry->height *
+			NBITS(panel_info.vl_bpix) / 8;
+	free(entry->pixels);
+	entry->pixels = NULL;
+}
+
+/* Find a free entry, throwing out old ones to make room for @bytes */
+static struct image_cache_entry *image_cache_alloc(ulong bytes)
+{
+	struct image_cache_entry *entry, *free_entry, *oldest;
+	int i;
+
+	if (!bytes || bytes > CONFIG_CHROMEOS_DISPLAY_CACHE_SIZE)
+		return NULL;
+	for (;;) {
+		free_entry = oldest = NULL;
+		for (i = 0, entry = image_cache.entry;
+		     i < CONFIG_CHROMEOS_DISPLAY_CACHE_ENTRIES; i++, entry++) {
+			if (!entry->pixels)
+				free_entry = entry;
+			else if (!oldest || entry->last_used < oldest->last_used)
+				oldest = entry;
+		}
+		if (free_entry && image_cache.bytes + bytes <=
+				CONFIG_CHROMEOS_DISPLAY_CACHE_SIZE)
+			break;
+		image_cache_free(oldest);
+	}
+
+	free_entry->pixels = malloc(bytes);
+	if (!free_entry->pixels)
+		return NULL;
+	image_cache.bytes += bytes;
+
+	return free_entry;
+}
+
+/* Add an image just drawn by lcd_display_bitmap() to the cache */
+static void image_cache_add(const void *src, int x, int y,
+			    const bmp_image_t *bmp, uint32_t size)
+{
+	struct image_cache_entry *entry;
+	int width, height;
 
+	width = get_unaligned_le32(&bmp->header.width);
+	height = get_unaligned_le32(&bmp->header.height);
+	if (x < 0 || y < 0 || x >= panel_info.vl_col ||
+	    y >= panel_info.vl_row)
+		return;
+	width = min(width, panel_info.vl_col - x);
+	height = min(height, panel_info.vl_row - y);
+
+	entry = image_cache_alloc(width * height *
+				  NBITS(panel_info.vl_bpix) / 8);
+	if (!entry)
+		return;
+	entry->src = src;
+	entry->x = x;
+	entry->y = y;
+	entry->width = width;
+	entry->height = height;
+	entry->size = size;
+	memcpy(&entry->header, &bmp->header, sizeof(entry->header));
+	entry->last_used = image_cache.tick;
+	lcd_read_rect(x, y, width, height, entry->pixels);
+}
+
+/*
+ * If the image is in the cache, we can avoid decompressing it. We just
+ * fill in the header, which is enough for vboot and sanity_check_bitmap().
+ *
+ * Returns 1 if decompression was deferred, 0 if the caller must do it
+ */
+static int image_cache_defer(void *inbuf, uint32_t in_size,
+			     uint32_t compression_type,
+			     void *outbuf, uint32_t *out_size)
+{
+	struct image_decompress *last = &image_cache.last;
+	struct image_cache_entry *entry;
+
+	last->inbuf = inbuf;
+	last->in_size = in_size;
+	last->compression_type = compression_type;
+	last->outbuf = outbuf;
+	last->deferred = 0;
+
+	entry = image_cache_find(inbuf, 1, 0, 0);
+	if (!entry || entry->size > *out_size ||
+	    entry->size < sizeof(entry->header))
+		return 0;
+	memcpy(outbuf, &entry->header, sizeof(entry->header));
+	*out_size = entry->size;
+	last->out_size = *out_size;
+	last->deferred = 1;
+
+	return 1;
+}
+
+/*
+ * Show an image from the cache if we can. If not, make sure that it is
+ * decompressed ready for drawing.
+ *
+ * Returns 0 if shown, 1 if the caller must draw it, -1 on error
+ */
+static int image_cache_show(const void *src, void *buffer, int x, int y)
+{
+	struct image_decompress *last = &image_cache.last;
+	struct image_cache_entry *entry;
+
+	image_cache.tick++;
+	entry = image_cache_find(src, 0, x, y);
+	if (entry) {
+		image_cache.hits++;
+		entry->last_used = image_cache.tick;
+		lcd_write_rect(entry->x, entry->y, entry->width, entry->height,
+			       entry->pixels);
+		return 0;
+	}
+	image_cache.misses++;
+
+	if (buffer == last->outbuf && last->deferred) {
+		last->deferred = 0;
+		if (decompress(last->inbuf, last->in_size,
+			       last->compression_type, last->outbuf,
+			       &last->out_size))
+			return -1;
+	}
+
+	return 1;
+}
+
+static int do_vboot_display_cache(cmd_tbl_t *cmdtp, int flag, int argc,
+				  char *const argv[])
+{
+	int i;
+
+	if (argc > 1) {
+		if (strcmp(argv[1], "flush"))
+			return CMD_RET_USAGE;
+		for (i = 0; i < CONFIG_CHROMEOS_DISPLAY_CACHE_ENTRIES; i++) {
+			if (image_cache.entry[i].pixels)
+				image_cache_free(&image_cache.entry[i]);
+		}
+		image_cache.hits = 0;
+		image_cache.misses = 0;
+		return 0;
+	}
+
+	printf("Bytes cached: %lu of %lu\n", image_cache.bytes,
+	       (ulong)CONFIG_CHROMEOS_DISPLAY_CACHE_SIZE);
+	printf("Hits:         %lu\n", image_cache.hits);
+	printf("Misses:       %lu\n", image_cache.misses);
+
+	return 0;
+}
+
+U_BOOT_CMD(
+	vbdisplaycache,	2,	1,	do_vboot_display_cache,
+	"show vboot display cache statistics",
+	"       - show cache usage, hits and misses\n"
+	"vbdisplaycache flush - empty the cache"
+);
+#endif /* CONFIG_CHROMEOS_DISPLAY_CACHE */
+
+VbError_t VbExDecompress(void *inbuf, uint32_t in_size,
+                         uint32_t compression_type,
+                         void *outbuf, uint32_t *out_size)
+{
+#ifdef CONFIG_CHROMEOS_DISPLAY_CACHE
+	if (image_cache_defer(inbuf, in_size, compression_type, outbuf,
+			      out_size))
+		return VBERROR_SUCCESS;
+#endif
+	return decompress(inbuf, in_size, compression_type, outbuf, out_size);
+}
+
+
+#ifdef CONFIG_CHROMEOS_DISPLAY
 static int sanity_check_bitmap(void *buffer, uint32_t buffersize)
 {
 	bmp_image_t *bmp;
@@ -288,6 +556,18 @@ VbError_t VbExDisplayImage(uint32_t x, uint32_t y,
 {
 #ifdef CONFIG_CHROMEOS_DISPLAY
 	int ret;
+#ifdef CONFIG_CHROMEOS_DISPLAY_CACHE
+	const void *src = buffer;
+
+	/* Use the image's address in the GBB if it was decompressed */
+	if (buffer == image_cache.last.outbuf)
+		src = image_cache.last.inbuf;
+	ret = image_cache_show(src, buffer, x, y);
+	if (ret <= 0) {
+		image_cache.last.outbuf = NULL;
+		return ret ? VBERROR_UNKNOWN : VBERROR_SUCCESS;
+	}
+#endif
 
 	if (sanity_check_bitmap(buffer, buffersize))
 		return VBERROR_INVALID_BMPFV;
@@ -297,6 +577,10 @@ VbError_t VbExDisplayImage(uint32_t x, uint32_t y,
 		VBDEBUG("LCD display error.\n");
 		return VBERROR_UNKNOWN;
 	}
+#ifdef CONFIG_CHROMEOS_DISPLAY_CACHE
+	image_cache_add(src, x, y, buffer, buffersize);
+	image_cache.last.outbuf = NULL;
+#endif
 #endif
 	return VBERROR_SUCCESS;
 }
@@ -251,6 +251,8 @@ void init_part (block_dev_desc_t * dev_desc)
 
 /* must be placed before DOS partition detection */
 #ifdef CONFIG_EFI_PARTITION
+	/* The device may have changed, so forget what we knew */
+	part_efi_invalidate(dev_desc);
 	if (test_part_efi(dev_desc) == 0) {
 		dev_desc->part_type = PART_TYPE_EFI;
 		return;
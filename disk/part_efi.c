@@ -101,6 +101,142 @@ static void uuid_string(unsigned char *uuid, char *str)
 
 static efi_guid_t system_guid = PARTITION_SYSTEM_GUID;
 
+#ifdef CONFIG_EFI_PARTITION_CACHE
+/*
+ * Validating the GPT means reading the header and the whole partition
+ * table and checking both CRCs. Callers such as vboot and the filesystem
+ * code look up partitions over and over, so we keep the validated GPT for
+ * each device until something tells us that it may have changed.
+ */
+
+/**
+ * struct gpt_cache - a validated primary GPT
+ *
+ * @header:	GPT header, padded to a block
+ * @pte:	Partition table entries
+ * @blocks:	Number of blocks read to validate this GPT
+ */
+struct gpt_cache {
+	gpt_header *header;
+	gpt_entry *pte;
+	ulong blocks;
+};
+
+static ulong gpt_cache_hits;		/* Lookups satisfied from the cache */
+static ulong gpt_cache_misses;		/* Lookups which read the device */
+static ulong gpt_cache_blocks_saved;	/* Block reads avoided */
+
+void part_efi_invalidate(block_dev_desc_t *dev_desc)
+{
+	struct gpt_cache *cache = dev_desc->gpt_cache;
+
+	if (!cache)
+		return;
+	free(cache->pte);
+	free(cache->header);
+	free(cache);
+	dev_desc->gpt_cache = NULL;
+}
+
+void part_efi_note_write(block_dev_desc_t *dev_desc, lbaint_t start,
+			 lbaint_t blkcnt)
+{
+	gpt_header *gpt_head;
+
+	if (!dev_desc->gpt_cache)
+		return;
+
+	/* Both GPTs lie outside the usable area, so writes inside it are OK */
+	gpt_head = dev_desc->gpt_cache->header;
+	if (start < le64_to_cpu(gpt_head->first_usable_lba) ||
+	    start + blkcnt > le64_to_cpu(gpt_head->last_usable_lba) + 1)
+		part_efi_invalidate(dev_desc);
+}
+
+void part_efi_print_cache_stats(void)
+{
+	printf("GPT cache hits:     %lu\n", gpt_cache_hits);
+	printf("GPT cache misses:   %lu\n", gpt_cache_misses);
+	printf("Block reads saved:  %lu\n", gpt_cache_blocks_saved);
+}
+#endif
+
+/**
+ * get_gpt() - Get the validated primary GPT for a device
+ *
+ * @dev_desc - block device descriptor
+ * @pgpt_head - returns a pointer to the GPT header
+ * @pgpt_pte - returns a pointer to the partition table entries
+ *
+ * Description: returns 1 if valid, 0 on error. The GPT may come from the
+ * cache, so release it with put_gpt() rather than freeing it.
+ */
+static int get_gpt(block_dev_desc_t *dev_desc, gpt_header **pgpt_head,
+		   gpt_entry **pgpt_pte)
+{
+	gpt_header *gpt_head;
+#ifdef CONFIG_EFI_PARTITION_CACHE
+	struct gpt_cache *cache = dev_desc->gpt_cache;
+
+	if (cache) {
+		gpt_cache_hits++;
+		gpt_cache_blocks_saved += cache->blocks;
+		*pgpt_head = cache->header;
+		*pgpt_pte = cache->pte;
+		return 1;
+	}
+	gpt_cache_misses++;
+#endif
+
+	gpt_head = memalign(ARCH_DMA_MINALIGN,
+			    PAD_TO_BLOCKSIZE(sizeof(gpt_header), dev_desc));
+	if (!gpt_head) {
+		printf("%s: memalign failed\n", __func__);
+		return 0;
+	}
+
+	/* This function validates AND fills in the GPT header and PTE */
+	if (is_gpt_valid(dev_desc, GPT_PRIMARY_PARTITION_TABLE_LBA,
+			 gpt_head, pgpt_pte) != 1) {
+		free(gpt_head);
+		return 0;
+	}
+	*pgpt_head = gpt_head;
+
+#ifdef CONFIG_EFI_PARTITION_CACHE
+	cache = malloc(sizeof(*cache));
+	if (cache) {
+		cache->header = gpt_head;
+		cache->pte = *pgpt_pte;
+		cache->blocks = 1 + BLOCK_CNT(
+			le32_to_cpu(gpt_head->num_partition_entries) *
+			le32_to_cpu(gpt_head->sizeof_partition_entry),
+			dev_desc);
+		dev_desc->gpt_cache = cache;
+	}
+#endif
+
+	return 1;
+}
+
+/**
+ * put_gpt() - Release a GPT obtained from get_gpt()
+ *
+ * @dev_desc - block device descriptor
+ * @gpt_head - GPT header
+ * @gpt_pte - partition table entries
+ */
+static void put_gpt(block_dev_desc_t *dev_desc, gpt_header *gpt_head,
+		    gpt_entry *gpt_pte)
+{
+#ifdef CONFIG_EFI_PARTITION_CACHE
+	if (dev_desc->gpt_cache && dev_desc->gpt_cache->header == gpt_head)
+		return;
+#endif
+	free(gpt_pte);
+	free(gpt_head);
+}
+
 static inline int is_bootable(gpt_entry *p)
 {
 	return p->attributes.fields.legacy_bios_bootable ||
@@ -115,7 +251,7 @@ static inline int is_bootable(gpt_entry *p)
 
 void print_part_efi(block_dev_desc_t * dev_desc)
 {
-	ALLOC_CACHE_ALIGN_BUFFER_PAD(gpt_header, gpt_head, 1, dev_desc->blksz);
+	gpt_header *gpt_head;
 	gpt_entry *gpt_pte = NULL;
 	int i = 0;
 	char uuid[37];
@@ -124,9 +260,7 @@ void print_part_efi(block_dev_desc_t * dev_desc)
 		printf("%s: Invalid Argument(s)\n", __func__);
 		return;
 	}
-	/* This function validates AND fills in the GPT header and PTE */
-	if (is_gpt_valid(dev_desc, GPT_PRIMARY_PARTITION_TABLE_LBA,
-			 gpt_head, &gpt_pte) != 1) {
+	if (get_gpt(dev_desc, &gpt_head, &gpt_pte) != 1) {
 		printf("%s: *** ERROR: Invalid GPT ***\n", __func__);
 		return;
 	}
@@ -154,15 +288,14 @@ void print_part_efi(block_dev_desc_t * dev_desc)
 		printf("\tuuid:\t%s\n", uuid);
 	}
 
-	/* Remember to free pte */
-	free(gpt_pte);
+	put_gpt(dev_desc, gpt_head, gpt_pte);
 	return;
 }
 
 int get_partition_info_efi(block_dev_desc_t * dev_desc, int part,
 				disk_partition_t * info)
 {
-	ALLOC_CACHE_ALIGN_BUFFER_PAD(gpt_header, gpt_head, 1, dev_desc->blksz);
+	gpt_header *gpt_head;
 	gpt_entry *gpt_pte = NULL;
 
 	/* "part" argument must be at least 1 */
@@ -171,9 +304,7 @@ int get_partition_info_efi(block_dev_desc_t * dev_desc, int part,
 		return -1;
 	}
 
-	/* This function validates AND fills in the GPT header and PTE */
-	if (is_gpt_valid(dev_desc, GPT_PRIMARY_PARTITION_TABLE_LBA,
-			gpt_head, &gpt_pte) != 1) {
+	if (get_gpt(dev_desc, &gpt_head, &gpt_pte) != 1) {
 		printf("%s: *** ERROR: Invalid GPT ***\n", __func__);
 		return -1;
 	}
@@ -182,6 +313,7 @@ int get_partition_info_efi(block_dev_desc_t * dev_desc, int part,
 	    !is_pte_valid(&gpt_pte[part - 1])) {
 		printf("%s: *** ERROR: Invalid partition number %d ***\n",
 			__func__, part);
+		put_gpt(dev_desc, gpt_head, gpt_pte);
 		return -1;
 	}
 
@@ -203,8 +335,7 @@ int get_partition_info_efi(block_dev_desc_t * dev_desc, int part,
 	debug("%s: start 0x%lX, size 0x%lX, name %s", __func__,
 		info->start, info->size, info->name);
 
-	/* Remember to free pte */
-	free(gpt_pte);
+	put_gpt(dev_desc, gpt_head, gpt_pte);
 	return 0;
 }
 
@@ -316,6 +447,9 @@ int write_gpt_table(block_dev_desc_t *dev_desc,
 	u32 calc_crc32;
 	u64 val;
 
+	/* Whatever happens, the cached GPT is no longer valid */
+	part_efi_invalidate(dev_desc);
+
 	debug("max lba: %x\n", (u32) dev_desc->lba);
 	/* Setup the Protective MBR */
 	if (set_protective_mbr(dev_desc) < 0)
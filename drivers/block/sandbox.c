@@ -60,6 +60,7 @@ static unsigned long host_block_write(int dev, unsigned long start,
 				      lbaint_t blkcnt, const void *buffer)
 {
 	struct host_block_dev *host_dev = find_host_device(dev);
+	part_efi_note_write(&host_dev->blk_dev, start, blkcnt);
 	if (os_lseek(host_dev->fd,
 		     start * host_dev->blk_dev.blksz,
 		     OS_SEEK_SET) == -1) {
@@ -72,6 +72,32 @@ static int dfu_write_buffer_drain(struct dfu_entity *dfu)
 	return ret;
 }
 
+/*
+ * Pass a chunk straight to the medium as it arrives, without copying it to
+ * dfu_buf first. This lets writing start with the first chunk and removes
+ * the limit on the amount of data.
+ */
+static int dfu_write_stream(struct dfu_entity *dfu, void *buf, int size)
+{
+	long w_size = size;
+	int ret;
+
+	if (!size)
+		return 0;
+
+	dfu->crc = crc32(dfu->crc, buf, size);
+	ret = dfu->write_medium(dfu, dfu->offset, buf, &w_size);
+	if (ret)
+		debug("%s: Write error!\n", __func__);
+
+	/* Show progress every MiB */
+	if ((dfu->offset + size) >> 20 != dfu->offset >> 20)
+		puts("#");
+	dfu->offset += size;
+
+	return ret;
+}
+
 int dfu_write(struct dfu_entity *dfu, void *buf, int size, int blk_seq_num)
 {
 	int ret = 0;
@@ -116,6 +142,11 @@ int dfu_write(struct dfu_entity *dfu, void *buf, int size, int blk_seq_num)
 	/* handle rollover */
 	dfu->i_blk_seq_num = (dfu->i_blk_seq_num + 1) & 0xffff;
 
+	if (dfu->stream) {
+		ret = dfu_write_stream(dfu, buf, size);
+		goto done;
+	}
+
 	/* flush buffer if overflow */
 	if ((dfu->i_buf + size) > dfu->i_buf_end) {
 		tret = dfu_write_buffer_drain(dfu);
@@ -140,6 +171,7 @@ int dfu_write(struct dfu_entity *dfu, void *buf, int size, int blk_seq_num)
 			ret = tret;
 	}
 
+done:
 	/* end? */
 	if (size == 0) {
 		/* Now try and flush to the medium if needed. */
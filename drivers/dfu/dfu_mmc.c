@@ -24,6 +24,7 @@
 #include <errno.h>
 #include <div64.h>
 #include <dfu.h>
+#include <fs.h>
 
 enum dfu_mmc_op {
 	DFU_OP_READ = 1,
@@ -34,11 +35,28 @@ static unsigned char __aligned(CONFIG_SYS_CACHELINE_SIZE)
 				dfu_file_buf[CONFIG_SYS_DFU_MAX_FILE_SIZE];
 static long dfu_file_buf_len;
 
+/*
+ * Raw writes arrive in chunks which need not be a whole number of blocks.
+ * The bytes after the last whole block are kept here until the next chunk
+ * completes the block, or the transfer ends.
+ */
+static unsigned char __aligned(ARCH_DMA_MINALIGN)
+				dfu_raw_tail[MMC_MAX_BLOCK_LEN];
+static long dfu_raw_tail_len;
+
 static int mmc_block_op(enum dfu_mmc_op op, struct dfu_entity *dfu,
 			u64 offset, void *buf, long *len)
 {
-	char cmd_buf[DFU_CMD_BUF_SIZE];
-	u32 blk_start, blk_count;
+	struct mmc *mmc = find_mmc_device(dfu->dev_num);
+	u32 blk_start, blk_count, n;
+	void *bounce = NULL;
+	long size = *len;
+
+	if (!mmc || mmc_init(mmc)) {
+		printf("%s: Device MMC %d not found\n", __func__,
+		       dfu->dev_num);
+		return -ENODEV;
+	}
 
 	/*
 	 * We must ensure that we work in lba_blk_size chunks, so ALIGN
@@ -55,17 +73,105 @@ static int mmc_block_op(enum dfu_mmc_op op, struct dfu_entity *dfu,
 		return -EINVAL;
 	}
 
-	sprintf(cmd_buf, "mmc %s %p %x %x",
-		op == DFU_OP_READ ? "read" : "write",
-		 buf, blk_start, blk_count);
+	/*
+	 * Pad a partial last block so we don't write what lies beyond buf,
+	 * and bounce a buffer which the controller cannot DMA from
+	 */
+	if (op == DFU_OP_WRITE && (size != *len ||
+				   ((ulong)buf & (ARCH_DMA_MINALIGN - 1)))) {
+		bounce = memalign(ARCH_DMA_MINALIGN, *len);
+		if (!bounce)
+			return -ENOMEM;
+		memcpy(bounce, buf, size);
+		memset(bounce + size, '\0', *len - size);
+		buf = bounce;
+	}
 
-	debug("%s: %s 0x%p\n", __func__, cmd_buf, cmd_buf);
-	return run_command(cmd_buf, 0);
+	debug("%s: %s dev %d blk %#x count %#x\n", __func__,
+	      op == DFU_OP_READ ? "read" : "write", dfu->dev_num, blk_start,
+	      blk_count);
+	if (op == DFU_OP_READ)
+		n = mmc->block_dev.block_read(dfu->dev_num, blk_start,
+					      blk_count, buf);
+	else
+		n = mmc->block_dev.block_write(dfu->dev_num, blk_start,
+					       blk_count, buf);
+	free(bounce);
+	if (n != blk_count) {
+		printf("%s: MMC %s failed\n", __func__,
+		       op == DFU_OP_READ ? "read" : "write");
+		return -EIO;
+	}
+
+	return 0;
+}
+
+static int mmc_raw_write(struct dfu_entity *dfu, u64 offset, void *buf,
+			 long *len)
+{
+	long blk_size = dfu->data.mmc.lba_blk_size;
+	long size = *len;
+	long whole, n;
+	int ret;
+
+	if (blk_size > sizeof(dfu_raw_tail)) {
+		printf("%s: Block size %ld too large\n", __func__, blk_size);
+		return -EINVAL;
+	}
+
+	/* A new transfer starts at offset 0 */
+	if (!offset)
+		dfu_raw_tail_len = 0;
+
+	/* Complete the block left over from the last chunk, if we can */
+	if (dfu_raw_tail_len) {
+		n = min(blk_size - dfu_raw_tail_len, size);
+		memcpy(dfu_raw_tail + dfu_raw_tail_len, buf, n);
+		dfu_raw_tail_len += n;
+		if (dfu_raw_tail_len < blk_size)
+			return 0;
+		whole = blk_size;
+		ret = mmc_block_op(DFU_OP_WRITE, dfu, offset - (blk_size - n),
+				   dfu_raw_tail, &whole);
+		dfu_raw_tail_len = 0;
+		if (ret)
+			return ret;
+		buf += n;
+		size -= n;
+		offset += n;
+	}
+
+	/* Write the whole blocks and keep the rest for next time */
+	whole = size - size % blk_size;
+	if (whole) {
+		ret = mmc_block_op(DFU_OP_WRITE, dfu, offset, buf, &whole);
+		if (ret)
+			return ret;
+	}
+	dfu_raw_tail_len = size - whole;
+	memcpy(dfu_raw_tail, buf + whole, dfu_raw_tail_len);
+
+	return 0;
+}
+
+static int mmc_raw_flush(struct dfu_entity *dfu)
+{
+	long len = dfu_raw_tail_len;
+
+	if (!len)
+		return 0;
+	dfu_raw_tail_len = 0;
+
+	/* mmc_block_op() pads this out to a whole block */
+	return mmc_block_op(DFU_OP_WRITE, dfu, dfu->offset - len,
+			    dfu_raw_tail, &len);
 }
 
 static int mmc_file_buffer(struct dfu_entity *dfu, void *buf, long *len)
 {
 	if (dfu_file_buf_len + *len > CONFIG_SYS_DFU_MAX_FILE_SIZE) {
+		printf("%s: File too large for %d byte buffer\n", __func__,
+		       CONFIG_SYS_DFU_MAX_FILE_SIZE);
 		dfu_file_buf_len = 0;
 		return -EINVAL;
 	}
@@ -80,24 +186,19 @@ static int mmc_file_buffer(struct dfu_entity *dfu, void *buf, long *len)
 static int mmc_file_op(enum dfu_mmc_op op, struct dfu_entity *dfu,
 			void *buf, long *len)
 {
-	char cmd_buf[DFU_CMD_BUF_SIZE];
-	char *str_env;
+	char dev_part_str[16];
+	char fname[DFU_NAME_SIZE + 1];
+	int fstype;
 	int ret;
 
 	switch (dfu->layout) {
 	case DFU_FS_FAT:
-		sprintf(cmd_buf, "fat%s mmc %d:%d 0x%x %s",
-			op == DFU_OP_READ ? "load" : "write",
-			dfu->data.mmc.dev, dfu->data.mmc.part,
-			(unsigned int) buf, dfu->name);
-		if (op == DFU_OP_WRITE)
-			sprintf(cmd_buf + strlen(cmd_buf), " %lx", *len);
+		fstype = FS_TYPE_FAT;
+		strcpy(fname, dfu->name);
 		break;
 	case DFU_FS_EXT4:
-		sprintf(cmd_buf, "ext4%s mmc %d:%d 0x%x /%s",
-			op == DFU_OP_READ ? "load" : "write",
-			dfu->data.mmc.dev, dfu->data.mmc.part,
-			(unsigned int) buf, dfu->name);
+		fstype = FS_TYPE_EXT;
+		sprintf(fname, "/%s", dfu->name);
 		break;
 	default:
 		printf("%s: Layout (%s) not (yet) supported!\n", __func__,
@@ -105,24 +206,26 @@ static int mmc_file_op(enum dfu_mmc_op op, struct dfu_entity *dfu,
 		return -1;
 	}
 
-	debug("%s: %s 0x%p\n", __func__, cmd_buf, cmd_buf);
-
-	ret = run_command(cmd_buf, 0);
-	if (ret) {
-		puts("dfu: Read error!\n");
-		return ret;
+	sprintf(dev_part_str, "%d:%d", dfu->data.mmc.dev, dfu->data.mmc.part);
+	if (fs_set_blk_dev("mmc", dev_part_str, fstype)) {
+		printf("dfu: Cannot find %s filesystem on mmc %s\n",
+		       dfu_get_layout(dfu->layout), dev_part_str);
+		return -ENODEV;
 	}
 
-	if (dfu->layout != DFU_RAW_ADDR && op == DFU_OP_READ) {
-		str_env = getenv("filesize");
-		if (str_env == NULL) {
-			puts("dfu: Wrong file size!\n");
-			return -1;
-		}
-		*len = simple_strtoul(str_env, NULL, 16);
+	debug("%s: %s %s %s\n", __func__, op == DFU_OP_READ ? "read" : "write",
+	      dev_part_str, fname);
+	if (op == DFU_OP_READ)
+		ret = fs_read(fname, map_to_sysmem(buf), 0, 0);
+	else
+		ret = fs_write(fname, map_to_sysmem(buf), 0, *len);
+	if (ret < 0) {
+		printf("dfu: %s error!\n", op == DFU_OP_READ ? "Read" : "Write");
+		return ret;
 	}
+	*len = ret;
 
-	return ret;
+	return 0;
 }
 
 int dfu_write_medium_mmc(struct dfu_entity *dfu,
@@ -132,7 +235,7 @@ int dfu_write_medium_mmc(struct dfu_entity *dfu,
 
 	switch (dfu->layout) {
 	case DFU_RAW_ADDR:
-		ret = mmc_block_op(DFU_OP_WRITE, dfu, offset, buf, len);
+		ret = mmc_raw_write(dfu, offset, buf, len);
 		break;
 	case DFU_FS_FAT:
 	case DFU_FS_EXT4:
@@ -148,16 +251,15 @@ int dfu_write_medium_mmc(struct dfu_entity *dfu,
 
 int dfu_flush_medium_mmc(struct dfu_entity *dfu)
 {
-	int ret = 0;
+	int ret;
 
-	if (dfu->layout != DFU_RAW_ADDR) {
-		/* Do stuff here. */
-		ret = mmc_file_op(DFU_OP_WRITE, dfu, &dfu_file_buf,
-				&dfu_file_buf_len);
+	if (dfu->layout == DFU_RAW_ADDR)
+		return mmc_raw_flush(dfu);
 
-		/* Now that we're done */
-		dfu_file_buf_len = 0;
-	}
+	ret = mmc_file_op(DFU_OP_WRITE, dfu, dfu_file_buf, &dfu_file_buf_len);
+
+	/* Now that we're done */
+	dfu_file_buf_len = 0;
 
 	return ret;
 }
@@ -242,6 +344,9 @@ int dfu_fill_entity_mmc(struct dfu_entity *dfu, char *s)
 	dfu->write_medium = dfu_write_medium_mmc;
 	dfu->flush_medium = dfu_flush_medium_mmc;
 
+	/* Raw writes go straight to the card; file data goes to its buffer */
+	dfu->stream = 1;
+
 	/* initial state */
 	dfu->inited = 0;
 
@@ -278,7 +278,7 @@ int bfin_mmc_init(bd_t *bis)
 {
 	struct mmc *mmc = NULL;
 
-	mmc = malloc(sizeof(struct mmc));
+	mmc = calloc(1, sizeof(struct mmc));
 
 	if (!mmc)
 		return -ENOMEM;
@@ -20,14 +20,13 @@
  */
 
 #include <common.h>
+#include <bouncebuf.h>
 #include <malloc.h>
 #include <mmc.h>
 #include <dwmmc.h>
 #include <asm/arch/clk.h>
 #include <asm-generic/errno.h>
 
-#define PAGE_SIZE 4096
-
 static int dwmci_wait_reset(struct dwmci_host *host, u32 value)
 {
 	unsigned long timeout = 1000;
@@ -43,62 +42,73 @@ static int dwmci_wait_reset(struct dwmci_host *host, u32 value)
 	return 0;
 }
 
-static void dwmci_set_idma_desc(struct dwmci_idmac *idmac,
-		u32 desc0, u32 desc1, u32 desc2)
-{
-	struct dwmci_idmac *desc = idmac;
-
-	desc->flags = desc0;
-	desc->cnt = desc1;
-	desc->addr = desc2;
-	desc->next_addr = (unsigned int)desc + sizeof(struct dwmci_idmac);
-}
-
-static void dwmci_prepare_data(struct dwmci_host *host,
-		struct mmc_data *data)
+static int dwmci_prepare_data(struct dwmci_host *host,
+		struct mmc_data *data, struct bounce_buffer *bbstate)
 {
+	struct dwmci_idmac *desc = host->idmac;
+	struct dwmci_idmac *ring_end = host->idmac + CONFIG_DWMMC_IDMAC_DESC;
 	unsigned long ctrl;
-	unsigned int i = 0, flags, cnt, blk_cnt;
-	ulong data_start, data_end, start_addr, stop_addr;
-	ALLOC_CACHE_ALIGN_BUFFER(struct dwmci_idmac, cur_idmac, data->blocks);
-
+	unsigned int seg, cnt, len, bbflags;
+	int second = 0;
+	ulong addr;
+	void *buf;
+	int ret;
 
-	blk_cnt = data->blocks;
+	/*
+	 * The IDMAC takes a list of descriptors, so we only need to bounce
+	 * the ends of an unaligned buffer.
+	 */
+	if (data->flags & MMC_DATA_READ) {
+		buf = data->dest;
+		bbflags = GEN_BB_WRITE | GEN_BB_SPLIT;
+	} else {
+		buf = (void *)data->src;
+		bbflags = GEN_BB_READ | GEN_BB_SPLIT;
+	}
+	ret = bounce_buffer_start(bbstate, buf, data->blocks * data->blocksize,
+				  bbflags);
+	if (ret)
+		return ret;
 
 	dwmci_wait_reset(host, DWMCI_CTRL_FIFO_RESET);
 
-	data_start = (ulong)cur_idmac;
-	dwmci_writel(host, DWMCI_DBADDR, (unsigned int)cur_idmac);
-
-	if (data->flags == MMC_DATA_READ)
-		start_addr = (unsigned int)data->dest;
-	else
-		start_addr = (unsigned int)data->src;
-
-	do {
-		flags = DWMCI_IDMAC_OWN | DWMCI_IDMAC_CH ;
-		flags |= (i == 0) ? DWMCI_IDMAC_FS : 0;
-		if (blk_cnt <= 8) {
-			flags |= DWMCI_IDMAC_LD;
-			cnt = data->blocksize * blk_cnt;
-		} else
-			cnt = data->blocksize * 8;
-
-		dwmci_set_idma_desc(cur_idmac, flags, cnt,
-				start_addr + (i * PAGE_SIZE));
-
-		if(blk_cnt < 8)
-			break;
-		blk_cnt -= 8;
-		cur_idmac++;
-		i++;
-	} while(1);
+	dwmci_writel(host, DWMCI_DBADDR, (unsigned int)host->idmac);
 
-	data_end = (ulong)cur_idmac;
-	flush_dcache_range(data_start, data_end + ARCH_DMA_MINALIGN);
+	/*
+	 * Use the descriptors in dual-buffer mode, so that each one covers
+	 * up to two buffers of DWMCI_IDMAC_MAX_BUF bytes.
+	 */
+	for (seg = 0; seg < bbstate->num_segs; seg++) {
+		addr = (ulong)bbstate->seg[seg].addr;
+		for (len = bbstate->seg[seg].len; len; len -= cnt, addr += cnt) {
+			cnt = min(len, (unsigned int)DWMCI_IDMAC_MAX_BUF);
+			if (second) {
+				desc->cnt |= DWMCI_IDMAC_BS2(cnt);
+				desc->addr2 = addr;
+				desc++;
+			} else {
+				if (desc == ring_end) {
+					debug("%s: Too many descriptors\n",
+					      __func__);
+					return -EINVAL;
+				}
+				desc->flags = DWMCI_IDMAC_OWN;
+				desc->cnt = DWMCI_IDMAC_BS1(cnt);
+				desc->addr = addr;
+				desc->addr2 = 0;
+			}
+			second = !second;
+		}
+	}
+	if (second)
+		desc++;
+	host->idmac->flags |= DWMCI_IDMAC_FS;
+	desc[-1].flags |= DWMCI_IDMAC_LD;
+	if (desc == ring_end)
+		desc[-1].flags |= DWMCI_IDMAC_ER;
 
-	stop_addr = start_addr + (data->blocks * data->blocksize);
-	flush_dcache_range(start_addr, stop_addr);
+	flush_dcache_range((ulong)host->idmac,
+			   ALIGN((ulong)desc, ARCH_DMA_MINALIGN));
 
 	ctrl = dwmci_readl(host, DWMCI_CTRL);
 	ctrl |= DWMCI_IDMAC_EN | DWMCI_DMA_EN;
@@ -110,6 +120,8 @@ static void dwmci_prepare_data(struct dwmci_host *host,
 
 	dwmci_writel(host, DWMCI_BLKSIZ, data->blocksize);
 	dwmci_writel(host, DWMCI_BYTCNT, data->blocksize * data->blocks);
+
+	return 0;
 }
 
 static int dwmci_set_transfer_mode(struct dwmci_host *host,
@@ -124,16 +136,15 @@ static int dwmci_set_transfer_mode(struct dwmci_host *host,
 	return mode;
 }
 
-static int dwmci_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
-		struct mmc_data *data)
+static int dwmci_send_cmd_bounced(struct mmc *mmc, struct mmc_cmd *cmd,
+		struct mmc_data *data, struct bounce_buffer *bbstate)
 {
 	struct dwmci_host *host = (struct dwmci_host *)mmc->priv;
-	int flags = 0, i;
+	int flags = 0, i, ret;
 	unsigned int timeout = 100000;
 	u32 retry = 10000;
 	u32 mask, ctrl;
 	ulong start = get_timer(0);
-	ulong data_start, data_end;
 
 	while (dwmci_readl(host, DWMCI_STATUS) & DWMCI_BUSY) {
 		if (get_timer(start) > timeout) {
@@ -144,8 +155,11 @@ static int dwmci_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
 
 	dwmci_writel(host, DWMCI_RINTSTS, DWMCI_INTMSK_ALL);
 
-	if (data)
-		dwmci_prepare_data(host, data);
+	if (data) {
+		ret = dwmci_prepare_data(host, data, bbstate);
+		if (ret)
+			return ret;
+	}
 
 	dwmci_writel(host, DWMCI_CMDARG, cmd->cmdarg);
 
@@ -221,23 +235,26 @@ static int dwmci_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
 		ctrl = dwmci_readl(host, DWMCI_CTRL);
 		ctrl &= ~(DWMCI_DMA_EN);
 		dwmci_writel(host, DWMCI_CTRL, ctrl);
-		if (data->flags & MMC_DATA_READ) {
-			data_start = (ulong)data->dest;
-			data_end = (ulong)data->dest +
-				data->blocks * data->blocksize;
-			/*
-			 * The buffer is supposed to have padding to the
-			 * closest cache line boundary.
-			 */
-			invalidate_dcache_range(data_start,
-						ALIGN(data_end,
-						      dcache_get_line_size()));
-		}
 	}
 
 	return 0;
 }
 
+static int dwmci_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
+		struct mmc_data *data)
+{
+	struct bounce_buffer bbstate;
+	int ret;
+
+	/* No segments means that the bounce buffer was not started */
+	bbstate.num_segs = 0;
+	ret = dwmci_send_cmd_bounced(mmc, cmd, data, &bbstate);
+	if (bbstate.num_segs)
+		bounce_buffer_stop(&bbstate);
+
+	return ret;
+}
+
 static int dwmci_setup_bus(struct dwmci_host *host, u32 freq)
 {
 	u32 div, status;
@@ -384,6 +401,16 @@ int add_dwmci(struct dwmci_host *host, u32 max_clk, u32 min_clk, int removable,
 
 	memset(mmc, 0, sizeof(*mmc));
 
+	host->idmac = memalign(ARCH_DMA_MINALIGN,
+			       ALIGN(sizeof(struct dwmci_idmac) *
+				     CONFIG_DWMMC_IDMAC_DESC,
+				     ARCH_DMA_MINALIGN));
+	if (!host->idmac) {
+		printf("mmc descriptor malloc fail!\n");
+		free(mmc);
+		return -1;
+	}
+
 	mmc->priv = host;
 	host->mmc = mmc;
 
@@ -407,6 +434,10 @@ int add_dwmci(struct dwmci_host *host, u32 max_clk, u32 min_clk, int removable,
 	}
 	mmc->host_caps |= MMC_MODE_HS | MMC_MODE_HS_52MHz | MMC_MODE_HC;
 
+	/* Limit transfers to what fits in the ring, allowing for bouncing */
+	mmc->b_max = (CONFIG_DWMMC_IDMAC_DESC * 2 - 2) * DWMCI_IDMAC_MAX_BUF /
+			MMC_MAX_BLOCK_LEN;
+
 	err = mmc_register(mmc);
 
 	/*
@@ -339,7 +339,7 @@ static int mci_init(struct mmc *mmc)
  */
 int atmel_mci_init(void *regs)
 {
-	struct mmc *mmc = malloc(sizeof(struct mmc));
+	struct mmc *mmc = calloc(1, sizeof(struct mmc));
 
 	if (!mmc)
 		return -1;
@@ -271,6 +271,10 @@ mmc_berase(int dev_num, unsigned long start, lbaint_t blkcnt)
 		       mmc->erase_grp_size, start & ~(mmc->erase_grp_size - 1),
 		       ((start + blkcnt + mmc->erase_grp_size)
 		       & ~(mmc->erase_grp_size - 1)) - 1);
+	/* The erase may be widened to whole erase groups, so allow for that */
+	part_efi_note_write(&mmc->block_dev,
+			    start & ~(mmc->erase_grp_size - 1),
+			    blkcnt + 2 * mmc->erase_grp_size);
 
 	while (blk < blkcnt) {
 		blk_r = ((blkcnt - blk) > mmc->erase_grp_size) ?
@@ -353,6 +357,7 @@ mmc_bwrite(int dev_num, ulong start, lbaint_t blkcnt, const void*src)
 	if (!mmc)
 		return 0;
 
+	part_efi_note_write(&mmc->block_dev, start, blkcnt);
 	if (mmc_set_blocklen(mmc, mmc->write_bl_len))
 		return 0;
 
@@ -410,6 +415,8 @@ static int mmc_read_blocks(struct mmc *mmc, void *dst, ulong start,
 static ulong mmc_bread(int dev_num, ulong start, lbaint_t blkcnt, void *dst)
 {
 	lbaint_t cur, blocks_todo = blkcnt;
+	ulong ret = 0;
+	int span;
 
 	if (blkcnt == 0)
 		return 0;
@@ -427,16 +434,21 @@ static ulong mmc_bread(int dev_num, ulong start, lbaint_t blkcnt, void *dst)
 	if (mmc_set_blocklen(mmc, mmc->read_bl_len))
 		return 0;
 
+	span = bootstage_span_begin("mmc_read");
+	bootstage_span_args(span, mmc->name, blkcnt * mmc->read_bl_len);
 	do {
 		cur = (blocks_todo > mmc->b_max) ?  mmc->b_max : blocks_todo;
 		if(mmc_read_blocks(mmc, dst, start, cur) != cur)
-			return 0;
+			goto out;
 		blocks_todo -= cur;
 		start += cur;
 		dst += cur * mmc->read_bl_len;
 	} while (blocks_todo > 0);
+	ret = blkcnt;
+out:
+	bootstage_span_end(span);
 
-	return blkcnt;
+	return ret;
 }
 
 static int mmc_go_idle(struct mmc *mmc)
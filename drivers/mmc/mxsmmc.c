@@ -389,7 +389,7 @@ int mxsmmc_initialize(bd_t *bis, int id, int (*wp)(int), int (*cd)(int))
 	if (!mxs_ssp_bus_id_valid(id))
 		return -ENODEV;
 
-	mmc = malloc(sizeof(struct mmc));
+	mmc = calloc(1, sizeof(struct mmc));
 	if (!mmc)
 		return -ENOMEM;
 
@@ -386,7 +386,7 @@ int pxa_mmc_register(int card_index)
 	uint32_t reg;
 	int ret = -ENOMEM;
 
-	mmc = malloc(sizeof(struct mmc));
+	mmc = calloc(1, sizeof(struct mmc));
 	if (!mmc)
 		goto err0;
 
@@ -426,7 +426,7 @@ int add_sdhci(struct sdhci_host *host, u32 max_clk, u32 min_clk)
 	struct mmc *mmc;
 	unsigned int caps;
 
-	mmc = malloc(sizeof(struct mmc));
+	mmc = calloc(1, sizeof(struct mmc));
 	if (!mmc) {
 		printf("mmc malloc fail!\n");
 		return -1;
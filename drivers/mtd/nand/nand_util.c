@@ -127,7 +127,7 @@ int nand_erase_opts(nand_info_t *meminfo, const nand_erase_options_t *opts)
 					printf("\rSkipping bad block at  "
 					       "0x%08llx                 "
 					       "                         \n",
-					       erase.addr);
+					       (unsigned long long)erase.addr);
 
 				if (!opts->spread)
 					erased_length++;
@@ -170,7 +170,7 @@ int nand_erase_opts(nand_info_t *meminfo, const nand_erase_options_t *opts)
 		}
 
 		if (!opts->quiet) {
-			unsigned long long n = erased_length * 100ULL;
+			uint64_t n = erased_length * 100ULL;
 			int percent;
 
 			do_div(n, erase_length);
@@ -184,11 +184,11 @@ int nand_erase_opts(nand_info_t *meminfo, const nand_erase_options_t *opts)
 				percent_complete = percent;
 
 				printf("\rErasing at 0x%llx -- %3d%% complete.",
-				       erase.addr, percent);
+				       (unsigned long long)erase.addr, percent);
 
 				if (opts->jffs2 && result == 0)
 					printf(" Cleanmarker written at 0x%llx.",
-					       erase.addr);
+					       (unsigned long long)erase.addr);
 			}
 		}
 	}
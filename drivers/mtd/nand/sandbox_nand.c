@@ -0,0 +1,308 @@
+/*
+ * Simulate a NAND flash
+ *
+ * Copyright (c) 2013 The Chromium OS Authors.
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * Licensed under the GPL-2 or later.
+ */
+
+/*
+ * The main area of each page is kept in a file given with --nand, whose
+ * size selects the chip (64MiB to 1GiB, 2KiB pages, 128KiB blocks). The
+ * spare area is kept in memory only, so bad block marks and ECC bytes are
+ * lost on exit. Pages are programmed by clearing bits, as on real NAND, so
+ * a page must be erased before new data can be written to it.
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <malloc.h>
+#include <nand.h>
+#include <os.h>
+
+#include <asm/getopt.h>
+#include <asm/state.h>
+
+#define SANDBOX_NAND_PAGE_SIZE	2048
+#define SANDBOX_NAND_OOB_SIZE	64
+#define SANDBOX_NAND_BLOCK_SIZE	(128 << 10)
+
+/* Micron, 2KiB pages, 64 bytes of OOB, 128KiB blocks, 8-bit bus */
+#define SANDBOX_NAND_MAKER	NAND_MFR_MICRON
+#define SANDBOX_NAND_EXTID	0x15
+
+enum sandbox_nand_mode {
+	NAND_MODE_DATA,		/* read_byte() returns page data */
+	NAND_MODE_ID,		/* read_byte() returns the ID */
+	NAND_MODE_STATUS,	/* read_byte() returns the status */
+};
+
+struct sandbox_nand {
+	int fd;
+	uint64_t size;		/* Size of the main area in bytes */
+	int dev_id;		/* Device ID byte */
+	enum sandbox_nand_mode mode;
+	int page;		/* Page loaded into buf, or -1 */
+	int pos;		/* Position in buf (or ID) for next access */
+	uint8_t *oob;		/* Spare area for every page */
+	uint8_t buf[SANDBOX_NAND_PAGE_SIZE + SANDBOX_NAND_OOB_SIZE];
+};
+
+static struct sandbox_nand sandbox_nand;
+
+/* Device IDs for each supported size, from nand_flash_ids[] */
+static const struct {
+	int size_mb;
+	int dev_id;
+} sandbox_nand_ids[] = {
+	{ 64, 0xf2 },
+	{ 128, 0xf1 },
+	{ 256, 0xda },
+	{ 512, 0xdc },
+	{ 1024, 0xd3 },
+};
+
+static int sandbox_nand_load(struct sandbox_nand *snand, int page)
+{
+	loff_t offset = (loff_t)page * SANDBOX_NAND_PAGE_SIZE;
+
+	if (os_lseek(snand->fd, offset, OS_SEEK_SET) != offset ||
+	    os_read(snand->fd, snand->buf, SANDBOX_NAND_PAGE_SIZE) !=
+			SANDBOX_NAND_PAGE_SIZE) {
+		printf("sandbox_nand: cannot read page %#x\n", page);
+		return -EIO;
+	}
+	memcpy(snand->buf + SANDBOX_NAND_PAGE_SIZE,
+	       snand->oob + page * SANDBOX_NAND_OOB_SIZE,
+	       SANDBOX_NAND_OOB_SIZE);
+	snand->page = page;
+
+	return 0;
+}
+
+static int sandbox_nand_store(struct sandbox_nand *snand, int page,
+			      const uint8_t *buf)
+{
+	loff_t offset = (loff_t)page * SANDBOX_NAND_PAGE_SIZE;
+
+	if (os_lseek(snand->fd, offset, OS_SEEK_SET) != offset ||
+	    os_write(snand->fd, buf, SANDBOX_NAND_PAGE_SIZE) !=
+			SANDBOX_NAND_PAGE_SIZE) {
+		printf("sandbox_nand: cannot write page %#x\n", page);
+		return -EIO;
+	}
+	memcpy(snand->oob + page * SANDBOX_NAND_OOB_SIZE,
+	       buf + SANDBOX_NAND_PAGE_SIZE, SANDBOX_NAND_OOB_SIZE);
+
+	return 0;
+}
+
+static int sandbox_nand_program(struct sandbox_nand *snand)
+{
+	uint8_t new[sizeof(snand->buf)];
+	int i;
+
+	/* Programming can only clear bits */
+	memcpy(new, snand->buf, sizeof(new));
+	if (sandbox_nand_load(snand, snand->page))
+		return -EIO;
+	for (i = 0; i < sizeof(new); i++)
+		new[i] &= snand->buf[i];
+
+	return sandbox_nand_store(snand, snand->page, new);
+}
+
+static int sandbox_nand_erase(struct sandbox_nand *snand, int page)
+{
+	int pages = SANDBOX_NAND_BLOCK_SIZE / SANDBOX_NAND_PAGE_SIZE;
+	uint8_t blank[sizeof(snand->buf)];
+	int i;
+
+	memset(blank, 0xff, sizeof(blank));
+	page &= ~(pages - 1);
+	for (i = 0; i < pages; i++) {
+		if (sandbox_nand_store(snand, page + i, blank))
+			return -EIO;
+	}
+
+	return 0;
+}
+
+static void sandbox_nand_cmdfunc(struct mtd_info *mtd, unsigned command,
+				 int column, int page_addr)
+{
+	struct sandbox_nand *snand = &sandbox_nand;
+
+	snand->mode = NAND_MODE_DATA;
+	switch (command) {
+	case NAND_CMD_RESET:
+		break;
+	case NAND_CMD_READID:
+		snand->mode = NAND_MODE_ID;
+		snand->pos = 0;
+		break;
+	case NAND_CMD_STATUS:
+		snand->mode = NAND_MODE_STATUS;
+		break;
+	case NAND_CMD_READ0:
+	case NAND_CMD_READOOB:
+		if (command == NAND_CMD_READOOB)
+			column += SANDBOX_NAND_PAGE_SIZE;
+		sandbox_nand_load(snand, page_addr);
+		snand->pos = column;
+		break;
+	case NAND_CMD_SEQIN:
+		memset(snand->buf, 0xff, sizeof(snand->buf));
+		snand->page = page_addr;
+		snand->pos = column;
+		break;
+	case NAND_CMD_RNDOUT:
+	case NAND_CMD_RNDIN:
+		snand->pos = column;
+		break;
+	case NAND_CMD_PAGEPROG:
+		sandbox_nand_program(snand);
+		break;
+	case NAND_CMD_ERASE1:
+		sandbox_nand_erase(snand, page_addr);
+		break;
+	case NAND_CMD_ERASE2:
+		break;
+	default:
+		debug("sandbox_nand: unknown command %#x\n", command);
+		break;
+	}
+}
+
+static uint8_t sandbox_nand_read_byte(struct mtd_info *mtd)
+{
+	struct sandbox_nand *snand = &sandbox_nand;
+	uint8_t id[] = { SANDBOX_NAND_MAKER, snand->dev_id, 0x00,
+			SANDBOX_NAND_EXTID };
+
+	switch (snand->mode) {
+	case NAND_MODE_ID:
+		if (snand->pos < sizeof(id))
+			return id[snand->pos++];
+		return 0;
+	case NAND_MODE_STATUS:
+		return NAND_STATUS_READY | NAND_STATUS_TRUE_READY |
+			NAND_STATUS_WP;
+	case NAND_MODE_DATA:
+	default:
+		if (snand->pos < sizeof(snand->buf))
+			return snand->buf[snand->pos++];
+		return 0xff;
+	}
+}
+
+static void sandbox_nand_read_buf(struct mtd_info *mtd, uint8_t *buf, int len)
+{
+	struct sandbox_nand *snand = &sandbox_nand;
+
+	len = min(len, (int)sizeof(snand->buf) - snand->pos);
+	memcpy(buf, snand->buf + snand->pos, len);
+	snand->pos += len;
+}
+
+static void sandbox_nand_write_buf(struct mtd_info *mtd, const uint8_t *buf,
+				   int len)
+{
+	struct sandbox_nand *snand = &sandbox_nand;
+
+	len = min(len, (int)sizeof(snand->buf) - snand->pos);
+	memcpy(snand->buf + snand->pos, buf, len);
+	snand->pos += len;
+}
+
+static int sandbox_nand_dev_ready(struct mtd_info *mtd)
+{
+	return 1;
+}
+
+static void sandbox_nand_select_chip(struct mtd_info *mtd, int chip)
+{
+}
+
+/* The emulated flash never corrupts data, so ECC is not needed */
+static void sandbox_nand_hwctl(struct mtd_info *mtd, int mode)
+{
+}
+
+static int sandbox_nand_calculate(struct mtd_info *mtd, const uint8_t *dat,
+				  uint8_t *ecc_code)
+{
+	memset(ecc_code, '\0', 3);
+
+	return 0;
+}
+
+static int sandbox_nand_correct(struct mtd_info *mtd, uint8_t *dat,
+				uint8_t *read_ecc, uint8_t *calc_ecc)
+{
+	return 0;
+}
+
+int board_nand_init(struct nand_chip *nand)
+{
+	struct sandbox_state *state = state_get_current();
+	struct sandbox_nand *snand = &sandbox_nand;
+	ssize_t size;
+	int i;
+
+	if (!state->nand_fname)
+		return -ENODEV;
+	size = os_get_filesize(state->nand_fname);
+	for (i = 0; i < ARRAY_SIZE(sandbox_nand_ids); i++) {
+		if (size == (ssize_t)sandbox_nand_ids[i].size_mb << 20)
+			break;
+	}
+	if (i == ARRAY_SIZE(sandbox_nand_ids)) {
+		printf("sandbox_nand: '%s' must be 64, 128, 256, 512 or 1024 MiB\n",
+		       state->nand_fname);
+		return -EINVAL;
+	}
+	snand->size = size;
+	snand->dev_id = sandbox_nand_ids[i].dev_id;
+	snand->page = -1;
+
+	snand->oob = malloc(size / SANDBOX_NAND_PAGE_SIZE *
+			    SANDBOX_NAND_OOB_SIZE);
+	if (!snand->oob)
+		return -ENOMEM;
+	memset(snand->oob, 0xff, size / SANDBOX_NAND_PAGE_SIZE *
+	       SANDBOX_NAND_OOB_SIZE);
+	snand->fd = os_open(state->nand_fname, OS_O_RDWR);
+	if (snand->fd < 0) {
+		printf("sandbox_nand: unable to open file '%s'\n",
+		       state->nand_fname);
+		free(snand->oob);
+		return -ENOENT;
+	}
+
+	nand->cmdfunc = sandbox_nand_cmdfunc;
+	nand->read_byte = sandbox_nand_read_byte;
+	nand->read_buf = sandbox_nand_read_buf;
+	nand->write_buf = sandbox_nand_write_buf;
+	nand->dev_ready = sandbox_nand_dev_ready;
+	nand->select_chip = sandbox_nand_select_chip;
+	nand->ecc.mode = NAND_ECC_HW;
+	nand->ecc.size = 256;
+	nand->ecc.bytes = 3;
+	nand->ecc.hwctl = sandbox_nand_hwctl;
+	nand->ecc.calculate = sandbox_nand_calculate;
+	nand->ecc.correct = sandbox_nand_correct;
+
+	return 0;
+}
+
+static int sandbox_cmdline_cb_nand(struct sandbox_state *state,
+				   const char *arg)
+{
+	state->nand_fname = arg;
+
+	return 0;
+}
+SANDBOX_CMDLINE_OPT(nand, 1, "emulate a NAND flash using <file>");
@@ -15,6 +15,8 @@ struct gigadevice_spi_flash_params {
 	uint16_t	id;
 	uint16_t	nr_blocks;
 	const char	*name;
+	u32		erase_sizes;
+	u8		read_modes;
 };
 
 static const struct gigadevice_spi_flash_params gigadevice_spi_flash_table[] = {
@@ -22,11 +24,17 @@ static const struct gigadevice_spi_flash_params gigadevice_spi_flash_table[] = {
 		.id			= 0x6016,
 		.nr_blocks		= 64,
 		.name			= "GD25LQ",
+		.erase_sizes		= SPI_ERASE_4K | SPI_ERASE_32K |
+					  SPI_ERASE_64K,
+		.read_modes		= SPI_RX_DUAL | SPI_RX_QUAD,
 	},
 	{
 		.id			= 0x4017,
 		.nr_blocks		= 128,
 		.name			= "GD25Q64B",
+		.erase_sizes		= SPI_ERASE_4K | SPI_ERASE_32K |
+					  SPI_ERASE_64K,
+		.read_modes		= SPI_RX_DUAL | SPI_RX_QUAD,
 	},
 
 };
@@ -87,6 +95,8 @@ struct spi_flash *spi_flash_probe_gigadevice(struct spi_slave *spi, u8 *idcode)
 	flash->page_size = 256;
 	/* sector_size = page_size * pages_per_sector */
 	flash->sector_size = flash->page_size * 16;
+	flash->erase_sizes = params->erase_sizes;
+	flash->read_modes = params->read_modes;
 	/* size = sector_size * sector_per_block * number of blocks */
 	flash->size = flash->sector_size * 16 * params->nr_blocks;
 	flash->read_sw_wp_status = gigadevice_read_sw_wp_status;
@@ -33,12 +33,14 @@ enum sandbox_sf_state {
 	SF_WRITE, /* writing data to the flash, i.e. page programming */
 	SF_ERASE, /* erase the flash */
 	SF_READ_STATUS, /* read the flash's status register */
+	SF_READ_STATUS1, /* read the flash's status register 2 */
 };
 
 static const char *sandbox_sf_state_name(enum sandbox_sf_state state)
 {
 	static const char * const states[] = {
 		"CMD", "ID", "ADDR", "READ", "WRITE", "ERASE", "READ_STATUS",
+		"READ_STATUS1",
 	};
 	return states[state];
 }
@@ -47,6 +49,9 @@ static const char *sandbox_sf_state_name(enum sandbox_sf_state state)
 #define STAT_WIP	(1 << 0)
 #define STAT_WEL	(1 << 1)
 
+/* Bits for status register 2 */
+#define STAT1_QE	(1 << 1)
+
 /* Assume all SPI flashes have 3 byte addresses since they do atm */
 #define SF_ADDR_LEN	3
 
@@ -55,7 +60,7 @@ struct sandbox_spi_flash_erase_commands {
 	u32 size;
 };
 #define IDCODE_LEN 5
-#define MAX_ERASE_CMDS 3
+#define MAX_ERASE_CMDS 4
 struct sandbox_spi_flash_data {
 	const char *name;
 	u8 idcode[IDCODE_LEN];
@@ -77,6 +82,7 @@ static const struct sandbox_spi_flash_data sandbox_sf_flashes[] = {
 		"W25Q32", { 0xef, 0x40, 0x16 }, (4 << 20),
 		{	/* erase commands */
 			{ 0x20, (4 << 10), }, /* 4KB */
+			{ 0x52, (32 << 10), }, /* 32KB */
 			{ 0xd8, (64 << 10), }, /* sector */
 			{ 0xc7, (4 << 20), }, /* bulk */
 		},
@@ -85,6 +91,7 @@ static const struct sandbox_spi_flash_data sandbox_sf_flashes[] = {
 		"W25Q128", { 0xef, 0x40, 0x18 }, (16 << 20),
 		{	/* erase commands */
 			{ 0x20, (4 << 10), }, /* 4KB */
+			{ 0x52, (32 << 10), }, /* 32KB */
 			{ 0xd8, (64 << 10), }, /* sector */
 			{ 0xc7, (16 << 20), }, /* bulk */
 		},
@@ -219,6 +226,8 @@ static int sandbox_sf_process_cmd(struct sandbox_spi_flash *sbsf, const u8 *rx,
 		sbsf->cmd = SF_ID;
 		break;
 	case CMD_READ_ARRAY_FAST:
+	case CMD_READ_DUAL_OUTPUT:
+	case CMD_READ_QUAD_OUTPUT:
 		sbsf->pad_addr_bytes = 1;
 	case CMD_READ_ARRAY_SLOW:
 	case CMD_PAGE_PROGRAM:
@@ -232,6 +241,9 @@ static int sandbox_sf_process_cmd(struct sandbox_spi_flash *sbsf, const u8 *rx,
 	case CMD_READ_STATUS:
 		sbsf->state = SF_READ_STATUS;
 		break;
+	case CMD_READ_STATUS1:
+		sbsf->state = SF_READ_STATUS1;
+		break;
 	case CMD_WRITE_ENABLE:
 		debug(" write enabled\n");
 		sbsf->status |= STAT_WEL;
@@ -336,6 +348,8 @@ static int sandbox_sf_xfer(void *priv, const u8 *rx, u8 *tx,
 			}
 			switch (sbsf->cmd) {
 			case CMD_READ_ARRAY_FAST:
+			case CMD_READ_DUAL_OUTPUT:
+			case CMD_READ_QUAD_OUTPUT:
 			case CMD_READ_ARRAY_SLOW:
 				sbsf->state = SF_READ;
 				break;
@@ -371,6 +385,13 @@ static int sandbox_sf_xfer(void *priv, const u8 *rx, u8 *tx,
 			memset(tx + pos, sbsf->status, cnt);
 			pos += cnt;
 			break;
+		case SF_READ_STATUS1:
+			/* Quad enable is always set so quad reads can be tested */
+			debug(" read status1: %#x\n", STAT1_QE);
+			cnt = bytes - pos;
+			memset(tx + pos, STAT1_QE, cnt);
+			pos += cnt;
+			break;
 		case SF_WRITE:
 			/*
 			 * XXX: need to handle exotic behavior:
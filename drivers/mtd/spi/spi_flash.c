@@ -8,6 +8,7 @@
  */
 
 #include <common.h>
+#include <errno.h>
 #include <fdtdec.h>
 #include <malloc.h>
 #include <spi.h>
@@ -27,10 +28,14 @@ static void spi_flash_addr(u32 addr, u8 *cmd)
 	cmd[3] = addr >> 0;
 }
 
+/*
+ * Send a command and then transfer data. The data phase can use extra
+ * transfer flags, such as SPI_XFER_DUAL for a dual-output read.
+ */
 static int spi_flash_read_write(struct spi_slave *spi,
 				const u8 *cmd, size_t cmd_len,
 				const u8 *data_out, u8 *data_in,
-				size_t data_len)
+				size_t data_len, unsigned long data_flags)
 {
 	unsigned long flags = SPI_XFER_BEGIN;
 	int ret;
@@ -43,7 +48,8 @@ static int spi_flash_read_write(struct spi_slave *spi,
 		debug("SF: Failed to send command (%zu bytes): %d\n",
 				cmd_len, ret);
 	} else if (data_len != 0) {
-		ret = spi_xfer(spi, data_len * 8, data_out, data_in, SPI_XFER_END);
+		ret = spi_xfer(spi, data_len * 8, data_out, data_in,
+			       SPI_XFER_END | data_flags);
 		if (ret)
 			debug("SF: Failed to transfer %zu bytes of data: %d\n",
 					data_len, ret);
@@ -60,13 +66,13 @@ int spi_flash_cmd(struct spi_slave *spi, u8 cmd, void *response, size_t len)
 int spi_flash_cmd_read(struct spi_slave *spi, const u8 *cmd,
 		size_t cmd_len, void *data, size_t data_len)
 {
-	return spi_flash_read_write(spi, cmd, cmd_len, NULL, data, data_len);
+	return spi_flash_read_write(spi, cmd, cmd_len, NULL, data, data_len, 0);
 }
 
 int spi_flash_cmd_write(struct spi_slave *spi, const u8 *cmd, size_t cmd_len,
 		const void *data, size_t data_len)
 {
-	return spi_flash_read_write(spi, cmd, cmd_len, data, NULL, data_len);
+	return spi_flash_read_write(spi, cmd, cmd_len, data, NULL, data_len, 0);
 }
 
 int spi_flash_cmd_write_multi(struct spi_flash *flash, u32 offset,
@@ -150,6 +156,9 @@ int spi_flash_read_common(struct spi_flash *flash, const u8 *cmd,
 int spi_flash_cmd_read_fast(struct spi_flash *flash, u32 offset,
 		size_t len, void *data)
 {
+	struct spi_slave *spi = flash->spi;
+	unsigned long flags = 0;
+	int ret;
 	u8 cmd[5];
 
 	/* Handle memory-mapped SPI */
@@ -160,11 +169,23 @@ int spi_flash_cmd_read_fast(struct spi_flash *flash, u32 offset,
 		return 0;
 	}
 
-	cmd[0] = CMD_READ_ARRAY_FAST;
+	/* The dual and quad reads have the same dummy byte as a fast read */
+	cmd[0] = flash->read_cmd ? flash->read_cmd : CMD_READ_ARRAY_FAST;
 	spi_flash_addr(offset, cmd);
 	cmd[4] = 0x00;
+	if (cmd[0] == CMD_READ_DUAL_OUTPUT)
+		flags = SPI_XFER_DUAL;
+	else if (cmd[0] == CMD_READ_QUAD_OUTPUT)
+		flags = SPI_XFER_QUAD;
+
+	bootstage_start(BOOTSTAGE_ID_ACCUM_SPI, "SPI read");
+	spi_claim_bus(spi);
+	ret = spi_flash_read_write(spi, cmd, sizeof(cmd), NULL, data, len,
+				   flags);
+	spi_release_bus(spi);
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_SPI);
 
-	return spi_flash_read_common(flash, cmd, sizeof(cmd), data, len);
+	return ret;
 }
 
 int spi_flash_cmd_poll_bit(struct spi_flash *flash, unsigned long timeout,
@@ -234,13 +255,56 @@ int spi_flash_cmd_wait_ready(struct spi_flash *flash, unsigned long timeout)
 		CMD_READ_STATUS, STATUS_WIP);
 }
 
+/**
+ * Pick the erase command to use at a given offset
+ *
+ * This chooses the largest erase block supported by the chip which is
+ * aligned at @offset and fits within @len. A large range is then mostly
+ * erased in 64KB blocks, which are much faster per byte than 4KB sectors,
+ * with smaller erases only at the unaligned edges.
+ *
+ * @param sizes		Bitmask of supported erase sizes (each a power of 2)
+ * @param offset	Offset to erase from
+ * @param len		Number of bytes left to erase
+ * @param cmdp		Returns the erase command to use
+ * @return number of bytes erased by the command, or 0 if none fits
+ */
+static u32 spi_flash_erase_plan(u32 sizes, u32 offset, u32 len, u8 *cmdp)
+{
+	u32 size;
+
+	for (; sizes; sizes &= ~size) {
+		size = 1U << (fls(sizes) - 1);
+		if (!(offset & (size - 1)) && size <= len)
+			break;
+	}
+	if (!sizes)
+		return 0;
+
+	if (size == SPI_ERASE_4K)
+		*cmdp = CMD_ERASE_4K;
+	else if (size == SPI_ERASE_32K)
+		*cmdp = CMD_ERASE_32K;
+	else
+		*cmdp = CMD_ERASE_64K;
+
+	return size;
+}
+
 int spi_flash_cmd_erase(struct spi_flash *flash, u32 offset, size_t len)
 {
-	u32 start, end, erase_size;
+	u32 start, end, erase_size, sizes;
+	int count = 0;
 	int ret;
 	u8 cmd[4];
 
-	erase_size = flash->sector_size;
+	/* Chips which don't list their erase sizes use the sector size */
+	sizes = flash->erase_sizes;
+	if (!sizes)
+		sizes = flash->sector_size;
+
+	/* The smallest erase size sets the alignment */
+	erase_size = sizes & -sizes;
 	if (offset % erase_size || len % erase_size) {
 		debug("SF: Erase offset/length not multiple of erase size\n");
 		return -1;
@@ -252,16 +316,15 @@ int spi_flash_cmd_erase(struct spi_flash *flash, u32 offset, size_t len)
 		return ret;
 	}
 
-	if (erase_size == 4096)
-		cmd[0] = CMD_ERASE_4K;
-	else
-		cmd[0] = CMD_ERASE_64K;
 	start = offset;
 	end = start + len;
 
 	while (offset < end) {
+		erase_size = spi_flash_erase_plan(sizes, offset, end - offset,
+						  cmd);
 		spi_flash_addr(offset, cmd);
 		offset += erase_size;
+		count++;
 
 		debug("SF: erase %2x %2x %2x %2x (%x)\n", cmd[0], cmd[1],
 		      cmd[2], cmd[3], offset);
@@ -279,13 +342,137 @@ int spi_flash_cmd_erase(struct spi_flash *flash, u32 offset, size_t len)
 			goto out;
 	}
 
-	debug("SF: Successfully erased %zu bytes @ %#x\n", len, start);
+	debug("SF: Successfully erased %zu bytes @ %#x in %d commands\n", len,
+	      start, count);
 
  out:
 	spi_release_bus(flash->spi);
 	return ret;
 }
 
+/*
+ * Number of bytes spi_flash_update() works on at a time. This is large
+ * enough that a run of changed sectors can be erased with a single 64KB
+ * block erase.
+ */
+#define SPI_FLASH_UPDATE_WINDOW		(64 << 10)
+
+/* Check whether going from @old to @new needs an erase (any 0->1 bits) */
+static int spi_flash_needs_erase(const u8 *old, const u8 *new, size_t len)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		if ((old[i] & new[i]) != new[i])
+			return 1;
+	}
+
+	return 0;
+}
+
+/**
+ * Update one window of flash, given its old and new contents
+ *
+ * Runs of sectors which need erasing are erased together, after which
+ * their old contents are all 0xff. Then only the pages whose contents
+ * differ are programmed, which skips blank pages in erased sectors as well
+ * as unchanged pages.
+ *
+ * @param flash		Flash to update
+ * @param pos		Offset of window in flash (a multiple of sector_size)
+ * @param size		Size of window (a multiple of sector_size)
+ * @param old		Current contents of window; this is updated
+ * @param new		New contents of window
+ * @param stats		Statistics to update
+ * @return 0 if ok, -ve on error
+ */
+static int spi_flash_update_window(struct spi_flash *flash, u32 pos,
+		u32 size, u8 *old, const u8 *new,
+		struct spi_flash_update_stats *stats)
+{
+	u32 sector = flash->sector_size;
+	u32 page = flash->page_size;
+	u32 start, end;
+	int ret;
+
+	for (start = 0; start < size; start = end) {
+		end = start + sector;
+		if (!memcmp(old + start, new + start, sector)) {
+			stats->unchanged += sector;
+			continue;
+		}
+		if (!spi_flash_needs_erase(old + start, new + start, sector))
+			continue;
+		while (end < size &&
+		       spi_flash_needs_erase(old + end, new + end, sector))
+			end += sector;
+		ret = flash->erase(flash, pos + start, end - start);
+		if (ret)
+			return ret;
+		memset(old + start, 0xff, end - start);
+		stats->erased += end - start;
+	}
+
+	for (start = 0; start < size; start = end) {
+		end = start + page;
+		if (!memcmp(old + start, new + start, page))
+			continue;
+		while (end < size && memcmp(old + end, new + end, page))
+			end += page;
+		ret = flash->write(flash, pos + start, end - start,
+				   new + start);
+		if (ret)
+			return ret;
+		stats->programmed += end - start;
+	}
+
+	return 0;
+}
+
+int spi_flash_update(struct spi_flash *flash, u32 offset, size_t len,
+		     const void *buf, struct spi_flash_update_stats *stats)
+{
+	u32 sector = flash->sector_size;
+	u32 window, start, end, pos, next, from, to;
+	u8 *old, *new;
+	int ret = 0;
+
+	window = roundup(SPI_FLASH_UPDATE_WINDOW, sector);
+	start = offset - offset % sector;
+	end = roundup(offset + len, sector);
+	old = malloc(window);
+	new = malloc(window);
+	if (!old || !new) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	for (pos = start; pos < end; pos = next) {
+		next = min(end, pos - pos % window + window);
+		ret = flash->read(flash, pos, next - pos, old);
+		if (ret)
+			break;
+
+		/* Sectors at the edges keep the data outside the range */
+		memcpy(new, old, next - pos);
+		from = max(pos, offset);
+		to = min(next, offset + len);
+		memcpy(new + from - pos, buf + from - offset, to - from);
+
+		ret = spi_flash_update_window(flash, pos, next - pos, old, new,
+					      stats);
+		if (ret)
+			break;
+	}
+	debug("SF: update %#zx bytes @ %#x: erased %#zx, programmed %#zx\n",
+	      len, offset, stats->erased, stats->programmed);
+
+out:
+	free(new);
+	free(old);
+	return ret;
+}
+
 int spi_flash_cmd_write_status(struct spi_flash *flash, unsigned int status,
 			       bool write_16bit)
 {
@@ -347,6 +534,34 @@ int spi_flash_decode_fdt(const void *blob, struct spi_flash *flash)
 }
 #endif /* CONFIG_OF_CONTROL */
 
+/**
+ * Choose the fastest read command that both the chip and controller support
+ *
+ * Quad output reads use the WP# and HOLD# pins for data, which the chip
+ * only allows once the quad enable bit is set. Setting it would mean
+ * writing the status register, which also holds the write protection
+ * settings, so we only use quad reads if it is already set.
+ *
+ * @param flash		Flash device to set up (bus must be claimed)
+ */
+static void spi_flash_setup_read(struct spi_flash *flash)
+{
+	u8 modes = flash->read_modes & flash->spi->rx_mode;
+	unsigned int status;
+
+	flash->read_cmd = CMD_READ_ARRAY_FAST;
+	if (modes & SPI_RX_QUAD) {
+		if (!spi_flash_cmd_read_status(flash, &status) &&
+		    (status & STATUS_QE)) {
+			flash->read_cmd = CMD_READ_QUAD_OUTPUT;
+			return;
+		}
+		debug("SF: Quad enable not set, not using quad read\n");
+	}
+	if (modes & SPI_RX_DUAL)
+		flash->read_cmd = CMD_READ_DUAL_OUTPUT;
+}
+
 /*
  * The following table holds all device probe functions
  *
@@ -469,11 +684,17 @@ static struct spi_flash *spi_flash_probe_slave(struct spi_slave *spi)
 		goto err_manufacturer_probe;
 	}
 #endif
+	if (flash->read == spi_flash_cmd_read_fast)
+		spi_flash_setup_read(flash);
 	printf("SF: Detected %s with page size ", flash->name);
 	print_size(flash->sector_size, ", total ");
 	print_size(flash->size, "");
 	if (flash->memory_map)
 		printf(", mapped at %p", flash->memory_map);
+	else if (flash->read_cmd == CMD_READ_DUAL_OUTPUT)
+		printf(", dual read");
+	else if (flash->read_cmd == CMD_READ_QUAD_OUTPUT)
+		printf(", quad read");
 	puts("\n");
 
 	spi_release_bus(spi);
@@ -17,6 +17,8 @@
 
 #define CMD_READ_ARRAY_SLOW		0x03
 #define CMD_READ_ARRAY_FAST		0x0b
+#define CMD_READ_DUAL_OUTPUT		0x3b
+#define CMD_READ_QUAD_OUTPUT		0x6b
 
 #define CMD_WRITE_STATUS		0x01
 #define CMD_PAGE_PROGRAM		0x02
@@ -31,8 +33,14 @@
 #define CMD_ERASE_64K			0xd8
 #define CMD_ERASE_CHIP			0xc7
 
+/* Erase block sizes, for use in spi_flash->erase_sizes */
+#define SPI_ERASE_4K			(4 << 10)
+#define SPI_ERASE_32K			(32 << 10)
+#define SPI_ERASE_64K			(64 << 10)
+
 /* Common status */
 #define STATUS_WIP			0x01
+#define STATUS_QE			(1 << 9)	/* Quad enable */
 
 /* Send a single-byte command to the device and read the response */
 int spi_flash_cmd(struct spi_slave *spi, u8 cmd, void *response, size_t len);
@@ -14,73 +14,107 @@ struct winbond_spi_flash_params {
 	uint16_t	id;
 	uint16_t	nr_blocks;
 	const char	*name;
+	u32		erase_sizes;
+	u8		read_modes;
 };
 
+/* The W25X parts have no 32KB block erase and no quad read */
+#define W25X_ERASE_SIZES	(SPI_ERASE_4K | SPI_ERASE_64K)
+#define W25Q_ERASE_SIZES	(SPI_ERASE_4K | SPI_ERASE_32K | SPI_ERASE_64K)
+#define W25X_READ_MODES		SPI_RX_DUAL
+#define W25Q_READ_MODES		(SPI_RX_DUAL | SPI_RX_QUAD)
+
 static const struct winbond_spi_flash_params winbond_spi_flash_table[] = {
 	{
 		.id			= 0x3013,
 		.nr_blocks		= 8,
 		.name			= "W25X40",
+		.erase_sizes		= W25X_ERASE_SIZES,
+		.read_modes		= W25X_READ_MODES,
 	},
 	{
 		.id			= 0x3015,
 		.nr_blocks		= 32,
 		.name			= "W25X16",
+		.erase_sizes		= W25X_ERASE_SIZES,
+		.read_modes		= W25X_READ_MODES,
 	},
 	{
 		.id			= 0x3016,
 		.nr_blocks		= 64,
 		.name			= "W25X32",
+		.erase_sizes		= W25X_ERASE_SIZES,
+		.read_modes		= W25X_READ_MODES,
 	},
 	{
 		.id			= 0x3017,
 		.nr_blocks		= 128,
 		.name			= "W25X64",
+		.erase_sizes		= W25X_ERASE_SIZES,
+		.read_modes		= W25X_READ_MODES,
 	},
 	{
 		.id			= 0x4014,
 		.nr_blocks		= 16,
 		.name			= "W25Q80BL",
+		.erase_sizes		= W25Q_ERASE_SIZES,
+		.read_modes		= W25Q_READ_MODES,
 	},
 	{
 		.id			= 0x4015,
 		.nr_blocks		= 32,
 		.name			= "W25Q16",
+		.erase_sizes		= W25Q_ERASE_SIZES,
+		.read_modes		= W25Q_READ_MODES,
 	},
 	{
 		.id			= 0x4016,
 		.nr_blocks		= 64,
 		.name			= "W25Q32",
+		.erase_sizes		= W25Q_ERASE_SIZES,
+		.read_modes		= W25Q_READ_MODES,
 	},
 	{
 		.id			= 0x4017,
 		.nr_blocks		= 128,
 		.name			= "W25Q64",
+		.erase_sizes		= W25Q_ERASE_SIZES,
+		.read_modes		= W25Q_READ_MODES,
 	},
 	{
 		.id			= 0x4018,
 		.nr_blocks		= 256,
 		.name			= "W25Q128",
+		.erase_sizes		= W25Q_ERASE_SIZES,
+		.read_modes		= W25Q_READ_MODES,
 	},
 	{
 		.id			= 0x5014,
 		.nr_blocks		= 128,
 		.name			= "W25Q80",
+		.erase_sizes		= W25Q_ERASE_SIZES,
+		.read_modes		= W25Q_READ_MODES,
 	},
 	{
 		.id			= 0x6016,
 		.nr_blocks		= 512,
 		.name			= "W25Q32DW",
+		.erase_sizes		= W25Q_ERASE_SIZES,
+		.read_modes		= W25Q_READ_MODES,
 	},
 	{
 		.id			= 0x6017,
 		.nr_blocks		= 128,
 		.name			= "W25Q64DW",
+		.erase_sizes		= W25Q_ERASE_SIZES,
+		.read_modes		= W25Q_READ_MODES,
 	},
 	{
 		.id			= 0x6016,
 		.nr_blocks		= 64,
 		.name			= "W25Q32",
+		.erase_sizes		= W25Q_ERASE_SIZES,
+		.read_modes		= W25Q_READ_MODES,
 	},
 };
 
@@ -128,6 +162,8 @@ struct spi_flash *spi_flash_probe_winbond(struct spi_slave *spi, u8 *idcode)
 
 	flash->page_size = 256;
 	flash->sector_size = 4096;
+	flash->erase_sizes = params->erase_sizes;
+	flash->read_modes = params->read_modes;
 	flash->size = 4096 * 16 * params->nr_blocks;
 	flash->read_sw_wp_status = winbond_read_sw_wp_status;
 
@@ -0,0 +1,734 @@
+/*
+ * Copyright (c) 2013 The Chromium OS Authors.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See
+ * the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * UBI fastmap unit.
+ *
+ * Attaching a UBI device normally means reading the headers of every
+ * physical eraseblock, which takes a long time on a large NAND. Linux can
+ * keep a fastmap on the flash (see ubi-media.h) describing the state of every
+ * PEB, so that the device can be attached by reading just a few of them.
+ *
+ * This unit reads the fastmap and turns it into the same scanning information
+ * that a full scan would produce, so the rest of UBI does not know the
+ * difference. PEBs in the fastmap pools, and any others the fastmap does not
+ * fully describe, are still scanned in the normal way. If anything about the
+ * fastmap looks wrong, the whole device is scanned instead.
+ *
+ * U-Boot cannot write a fastmap. So before it first changes anything on the
+ * flash, it replaces the fastmap anchor with an empty anchor that has a newer
+ * sequence number than any other. The next attach, whether by U-Boot or Linux,
+ * then finds no usable fastmap and scans the device.
+ */
+
+#include <ubi_uboot.h>
+#include "ubi.h"
+
+/* What the fastmap says about a PEB */
+enum {
+	FM_PEB_UNKNOWN,		/* Not mentioned */
+	FM_PEB_POOL,		/* In a pool, so may have changed since */
+	FM_PEB_FREE,
+	FM_PEB_USED,
+	FM_PEB_SCRUB,
+	FM_PEB_ERASE,
+	FM_PEB_FASTMAP,		/* Holds part of the fastmap itself */
+};
+
+/**
+ * struct fm_peb - fastmap information about a physical eraseblock.
+ * @state: what the fastmap says about this PEB (%FM_PEB_...)
+ * @ec: erase counter
+ * @vol: index of the volume this PEB is mapped to, or -1 if none
+ * @lnum: logical eraseblock number within the volume
+ */
+struct fm_peb {
+	int state;
+	int ec;
+	int vol;
+	int lnum;
+};
+
+/**
+ * struct fm_info - a fastmap being attached.
+ * @pebs: information about each PEB, indexed by PEB number
+ * @vols: header of each volume in the fastmap
+ * @vol_count: number of volumes in the fastmap
+ * @sqnum: highest sequence number at the time the fastmap was written
+ */
+struct fm_info {
+	struct fm_peb *pebs;
+	struct ubi_fm_volhdr **vols;
+	int vol_count;
+	unsigned long long sqnum;
+};
+
+/**
+ * find_anchor - find the fastmap anchor.
+ * @ubi: UBI device description object
+ * @vid_hdr: buffer to use for reading VID headers
+ * @sqnum: returns the sequence number of the anchor
+ *
+ * The anchor is the PEB of the fastmap super block volume with the highest
+ * sequence number among the first %UBI_FM_MAX_START PEBs. This function
+ * returns its PEB number, %-ENOENT if there is none, or another negative
+ * error code in case of failure.
+ */
+static int find_anchor(struct ubi_device *ubi, struct ubi_vid_hdr *vid_hdr,
+		       unsigned long long *sqnum)
+{
+	int pnum, err, anchor = -ENOENT;
+
+	*sqnum = 0;
+	for (pnum = 0; pnum < min(ubi->peb_count, UBI_FM_MAX_START); pnum++) {
+		err = ubi_io_is_bad(ubi, pnum);
+		if (err < 0)
+			return err;
+		else if (err)
+			continue;
+
+		err = ubi_io_read_vid_hdr(ubi, pnum, vid_hdr, 0);
+		if (err < 0)
+			return err;
+		else if (err && err != UBI_IO_BITFLIPS)
+			continue;
+
+		if (be32_to_cpu(vid_hdr->vol_id) != UBI_FM_SB_VOLUME_ID)
+			continue;
+		if (anchor < 0 || be64_to_cpu(vid_hdr->sqnum) > *sqnum) {
+			anchor = pnum;
+			*sqnum = be64_to_cpu(vid_hdr->sqnum);
+		}
+	}
+
+	return anchor;
+}
+
+/**
+ * set_peb - record what the fastmap says about a PEB.
+ * @ubi: UBI device description object
+ * @fm: fastmap information
+ * @pnum: PEB number
+ * @ec: erase counter
+ * @state: state of the PEB (%FM_PEB_...)
+ *
+ * PEBs in the pools are scanned whatever else the fastmap says about them.
+ * This function returns zero if the PEB was recorded and %UBI_NO_FASTMAP if
+ * the fastmap is inconsistent.
+ */
+static int set_peb(struct ubi_device *ubi, struct fm_info *fm, int pnum,
+		   int ec, int state)
+{
+	struct fm_peb *peb;
+
+	if (pnum < 0 || pnum >= ubi->peb_count || ec < 0) {
+		ubi_warn("bad fastmap entry: PEB %d, EC %d", pnum, ec);
+		return UBI_NO_FASTMAP;
+	}
+
+	peb = &fm->pebs[pnum];
+	if (peb->state == FM_PEB_POOL)
+		return 0;
+	if (peb->state != FM_PEB_UNKNOWN) {
+		ubi_warn("PEB %d is in the fastmap twice", pnum);
+		return UBI_NO_FASTMAP;
+	}
+	peb->state = state;
+	peb->ec = ec;
+
+	return 0;
+}
+
+/**
+ * read_fastmap - read the fastmap and check its CRC.
+ * @ubi: UBI device description object
+ * @fm: fastmap information
+ * @vid_hdr: buffer to use for reading VID headers
+ * @anchor: PEB number of the fastmap anchor
+ * @bufp: returns the fastmap data, which the caller must free with vfree()
+ * @sizep: returns the size of the fastmap data in bytes
+ *
+ * This function returns zero in case of success, %UBI_NO_FASTMAP if there is
+ * no usable fastmap, or a negative error code in case of failure.
+ */
+static int read_fastmap(struct ubi_device *ubi, struct fm_info *fm,
+			struct ubi_vid_hdr *vid_hdr, int anchor, void **bufp,
+			int *sizep)
+{
+	struct ubi_fm_sb *fmsb, *data_sb;
+	int used_blocks, size, pnum, i, err;
+	uint32_t crc;
+	void *buf;
+
+	fmsb = kmalloc(sizeof(struct ubi_fm_sb), GFP_KERNEL);
+	if (!fmsb)
+		return -ENOMEM;
+
+	err = ubi_io_read(ubi, fmsb, anchor, ubi->leb_start, sizeof(*fmsb));
+	if (err && err != UBI_IO_BITFLIPS) {
+		ubi_warn("cannot read fastmap super block from PEB %d",
+			 anchor);
+		err = UBI_NO_FASTMAP;
+		goto out_fmsb;
+	}
+
+	err = UBI_NO_FASTMAP;
+	if (be32_to_cpu(fmsb->magic) != UBI_FM_SB_MAGIC) {
+		ubi_msg("fastmap anchor at PEB %d has no fastmap", anchor);
+		goto out_fmsb;
+	}
+	if (fmsb->version != UBI_FM_FMT_VERSION) {
+		ubi_warn("fastmap version %d is not supported",
+			 (int)fmsb->version);
+		goto out_fmsb;
+	}
+	used_blocks = be32_to_cpu(fmsb->used_blocks);
+	if (used_blocks < 1 || used_blocks > UBI_FM_MAX_BLOCKS ||
+	    be32_to_cpu(fmsb->block_loc[0]) != anchor) {
+		ubi_warn("bad fastmap super block at PEB %d", anchor);
+		goto out_fmsb;
+	}
+
+	err = -ENOMEM;
+	size = used_blocks * ubi->leb_size;
+	buf = vmalloc(size);
+	if (!buf)
+		goto out_fmsb;
+
+	for (i = 0; i < used_blocks; i++) {
+		pnum = be32_to_cpu(fmsb->block_loc[i]);
+		err = set_peb(ubi, fm, pnum, be32_to_cpu(fmsb->block_ec[i]),
+			      FM_PEB_FASTMAP);
+		if (err)
+			goto out_buf;
+
+		if (i) {
+			err = ubi_io_read_vid_hdr(ubi, pnum, vid_hdr, 0);
+			if ((err && err != UBI_IO_BITFLIPS) ||
+			    be32_to_cpu(vid_hdr->vol_id) !=
+					UBI_FM_DATA_VOLUME_ID) {
+				ubi_warn("fastmap PEB %d is not valid", pnum);
+				err = UBI_NO_FASTMAP;
+				goto out_buf;
+			}
+		}
+
+		err = ubi_io_read(ubi, buf + i * ubi->leb_size, pnum,
+				  ubi->leb_start, ubi->leb_size);
+		if (err && err != UBI_IO_BITFLIPS) {
+			ubi_warn("cannot read fastmap PEB %d", pnum);
+			err = UBI_NO_FASTMAP;
+			goto out_buf;
+		}
+	}
+
+	/* The CRC is calculated with the CRC field zeroed */
+	data_sb = buf;
+	crc = be32_to_cpu(data_sb->data_crc);
+	data_sb->data_crc = 0;
+	if (crc32(UBI_CRC32_INIT, buf, size) != crc) {
+		ubi_warn("fastmap data CRC is invalid");
+		err = UBI_NO_FASTMAP;
+		goto out_buf;
+	}
+	fm->sqnum = be64_to_cpu(data_sb->sqnum);
+
+	*bufp = buf;
+	*sizep = size;
+	kfree(fmsb);
+	return 0;
+
+out_buf:
+	vfree(buf);
+out_fmsb:
+	kfree(fmsb);
+	return err;
+}
+
+/**
+ * fm_take - take the next part of the fastmap.
+ * @buf: fastmap data
+ * @size: size of the fastmap data in bytes
+ * @pos: current position in @buf, which is moved past the part taken
+ * @len: size of the part in bytes
+ *
+ * This function returns a pointer to the part, or %NULL if it runs past the
+ * end of the fastmap.
+ */
+static void *fm_take(void *buf, int size, int *pos, int len)
+{
+	void *ptr = buf + *pos;
+
+	if (len < 0 || len > size - *pos)
+		return NULL;
+	*pos += len;
+
+	return ptr;
+}
+
+/**
+ * parse_fastmap - check the fastmap and record what it says about each PEB.
+ * @ubi: UBI device description object
+ * @fm: fastmap information
+ * @buf: fastmap data
+ * @size: size of the fastmap data in bytes
+ *
+ * This function returns zero in case of success, %UBI_NO_FASTMAP if the
+ * fastmap is not valid, or a negative error code in case of failure.
+ */
+static int parse_fastmap(struct ubi_device *ubi, struct fm_info *fm,
+			 void *buf, int size)
+{
+	static const int states[] = {
+		FM_PEB_FREE, FM_PEB_USED, FM_PEB_SCRUB, FM_PEB_ERASE,
+	};
+	struct ubi_fm_scan_pool *fmpl;
+	struct ubi_fm_volhdr *fmvhdr;
+	struct ubi_fm_eba *fm_eba;
+	struct ubi_fm_hdr *fmhdr;
+	struct ubi_fm_ec *fmec;
+	struct fm_peb *peb;
+	int pos = sizeof(struct ubi_fm_sb);
+	int i, j, count, pnum, vol_id;
+	__be32 counts[ARRAY_SIZE(states)];
+
+	fmhdr = fm_take(buf, size, &pos, sizeof(*fmhdr));
+	if (!fmhdr || be32_to_cpu(fmhdr->magic) != UBI_FM_HDR_MAGIC)
+		goto bad;
+
+	/* The user pool and the wear-leveling pool */
+	for (i = 0; i < 2; i++) {
+		fmpl = fm_take(buf, size, &pos, sizeof(*fmpl));
+		if (!fmpl || be32_to_cpu(fmpl->magic) != UBI_FM_POOL_MAGIC ||
+		    be16_to_cpu(fmpl->size) > be16_to_cpu(fmpl->max_size) ||
+		    be16_to_cpu(fmpl->max_size) > UBI_FM_MAX_POOL_SIZE)
+			goto bad;
+		for (j = 0; j < be16_to_cpu(fmpl->size); j++) {
+			pnum = be32_to_cpu(fmpl->pebs[j]);
+			if (pnum < 0 || pnum >= ubi->peb_count)
+				goto bad;
+			fm->pebs[pnum].state = FM_PEB_POOL;
+		}
+	}
+
+	counts[0] = fmhdr->free_peb_count;
+	counts[1] = fmhdr->used_peb_count;
+	counts[2] = fmhdr->scrub_peb_count;
+	counts[3] = fmhdr->erase_peb_count;
+	for (i = 0; i < ARRAY_SIZE(states); i++) {
+		count = be32_to_cpu(counts[i]);
+		if (count < 0 || count > ubi->peb_count)
+			goto bad;
+		fmec = fm_take(buf, size, &pos, count * sizeof(*fmec));
+		if (!fmec)
+			goto bad;
+		for (j = 0; j < count; j++) {
+			if (set_peb(ubi, fm, be32_to_cpu(fmec[j].pnum),
+				    be32_to_cpu(fmec[j].ec), states[i]))
+				goto bad;
+		}
+	}
+
+	fm->vol_count = be32_to_cpu(fmhdr->vol_count);
+	if (fm->vol_count < 1 ||
+	    fm->vol_count > UBI_MAX_VOLUMES + UBI_INT_VOL_COUNT)
+		goto bad;
+	fm->vols = kzalloc(fm->vol_count * sizeof(*fm->vols), GFP_KERNEL);
+	if (!fm->vols)
+		return -ENOMEM;
+
+	for (i = 0; i < fm->vol_count; i++) {
+		fmvhdr = fm_take(buf, size, &pos, sizeof(*fmvhdr));
+		if (!fmvhdr || be32_to_cpu(fmvhdr->magic) != UBI_FM_VHDR_MAGIC)
+			goto bad;
+		vol_id = be32_to_cpu(fmvhdr->vol_id);
+		if ((vol_id < 0 || vol_id >= UBI_MAX_VOLUMES) &&
+		    vol_id != UBI_LAYOUT_VOLUME_ID)
+			goto bad;
+		if (fmvhdr->vol_type != UBI_DYNAMIC_VOLUME &&
+		    fmvhdr->vol_type != UBI_STATIC_VOLUME)
+			goto bad;
+		for (j = 0; j < i; j++) {
+			if (be32_to_cpu(fm->vols[j]->vol_id) == vol_id)
+				goto bad;
+		}
+		fm->vols[i] = fmvhdr;
+
+		fm_eba = fm_take(buf, size, &pos, sizeof(*fm_eba));
+		if (!fm_eba || be32_to_cpu(fm_eba->magic) != UBI_FM_EBA_MAGIC)
+			goto bad;
+		count = be32_to_cpu(fm_eba->reserved_pebs);
+		if (count < 0 || count > ubi->peb_count ||
+		    !fm_take(buf, size, &pos, count * sizeof(__be32)))
+			goto bad;
+
+		for (j = 0; j < count; j++) {
+			pnum = be32_to_cpu(fm_eba->pnum[j]);
+			if (pnum < 0)
+				continue;
+			if (pnum >= ubi->peb_count)
+				goto bad;
+
+			/* A pool PEB may have been remapped since */
+			peb = &fm->pebs[pnum];
+			if (peb->state == FM_PEB_POOL)
+				continue;
+			if ((peb->state != FM_PEB_USED &&
+			     peb->state != FM_PEB_SCRUB) || peb->vol != -1)
+				goto bad;
+			peb->vol = i;
+			peb->lnum = j;
+		}
+	}
+
+	return 0;
+
+bad:
+	ubi_warn("fastmap is not valid (offset %d)", pos);
+	return UBI_NO_FASTMAP;
+}
+
+/**
+ * add_volume - add a fastmap volume to the scanning information.
+ * @si: scanning information
+ * @fmvhdr: fastmap volume header
+ *
+ * This function sets up the volume in the same way as scanning its VID
+ * headers would. It returns a pointer to the scanning volume object in case
+ * of success and %NULL if there is not enough memory.
+ */
+static struct ubi_scan_volume *add_volume(struct ubi_scan_info *si,
+					  const struct ubi_fm_volhdr *fmvhdr)
+{
+	struct ubi_scan_volume *sv;
+	struct rb_node **p = &si->volumes.rb_node, *parent = NULL;
+	int vol_id = be32_to_cpu(fmvhdr->vol_id);
+
+	/* Keep the same order as scan.c */
+	while (*p) {
+		parent = *p;
+		sv = rb_entry(parent, struct ubi_scan_volume, rb);
+
+		if (vol_id == sv->vol_id)
+			return sv;
+
+		if (vol_id > sv->vol_id)
+			p = &(*p)->rb_left;
+		else
+			p = &(*p)->rb_right;
+	}
+
+	sv = kmalloc(sizeof(struct ubi_scan_volume), GFP_KERNEL);
+	if (!sv)
+		return NULL;
+
+	sv->highest_lnum = sv->leb_count = 0;
+	sv->vol_id = vol_id;
+	sv->root = RB_ROOT;
+	sv->vol_type = fmvhdr->vol_type;
+	sv->data_pad = be32_to_cpu(fmvhdr->data_pad);
+	sv->last_data_size = be32_to_cpu(fmvhdr->last_eb_bytes);
+	sv->compat = 0;
+	if (vol_id == UBI_LAYOUT_VOLUME_ID)
+		sv->compat = UBI_LAYOUT_VOLUME_COMPAT;
+
+	/* VID headers of dynamic volumes have no used_ebs */
+	sv->used_ebs = 0;
+	if (sv->vol_type == UBI_STATIC_VOLUME)
+		sv->used_ebs = be32_to_cpu(fmvhdr->used_ebs);
+
+	if (vol_id > si->highest_vol_id)
+		si->highest_vol_id = vol_id;
+
+	rb_link_node(&sv->rb, parent, p);
+	rb_insert_color(&sv->rb, &si->volumes);
+	si->vols_found += 1;
+
+	return sv;
+}
+
+/**
+ * add_leb - add a PEB mapped by the fastmap to its volume.
+ * @sv: volume scanning information
+ * @pnum: PEB number
+ * @peb: fastmap information about the PEB
+ *
+ * This function returns zero in case of success and %-ENOMEM if there is not
+ * enough memory.
+ */
+static int add_leb(struct ubi_scan_volume *sv, int pnum,
+		   const struct fm_peb *peb)
+{
+	struct ubi_scan_leb *seb;
+	struct rb_node **p = &sv->root.rb_node, *parent = NULL;
+
+	/* Keep the same order as ubi_scan_add_used() */
+	while (*p) {
+		parent = *p;
+		seb = rb_entry(parent, struct ubi_scan_leb, u.rb);
+		if (peb->lnum < seb->lnum)
+			p = &(*p)->rb_left;
+		else
+			p = &(*p)->rb_right;
+	}
+
+	seb = kmalloc(sizeof(struct ubi_scan_leb), GFP_KERNEL);
+	if (!seb)
+		return -ENOMEM;
+
+	/*
+	 * A sequence number of zero means that a copy of this LEB found in a
+	 * pool is newer.
+	 */
+	seb->ec = peb->ec;
+	seb->pnum = pnum;
+	seb->lnum = peb->lnum;
+	seb->scrub = peb->state == FM_PEB_SCRUB;
+	seb->sqnum = 0;
+	seb->leb_ver = 0;
+
+	if (sv->highest_lnum < peb->lnum)
+		sv->highest_lnum = peb->lnum;
+	sv->leb_count += 1;
+	rb_link_node(&seb->u.rb, parent, p);
+	rb_insert_color(&seb->u.rb, &sv->root);
+
+	return 0;
+}
+
+/**
+ * fm_described - check whether the fastmap fully describes a PEB.
+ * @peb: fastmap information about the PEB
+ *
+ * This function returns non-zero if the PEB need not be scanned.
+ */
+static int fm_described(const struct fm_peb *peb)
+{
+	switch (peb->state) {
+	case FM_PEB_FREE:
+	case FM_PEB_ERASE:
+	case FM_PEB_FASTMAP:
+		return 1;
+	case FM_PEB_USED:
+	case FM_PEB_SCRUB:
+		return peb->vol != -1;
+	default:
+		return 0;
+	}
+}
+
+/**
+ * add_fastmap - add what the fastmap says to the scanning information.
+ * @ubi: UBI device description object
+ * @si: scanning information
+ * @fm: fastmap information
+ *
+ * This function adds the PEBs which the fastmap describes, then scans the
+ * others. It returns the number of PEBs scanned in case of success and a
+ * negative error code in case of failure.
+ */
+static int add_fastmap(struct ubi_device *ubi, struct ubi_scan_info *si,
+		       struct fm_info *fm)
+{
+	struct ubi_scan_volume *sv;
+	struct fm_peb *peb;
+	int pnum, i, err, scanned = 0;
+
+	for (i = 0; i < fm->vol_count; i++) {
+		if (!add_volume(si, fm->vols[i]))
+			return -ENOMEM;
+	}
+
+	si->is_empty = 0;
+	for (pnum = 0; pnum < ubi->peb_count; pnum++) {
+		peb = &fm->pebs[pnum];
+		if (!fm_described(peb))
+			continue;
+
+		switch (peb->state) {
+		case FM_PEB_FREE:
+			err = ubi_scan_add_to_list(si, pnum, peb->ec,
+						   &si->free);
+			break;
+		case FM_PEB_ERASE:
+			err = ubi_scan_add_to_list(si, pnum, peb->ec,
+						   &si->erase);
+			break;
+		case FM_PEB_FASTMAP:
+			/* Keep the fastmap intact until it is invalidated */
+			err = ubi_scan_add_to_list(si, pnum, peb->ec,
+						   &si->alien);
+			si->alien_peb_count += 1;
+			break;
+		default:
+			sv = ubi_scan_find_sv(si,
+					be32_to_cpu(fm->vols[peb->vol]->vol_id));
+			err = add_leb(sv, pnum, peb);
+			break;
+		}
+		if (err)
+			return err;
+
+		si->ec_sum += peb->ec;
+		si->ec_count += 1;
+		if (peb->ec > si->max_ec)
+			si->max_ec = peb->ec;
+		if (peb->ec < si->min_ec)
+			si->min_ec = peb->ec;
+	}
+
+	/* Scan the pools and anything else the fastmap is not sure about */
+	for (pnum = 0; pnum < ubi->peb_count; pnum++) {
+		if (fm_described(&fm->pebs[pnum]))
+			continue;
+
+		cond_resched();
+		err = ubi_scan_process_eb(ubi, si, pnum);
+		if (err < 0)
+			return err;
+		scanned++;
+	}
+
+	return scanned;
+}
+
+/**
+ * ubi_scan_fastmap - attach an MTD device using its fastmap.
+ * @ubi: UBI device description object
+ * @si: empty scanning information to fill in
+ *
+ * This function looks for a fastmap and, if there is a valid one, fills in
+ * @si from it, scanning only the PEBs which the fastmap does not describe.
+ * It returns zero in case of success, %UBI_NO_FASTMAP if the whole device
+ * must be scanned instead, or a negative error code in case of failure. Any
+ * information added to @si must be thrown away if %UBI_NO_FASTMAP is
+ * returned.
+ */
+int ubi_scan_fastmap(struct ubi_device *ubi, struct ubi_scan_info *si)
+{
+	struct ubi_vid_hdr *vid_hdr;
+	unsigned long long sqnum;
+	struct fm_info fm;
+	void *buf = NULL;
+	int anchor, size, pnum, err;
+
+	ubi->fm_anchor = -1;
+	memset(&fm, '\0', sizeof(fm));
+
+	err = -ENOMEM;
+	vid_hdr = ubi_zalloc_vid_hdr(ubi, GFP_KERNEL);
+	if (!vid_hdr)
+		return err;
+	fm.pebs = vmalloc(ubi->peb_count * sizeof(struct fm_peb));
+	if (!fm.pebs)
+		goto out;
+	for (pnum = 0; pnum < ubi->peb_count; pnum++) {
+		fm.pebs[pnum].state = FM_PEB_UNKNOWN;
+		fm.pebs[pnum].vol = -1;
+	}
+
+	anchor = find_anchor(ubi, vid_hdr, &sqnum);
+	if (anchor < 0) {
+		err = anchor == -ENOENT ? UBI_NO_FASTMAP : anchor;
+		goto out;
+	}
+
+	err = read_fastmap(ubi, &fm, vid_hdr, anchor, &buf, &size);
+	if (err)
+		goto out;
+	err = parse_fastmap(ubi, &fm, buf, size);
+	if (err)
+		goto out;
+
+	err = add_fastmap(ubi, si, &fm);
+	if (err < 0) {
+		/* Anything but a lack of memory may be fixed by a full scan */
+		if (err != -ENOMEM)
+			err = UBI_NO_FASTMAP;
+		goto out;
+	}
+	ubi_msg("attached by fastmap at PEB %d, %d PEBs scanned", anchor, err);
+
+	/*
+	 * Reserve a sequence number newer than anything on the flash, for the
+	 * anchor which will replace this one when the fastmap is invalidated.
+	 */
+	si->max_sqnum = max(si->max_sqnum, max(fm.sqnum, sqnum)) + 1;
+	ubi->fm_sqnum = si->max_sqnum;
+	ubi->fm_anchor = anchor;
+	ubi->fm_anchor_ec = fm.pebs[anchor].ec;
+	err = 0;
+
+out:
+	vfree(buf);
+	kfree(fm.vols);
+	vfree(fm.pebs);
+	ubi_free_vid_hdr(ubi, vid_hdr);
+	return err;
+}
+
+/**
+ * ubi_fastmap_invalidate - make sure that the fastmap is not used again.
+ * @ubi: UBI device description object
+ *
+ * U-Boot cannot keep the fastmap up to date, so this function must be called
+ * before anything on the flash is changed. The first time it is called after
+ * attaching by fastmap, it erases the fastmap anchor and writes an empty
+ * anchor in its place, with a newer sequence number than any other. This
+ * function returns zero in case of success and a negative error code in case
+ * of failure.
+ */
+int ubi_fastmap_invalidate(struct ubi_device *ubi)
+{
+	struct ubi_vid_hdr *vid_hdr;
+	int pnum = ubi->fm_anchor;
+	int err;
+
+	if (pnum < 0)
+		return 0;
+
+	/* The writes below must not come back here */
+	ubi->fm_anchor = -1;
+
+	err = -ENOMEM;
+	vid_hdr = ubi_zalloc_vid_hdr(ubi, GFP_KERNEL);
+	if (!vid_hdr)
+		goto out;
+
+	err = ubi_scan_erase_peb(ubi, NULL, pnum, ubi->fm_anchor_ec + 1);
+	if (err)
+		goto out_free;
+
+	vid_hdr->vol_type = UBI_VID_DYNAMIC;
+	vid_hdr->vol_id = cpu_to_be32(UBI_FM_SB_VOLUME_ID);
+	vid_hdr->compat = UBI_COMPAT_DELETE;
+	vid_hdr->sqnum = cpu_to_be64(ubi->fm_sqnum);
+	err = ubi_io_write_vid_hdr(ubi, pnum, vid_hdr);
+	if (!err)
+		dbg_msg("fastmap at PEB %d invalidated", pnum);
+
+out_free:
+	ubi_free_vid_hdr(ubi, vid_hdr);
+out:
+	/* Try again next time, rather than leave a stale fastmap */
+	if (err) {
+		ubi_err("cannot invalidate fastmap at PEB %d", pnum);
+		ubi->fm_anchor = pnum;
+	}
+	return err;
+}
@@ -236,6 +236,10 @@ int ubi_io_write(struct ubi_device *ubi, const void *buf, int pnum, int offset,
 		return -EROFS;
 	}
 
+	err = ubi_fastmap_invalidate(ubi);
+	if (err)
+		return err;
+
 	/* The below has to be compiled out if paranoid checks are disabled */
 
 	err = paranoid_check_not_bad(ubi, pnum);
@@ -486,6 +490,10 @@ int ubi_io_sync_erase(struct ubi_device *ubi, int pnum, int torture)
 		return -EROFS;
 	}
 
+	err = ubi_fastmap_invalidate(ubi);
+	if (err)
+		return err;
+
 	if (torture) {
 		ret = torture_peb(ubi, pnum);
 		if (ret < 0)
@@ -60,7 +60,7 @@ static struct ubi_ec_hdr *ech;
 static struct ubi_vid_hdr *vidh;
 
 /**
- * add_to_list - add physical eraseblock to a list.
+ * ubi_scan_add_to_list - add physical eraseblock to a list.
  * @si: scanning information
  * @pnum: physical eraseblock number to add
  * @ec: erase counter of the physical eraseblock
@@ -70,8 +70,8 @@ static struct ubi_vid_hdr *vidh;
  * alien lists. Returns zero in case of success and a negative error code in
  * case of failure.
  */
-static int add_to_list(struct ubi_scan_info *si, int pnum, int ec,
-		       struct list_head *list)
+int ubi_scan_add_to_list(struct ubi_scan_info *si, int pnum, int ec,
+			 struct list_head *list)
 {
 	struct ubi_scan_leb *seb;
 
@@ -495,11 +495,11 @@ int ubi_scan_add_used(struct ubi_device *ubi, struct ubi_scan_info *si,
 				return err;
 
 			if (cmp_res & 4)
-				err = add_to_list(si, seb->pnum, seb->ec,
-						  &si->corr);
+				err = ubi_scan_add_to_list(si, seb->pnum,
+							   seb->ec, &si->corr);
 			else
-				err = add_to_list(si, seb->pnum, seb->ec,
-						  &si->erase);
+				err = ubi_scan_add_to_list(si, seb->pnum,
+							   seb->ec, &si->erase);
 			if (err)
 				return err;
 
@@ -520,9 +520,11 @@ int ubi_scan_add_used(struct ubi_device *ubi, struct ubi_scan_info *si,
 			 * previously.
 			 */
 			if (cmp_res & 4)
-				return add_to_list(si, pnum, ec, &si->corr);
+				return ubi_scan_add_to_list(si, pnum, ec,
+							    &si->corr);
 			else
-				return add_to_list(si, pnum, ec, &si->erase);
+				return ubi_scan_add_to_list(si, pnum, ec,
+							    &si->erase);
 		}
 	}
 
@@ -746,16 +748,18 @@ struct ubi_scan_leb *ubi_scan_get_free_peb(struct ubi_device *ubi,
 }
 
 /**
- * process_eb - read UBI headers, check them and add corresponding data
- * to the scanning information.
+ * ubi_scan_process_eb - read UBI headers, check them and add corresponding
+ * data to the scanning information.
  * @ubi: UBI device description object
  * @si: scanning information
  * @pnum: the physical eraseblock number
  *
- * This function returns a zero if the physical eraseblock was successfully
- * handled and a negative error code in case of failure.
+ * This function uses the temporary headers allocated by ubi_scan(), so it may
+ * only be called from there. It returns a zero if the physical eraseblock was
+ * successfully handled and a negative error code in case of failure.
  */
-static int process_eb(struct ubi_device *ubi, struct ubi_scan_info *si, int pnum)
+int ubi_scan_process_eb(struct ubi_device *ubi, struct ubi_scan_info *si,
+			int pnum)
 {
 	long long uninitialized_var(ec);
 	int err, bitflips = 0, vol_id, ec_corr = 0;
@@ -781,7 +785,8 @@ static int process_eb(struct ubi_device *ubi, struct ubi_scan_info *si, int pnum
 	else if (err == UBI_IO_BITFLIPS)
 		bitflips = 1;
 	else if (err == UBI_IO_PEB_EMPTY)
-		return add_to_list(si, pnum, UBI_SCAN_UNKNOWN_EC, &si->erase);
+		return ubi_scan_add_to_list(si, pnum, UBI_SCAN_UNKNOWN_EC,
+					    &si->erase);
 	else if (err == UBI_IO_BAD_EC_HDR) {
 		/*
 		 * We have to also look at the VID header, possibly it is not
@@ -829,13 +834,13 @@ static int process_eb(struct ubi_device *ubi, struct ubi_scan_info *si, int pnum
 	else if (err == UBI_IO_BAD_VID_HDR ||
 		 (err == UBI_IO_PEB_FREE && ec_corr)) {
 		/* VID header is corrupted */
-		err = add_to_list(si, pnum, ec, &si->corr);
+		err = ubi_scan_add_to_list(si, pnum, ec, &si->corr);
 		if (err)
 			return err;
 		goto adjust_mean_ec;
 	} else if (err == UBI_IO_PEB_FREE) {
 		/* No VID header - the physical eraseblock is free */
-		err = add_to_list(si, pnum, ec, &si->free);
+		err = ubi_scan_add_to_list(si, pnum, ec, &si->free);
 		if (err)
 			return err;
 		goto adjust_mean_ec;
@@ -850,7 +855,7 @@ static int process_eb(struct ubi_device *ubi, struct ubi_scan_info *si, int pnum
 		case UBI_COMPAT_DELETE:
 			ubi_msg("\"delete\" compatible internal volume %d:%d"
 				" found, remove it", vol_id, lnum);
-			err = add_to_list(si, pnum, ec, &si->corr);
+			err = ubi_scan_add_to_list(si, pnum, ec, &si->corr);
 			if (err)
 				return err;
 			break;
@@ -865,7 +870,7 @@ static int process_eb(struct ubi_device *ubi, struct ubi_scan_info *si, int pnum
 		case UBI_COMPAT_PRESERVE:
 			ubi_msg("\"preserve\" compatible internal volume %d:%d"
 				" found", vol_id, lnum);
-			err = add_to_list(si, pnum, ec, &si->alien);
+			err = ubi_scan_add_to_list(si, pnum, ec, &si->alien);
 			if (err)
 				return err;
 			si->alien_peb_count += 1;
@@ -896,12 +901,38 @@ adjust_mean_ec:
 	return 0;
 }
 
+/**
+ * alloc_si - allocate empty scanning information.
+ *
+ * This function returns a pointer to the new scanning information, or %NULL
+ * if there is not enough memory.
+ */
+static struct ubi_scan_info *alloc_si(void)
+{
+	struct ubi_scan_info *si;
+
+	si = kzalloc(sizeof(struct ubi_scan_info), GFP_KERNEL);
+	if (!si)
+		return NULL;
+
+	INIT_LIST_HEAD(&si->corr);
+	INIT_LIST_HEAD(&si->free);
+	INIT_LIST_HEAD(&si->erase);
+	INIT_LIST_HEAD(&si->alien);
+	si->volumes = RB_ROOT;
+	si->is_empty = 1;
+
+	return si;
+}
+
 /**
  * ubi_scan - scan an MTD device.
  * @ubi: UBI device description object
  *
  * This function does full scanning of an MTD device and returns complete
- * information about it. In case of failure, an error code is returned.
+ * information about it. If the device has a valid fastmap, only the PEBs it
+ * does not describe are scanned. In case of failure, an error code is
+ * returned.
  */
 struct ubi_scan_info *ubi_scan(struct ubi_device *ubi)
 {
@@ -911,17 +942,10 @@ struct ubi_scan_info *ubi_scan(struct ubi_device *ubi)
 	struct ubi_scan_leb *seb;
 	struct ubi_scan_info *si;
 
-	si = kzalloc(sizeof(struct ubi_scan_info), GFP_KERNEL);
+	si = alloc_si();
 	if (!si)
 		return ERR_PTR(-ENOMEM);
 
-	INIT_LIST_HEAD(&si->corr);
-	INIT_LIST_HEAD(&si->free);
-	INIT_LIST_HEAD(&si->erase);
-	INIT_LIST_HEAD(&si->alien);
-	si->volumes = RB_ROOT;
-	si->is_empty = 1;
-
 	err = -ENOMEM;
 	ech = kzalloc(ubi->ec_hdr_alsize, GFP_KERNEL);
 	if (!ech)
@@ -931,13 +955,27 @@ struct ubi_scan_info *ubi_scan(struct ubi_device *ubi)
 	if (!vidh)
 		goto out_ech;
 
-	for (pnum = 0; pnum < ubi->peb_count; pnum++) {
-		cond_resched();
-
-		dbg_msg("process PEB %d", pnum);
-		err = process_eb(ubi, si, pnum);
-		if (err < 0)
+	/* Use the fastmap if there is one, else look at every PEB */
+	err = ubi_scan_fastmap(ubi, si);
+	if (err < 0)
+		goto out_vidh;
+	else if (err == UBI_NO_FASTMAP) {
+		/* Forget anything taken from the fastmap and start again */
+		ubi_scan_destroy_si(si);
+		si = alloc_si();
+		if (!si) {
+			err = -ENOMEM;
 			goto out_vidh;
+		}
+
+		for (pnum = 0; pnum < ubi->peb_count; pnum++) {
+			cond_resched();
+
+			dbg_msg("process PEB %d", pnum);
+			err = ubi_scan_process_eb(ubi, si, pnum);
+			if (err < 0)
+				goto out_vidh;
+		}
 	}
 
 	dbg_msg("scanning is finished");
@@ -991,7 +1029,8 @@ out_vidh:
 out_ech:
 	kfree(ech);
 out_si:
-	ubi_scan_destroy_si(si);
+	if (si)
+		ubi_scan_destroy_si(si);
 	return ERR_PTR(err);
 }
 
@@ -147,6 +147,10 @@ static inline void ubi_scan_move_to_list(struct ubi_scan_volume *sv,
 		list_add_tail(&seb->u.list, list);
 }
 
+int ubi_scan_add_to_list(struct ubi_scan_info *si, int pnum, int ec,
+			 struct list_head *list);
+int ubi_scan_process_eb(struct ubi_device *ubi, struct ubi_scan_info *si,
+			int pnum);
 int ubi_scan_add_used(struct ubi_device *ubi, struct ubi_scan_info *si,
 		      int pnum, int ec, const struct ubi_vid_hdr *vid_hdr,
 		      int bitflips);
@@ -162,4 +166,14 @@ int ubi_scan_erase_peb(struct ubi_device *ubi, const struct ubi_scan_info *si,
 struct ubi_scan_info *ubi_scan(struct ubi_device *ubi);
 void ubi_scan_destroy_si(struct ubi_scan_info *si);
 
+/* Returned by ubi_scan_fastmap() if the whole device must be scanned */
+#define UBI_NO_FASTMAP 1
+
+/* fastmap.c */
+#ifdef CONFIG_MTD_UBI_FASTMAP
+int ubi_scan_fastmap(struct ubi_device *ubi, struct ubi_scan_info *si);
+#else
+#define ubi_scan_fastmap(ubi, si) UBI_NO_FASTMAP
+#endif
+
 #endif /* !__UBI_SCAN_H__ */
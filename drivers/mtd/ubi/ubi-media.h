@@ -369,4 +369,154 @@ struct ubi_vtbl_record {
 	__be32  crc;
 } __attribute__ ((packed));
 
+/*
+ * Fastmap
+ *
+ * The fastmap is an on-flash snapshot of the state of every physical
+ * eraseblock, written by Linux so that a device can be attached without
+ * scanning all of it. It is stored in up to %UBI_FM_MAX_BLOCKS physical
+ * eraseblocks. The first, called the anchor, is one of the first
+ * %UBI_FM_MAX_START PEBs and belongs to internal volume
+ * %UBI_FM_SB_VOLUME_ID; the rest belong to %UBI_FM_DATA_VOLUME_ID. The data
+ * area of each fastmap PEB holds one piece of the fastmap, which is laid out
+ * as follows:
+ *
+ *	struct ubi_fm_sb
+ *	struct ubi_fm_hdr
+ *	struct ubi_fm_scan_pool (the user pool)
+ *	struct ubi_fm_scan_pool (the wear-leveling pool)
+ *	struct ubi_fm_ec for each free, used, scrub and erase PEB, in that order
+ *	struct ubi_fm_volhdr and struct ubi_fm_eba for each volume
+ *
+ * PEBs in the pools may have been written since the fastmap was, so they
+ * must always be scanned.
+ */
+#define UBI_FM_SB_VOLUME_ID	(UBI_LAYOUT_VOLUME_ID + 1)
+#define UBI_FM_DATA_VOLUME_ID	(UBI_LAYOUT_VOLUME_ID + 2)
+
+/* The version of the fastmap format supported by this implementation */
+#define UBI_FM_FMT_VERSION	1
+
+#define UBI_FM_SB_MAGIC		0x7B11D69F
+#define UBI_FM_HDR_MAGIC	0xD4B82EF7
+#define UBI_FM_VHDR_MAGIC	0xFA370ED1
+#define UBI_FM_POOL_MAGIC	0x67AF4D08
+#define UBI_FM_EBA_MAGIC	0xf0c040a8
+
+/* The anchor must be in one of the first UBI_FM_MAX_START PEBs */
+#define UBI_FM_MAX_START	64
+
+/* Maximum number of PEBs used by a fastmap */
+#define UBI_FM_MAX_BLOCKS	32
+
+/* Maximum number of PEBs in each pool */
+#define UBI_FM_MAX_POOL_SIZE	256
+
+/**
+ * struct ubi_fm_sb - UBI fastmap super block
+ * @magic: fastmap super block magic number (%UBI_FM_SB_MAGIC)
+ * @version: format version of this fastmap
+ * @padding1: reserved
+ * @data_crc: CRC over the whole fastmap, calculated with this field zero
+ * @used_blocks: number of PEBs used by this fastmap
+ * @block_loc: an array containing the location of all PEBs of the fastmap
+ * @block_ec: the erase counter of each used PEB
+ * @sqnum: highest sequence number value at the time the fastmap was taken
+ * @padding2: reserved
+ */
+struct ubi_fm_sb {
+	__be32 magic;
+	__u8 version;
+	__u8 padding1[3];
+	__be32 data_crc;
+	__be32 used_blocks;
+	__be32 block_loc[UBI_FM_MAX_BLOCKS];
+	__be32 block_ec[UBI_FM_MAX_BLOCKS];
+	__be64 sqnum;
+	__u8 padding2[32];
+} __attribute__ ((packed));
+
+/**
+ * struct ubi_fm_hdr - header of the fastmap data set
+ * @magic: fastmap header magic number (%UBI_FM_HDR_MAGIC)
+ * @free_peb_count: number of free PEBs known by this fastmap
+ * @used_peb_count: number of used PEBs known by this fastmap
+ * @scrub_peb_count: number of to be scrubbed PEBs known by this fastmap
+ * @bad_peb_count: number of bad PEBs known by this fastmap
+ * @erase_peb_count: number of PEBs which have to be erased
+ * @vol_count: number of UBI volumes known by this fastmap
+ * @padding: reserved
+ */
+struct ubi_fm_hdr {
+	__be32 magic;
+	__be32 free_peb_count;
+	__be32 used_peb_count;
+	__be32 scrub_peb_count;
+	__be32 bad_peb_count;
+	__be32 erase_peb_count;
+	__be32 vol_count;
+	__u8 padding[4];
+} __attribute__ ((packed));
+
+/**
+ * struct ubi_fm_scan_pool - fastmap pool PEBs to be scanned while attaching
+ * @magic: pool magic number (%UBI_FM_POOL_MAGIC)
+ * @size: current pool size
+ * @max_size: maximal pool size
+ * @pebs: an array containing the location of all PEBs in this pool
+ * @padding: reserved
+ */
+struct ubi_fm_scan_pool {
+	__be32 magic;
+	__be16 size;
+	__be16 max_size;
+	__be32 pebs[UBI_FM_MAX_POOL_SIZE];
+	__be32 padding[4];
+} __attribute__ ((packed));
+
+/**
+ * struct ubi_fm_ec - stores the erase counter of a PEB
+ * @pnum: PEB number
+ * @ec: erase counter
+ */
+struct ubi_fm_ec {
+	__be32 pnum;
+	__be32 ec;
+} __attribute__ ((packed));
+
+/**
+ * struct ubi_fm_volhdr - fastmap volume header
+ * @magic: fastmap volume header magic number (%UBI_FM_VHDR_MAGIC)
+ * @vol_id: volume id of the fastmapped volume
+ * @vol_type: type of the fastmapped volume (%UBI_DYNAMIC_VOLUME or
+ * %UBI_STATIC_VOLUME)
+ * @padding1: reserved
+ * @data_pad: data_pad value of the fastmapped volume
+ * @used_ebs: number of used LEBs within this volume
+ * @last_eb_bytes: number of bytes used in the last LEB
+ * @padding2: reserved
+ */
+struct ubi_fm_volhdr {
+	__be32 magic;
+	__be32 vol_id;
+	__u8 vol_type;
+	__u8 padding1[3];
+	__be32 data_pad;
+	__be32 used_ebs;
+	__be32 last_eb_bytes;
+	__u8 padding2[8];
+} __attribute__ ((packed));
+
+/**
+ * struct ubi_fm_eba - denotes an association between a PEB and LEB
+ * @magic: EBA table magic number (%UBI_FM_EBA_MAGIC)
+ * @reserved_pebs: number of table entries
+ * @pnum: PEB number of LEB (LEB is the index), or -1 if it is not mapped
+ */
+struct ubi_fm_eba {
+	__be32 magic;
+	__be32 reserved_pebs;
+	__be32 pnum[0];
+} __attribute__ ((packed));
+
 #endif /* !__UBI_MEDIA_H__ */
@@ -346,6 +346,11 @@ struct ubi_wl_entry;
  * @buf_mutex: proptects @peb_buf1 and @peb_buf2
  * @dbg_peb_buf: buffer of PEB size used for debugging
  * @dbg_buf_mutex: proptects @dbg_peb_buf
+ *
+ * @fm_anchor: fastmap anchor PEB the device was attached from, or -1 if the
+ *             fastmap was not used or has been invalidated
+ * @fm_anchor_ec: erase counter of @fm_anchor
+ * @fm_sqnum: sequence number reserved for invalidating the fastmap
  */
 struct ubi_device {
 	struct cdev cdev;
@@ -428,6 +433,11 @@ struct ubi_device {
 	void *dbg_peb_buf;
 	struct mutex dbg_buf_mutex;
 #endif
+#ifdef CONFIG_MTD_UBI_FASTMAP
+	int fm_anchor;
+	int fm_anchor_ec;
+	unsigned long long fm_sqnum;
+#endif
 };
 
 extern struct kmem_cache *ubi_wl_entry_slab;
@@ -523,6 +533,13 @@ int ubi_io_read_vid_hdr(struct ubi_device *ubi, int pnum,
 int ubi_io_write_vid_hdr(struct ubi_device *ubi, int pnum,
 			 struct ubi_vid_hdr *vid_hdr);
 
+/* fastmap.c */
+#ifdef CONFIG_MTD_UBI_FASTMAP
+int ubi_fastmap_invalidate(struct ubi_device *ubi);
+#else
+#define ubi_fastmap_invalidate(ubi) 0
+#endif
+
 /* build.c */
 int ubi_attach_mtd_dev(struct mtd_info *mtd, int ubi_num, int vid_hdr_offset);
 int ubi_detach_mtd_dev(int ubi_num, int anyway);
@@ -34,6 +34,10 @@
 #define CONFIG_SYS_NS16550_IER  0x00
 #endif /* CONFIG_SYS_NS16550_IER */
 
+#ifndef CONFIG_SYS_NS16550_FIFO_SIZE
+#define CONFIG_SYS_NS16550_FIFO_SIZE	1
+#endif
+
 void NS16550_init(NS16550_t com_port, int baud_divisor)
 {
 #if (defined(CONFIG_SPL_BUILD) && defined(CONFIG_OMAP34XX))
@@ -118,6 +122,30 @@ void NS16550_putc(NS16550_t com_port, char c)
 }
 
 #ifndef CONFIG_NS16550_MIN_FUNCTIONS
+int NS16550_write(NS16550_t com_port, const char *s, int len, int nowait)
+{
+	int done = 0;
+	int i;
+
+	while (done < len) {
+		if ((serial_in(&com_port->lsr) & UART_LSR_THRE) == 0) {
+			if (nowait)
+				break;
+			continue;
+		}
+
+		/* THRE means the whole transmit FIFO is empty, so fill it */
+		for (i = 0; i < CONFIG_SYS_NS16550_FIFO_SIZE && done < len;
+		     i++) {
+			if (s[done] == '\n')
+				WATCHDOG_RESET();
+			serial_out(s[done++], &com_port->thr);
+		}
+	}
+
+	return done;
+}
+
 char NS16550_getc(NS16550_t com_port)
 {
 	while ((serial_in(&com_port->lsr) & UART_LSR_DR) == 0) {
@@ -204,6 +204,8 @@ void serial_register(struct serial_device *dev)
 		dev->putc += gd->reloc_off;
 	if (dev->puts)
 		dev->puts += gd->reloc_off;
+	if (dev->flush)
+		dev->flush += gd->reloc_off;
 #endif
 
 	dev->next = serial_devices;
@@ -479,6 +481,24 @@ void serial_puts(const char *s)
 	get_current()->puts(s);
 }
 
+#if defined(CONFIG_SERIAL_TX_BUFFER) && !defined(CONFIG_SPL_BUILD)
+int serial_flush(int wait)
+{
+	struct serial_device *s;
+	int pending = 0;
+
+	/* Devices are only registered after relocation */
+	if (!(gd->flags & GD_FLG_RELOC))
+		return 0;
+	for (s = serial_devices; s; s = s->next) {
+		if (s->flush)
+			pending += s->flush(wait);
+	}
+
+	return pending;
+}
+#endif
+
 /**
  * default_serial_puts() - Output string by calling serial_putc() in loop
  * @s:	Zero-terminated string to be output from the serial port.
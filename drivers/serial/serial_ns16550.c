@@ -22,6 +22,7 @@
  */
 
 #include <common.h>
+#include <watchdog.h>
 #include <linux/compiler.h>
 
 #include <ns16550.h>
@@ -92,11 +93,84 @@ static NS16550_t serial_ports[6] = {
 
 #define PORT	serial_ports[port-1]
 
+#ifdef CONFIG_SERIAL_TX_BUFFER
+#ifndef CONFIG_SERIAL_TX_BUFFER_SIZE
+#define CONFIG_SERIAL_TX_BUFFER_SIZE	1024
+#endif
+#if CONFIG_SERIAL_TX_BUFFER_SIZE & (CONFIG_SERIAL_TX_BUFFER_SIZE - 1)
+#error "CONFIG_SERIAL_TX_BUFFER_SIZE must be a power of 2"
+#endif
+
+/*
+ * Output waiting to go to each port. 'head' counts the characters added
+ * and 'tail' those sent, so the buffer is empty when they are equal. This
+ * is in BSS, so it can only be used after relocation.
+ */
+struct ns16550_tx_buf {
+	unsigned int head;
+	unsigned int tail;
+	char buf[CONFIG_SERIAL_TX_BUFFER_SIZE];
+};
+
+static struct ns16550_tx_buf tx_bufs[ARRAY_SIZE(serial_ports)];
+
+/*
+ * Send buffered output, either as much as the UART will take now or, if
+ * wait is set, all of it. Returns the number of characters still waiting.
+ */
+static int tx_buf_drain(const int port, int wait)
+{
+	struct ns16550_tx_buf *tx = &tx_bufs[port - 1];
+	unsigned int start, len, done;
+
+	if (!(gd->flags & GD_FLG_RELOC))
+		return 0;
+	while (tx->tail != tx->head) {
+		start = tx->tail % CONFIG_SERIAL_TX_BUFFER_SIZE;
+		len = min(tx->head - tx->tail,
+			  CONFIG_SERIAL_TX_BUFFER_SIZE - start);
+		done = NS16550_write(PORT, tx->buf + start, len, !wait);
+		tx->tail += done;
+		if (done < len)
+			break;
+	}
+
+	return tx->head - tx->tail;
+}
+
+static void tx_buf_add(const int port, char c)
+{
+	struct ns16550_tx_buf *tx = &tx_bufs[port - 1];
+
+	/* When the buffer is full, wait for the UART to take some */
+	while (tx->head - tx->tail == CONFIG_SERIAL_TX_BUFFER_SIZE)
+		tx_buf_drain(port, 0);
+	tx->buf[tx->head++ % CONFIG_SERIAL_TX_BUFFER_SIZE] = c;
+}
+
+#define DECLARE_ESERIAL_FLUSH(port) \
+	static int eserial##port##_flush(int wait) \
+	{ \
+		return tx_buf_drain(port, wait); \
+	}
+#define INIT_ESERIAL_FLUSH(port) \
+	.flush	= eserial##port##_flush,
+#else
+#define DECLARE_ESERIAL_FLUSH(port)
+#define INIT_ESERIAL_FLUSH(port)
+
+static inline int tx_buf_drain(const int port, int wait)
+{
+	return 0;
+}
+#endif /* CONFIG_SERIAL_TX_BUFFER */
+
 /* Multi serial device functions */
 #define DECLARE_ESERIAL_FUNCTIONS(port) \
 	static int  eserial##port##_init(void) \
 	{ \
 		int clock_divisor; \
+		tx_buf_drain(port, 1); \
 		clock_divisor = calc_divisor(serial_ports[port-1]); \
 		NS16550_init(serial_ports[port-1], clock_divisor); \
 		return 0 ; \
@@ -120,7 +194,8 @@ static NS16550_t serial_ports[6] = {
 	static void eserial##port##_puts(const char *s) \
 	{ \
 		serial_puts_dev(port, s); \
-	}
+	} \
+	DECLARE_ESERIAL_FLUSH(port)
 
 /* Serial device descriptor */
 #define INIT_ESERIAL_STRUCTURE(port, __name) {	\
@@ -132,6 +207,7 @@ static NS16550_t serial_ports[6] = {
 	.tstc	= eserial##port##_tstc,		\
 	.putc	= eserial##port##_putc,		\
 	.puts	= eserial##port##_puts,		\
+	INIT_ESERIAL_FLUSH(port)		\
 }
 
 static int calc_divisor (NS16550_t port)
@@ -169,6 +245,15 @@ static int calc_divisor (NS16550_t port)
 void
 _serial_putc(const char c,const int port)
 {
+#ifdef CONFIG_SERIAL_TX_BUFFER
+	if (gd->flags & GD_FLG_RELOC) {
+		if (c == '\n')
+			tx_buf_add(port, '\r');
+		tx_buf_add(port, c);
+		tx_buf_drain(port, 0);
+		return;
+	}
+#endif
 	if (c == '\n')
 		NS16550_putc(PORT, '\r');
 
@@ -178,14 +263,42 @@ _serial_putc(const char c,const int port)
 void
 _serial_putc_raw(const char c,const int port)
 {
+#ifdef CONFIG_SERIAL_TX_BUFFER
+	if (gd->flags & GD_FLG_RELOC) {
+		tx_buf_add(port, c);
+		tx_buf_drain(port, 0);
+		return;
+	}
+#endif
 	NS16550_putc(PORT, c);
 }
 
 void
 _serial_puts (const char *s,const int port)
 {
+	int len;
+
+#ifdef CONFIG_SERIAL_TX_BUFFER
+	if (gd->flags & GD_FLG_RELOC) {
+		for (; *s; s++) {
+			if (*s == '\n')
+				tx_buf_add(port, '\r');
+			tx_buf_add(port, *s);
+		}
+		tx_buf_drain(port, 0);
+		return;
+	}
+#endif
+	/* Write each line a FIFO's worth at a time */
 	while (*s) {
-		_serial_putc (*s++,port);
+		for (len = 0; s[len] && s[len] != '\n'; len++)
+			;
+		NS16550_write(PORT, s, len, 0);
+		s += len;
+		if (*s == '\n') {
+			NS16550_write(PORT, "\r\n", 2, 0);
+			s++;
+		}
 	}
 }
 
@@ -193,12 +306,18 @@ _serial_puts (const char *s,const int port)
 int
 _serial_getc(const int port)
 {
+	/* Send buffered output while waiting for input */
+	while (tx_buf_drain(port, 0) && !NS16550_tstc(PORT))
+		WATCHDOG_RESET();
+
 	return NS16550_getc(PORT);
 }
 
 int
 _serial_tstc(const int port)
 {
+	tx_buf_drain(port, 0);
+
 	return NS16550_tstc(PORT);
 }
 
@@ -207,6 +326,7 @@ _serial_setbrg (const int port)
 {
 	int clock_divisor;
 
+	tx_buf_drain(port, 1);
 	clock_divisor = calc_divisor(PORT);
 	NS16550_reinit(PORT, clock_divisor);
 }
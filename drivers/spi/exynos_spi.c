@@ -111,6 +111,11 @@ struct spi_slave *spi_setup_slave(unsigned int busnum, unsigned int cs,
 
 	spi_slave->last_transaction_us = timer_get_us();
 
+	/*
+	 * This controller only has a single data line in each direction, so
+	 * we leave rx_mode at 0 and flash reads use single-wire fast read.
+	 */
+
 	spi_slave->freq = bus->frequency;
 	if (max_hz)
 		spi_slave->freq = min(max_hz, spi_slave->freq);
@@ -354,6 +359,12 @@ int spi_xfer(struct spi_slave *slave, unsigned int bitlen, const void *dout,
 		return -1;
 	}
 
+	/* We don't set rx_mode, so the flash layer should never ask for this */
+	if (flags & (SPI_XFER_DUAL | SPI_XFER_QUAD)) {
+		debug("Multi-wire SPI transfer not supported.\n");
+		return -1;
+	}
+
 	/* Start the transaction, if necessary. */
 	if ((flags & SPI_XFER_BEGIN))
 		spi_cs_activate(slave);
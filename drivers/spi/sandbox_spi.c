@@ -103,6 +103,9 @@ struct spi_slave *spi_setup_slave(unsigned int bus, unsigned int cs,
 		return NULL;
 	}
 
+	/* Bytes are bytes here, so allow dual and quad reads for testing */
+	sss->slave.rx_mode = SPI_RX_DUAL | SPI_RX_QUAD;
+
 	return &sss->slave;
 }
 
@@ -157,6 +160,14 @@ int spi_xfer(struct spi_slave *slave, unsigned int bitlen, const void *dout,
 		goto done;
 	}
 
+	/* Multi-wire transfers can only carry data from the slave */
+	if ((flags & (SPI_XFER_DUAL | SPI_XFER_QUAD)) && dout) {
+		printf("sandbox_spi: xfer: cannot send data on multiple wires\n");
+		flags |= SPI_XFER_END;
+		ret = -EINVAL;
+		goto done;
+	}
+
 	if (flags & SPI_XFER_BEGIN)
 		spi_cs_activate(slave);
 
@@ -273,6 +273,7 @@
 #include <config.h>
 #include <malloc.h>
 #include <common.h>
+#include <div64.h>
 
 #include <linux/err.h>
 #include <linux/usb/ch9.h>
@@ -365,12 +366,30 @@ struct fsg_common {
 	u32			residue;
 	u32			usb_amount_left;
 
+	/* Read-ahead and write-behind of the backing medium */
+	void			*ra_buf;	/* Blocks read ahead */
+	u32			ra_lba;		/* First block in ra_buf */
+	u32			ra_count;	/* Valid blocks in ra_buf */
+	u32			ra_next;	/* Next block to read ahead */
+	void			*wb_buf;	/* Blocks not yet written */
+	u32			wb_lba;		/* First block in wb_buf */
+	u32			wb_count;	/* Blocks in wb_buf */
+
+	/* Session statistics, printed by fsg_cleanup() */
+	u64			read_bytes;
+	u64			write_bytes;
+	u64			ra_hit_bytes;
+	ulong			read_ms;
+	ulong			write_ms;
+
 	unsigned int		can_stall:1;
 	unsigned int		free_storage_on_release:1;
 	unsigned int		phase_error:1;
 	unsigned int		short_packet_received:1;
 	unsigned int		bad_lun_okay:1;
 	unsigned int		running:1;
+	unsigned int		ra_pending:1;	/* ra_next is valid */
+	unsigned int		wb_failed:1;	/* Write-behind failed */
 
 	int			thread_wakeup_needed;
 	struct completion	thread_notifier;
@@ -714,6 +733,92 @@ static int sleep_thread(struct fsg_common *common)
 
 /*-------------------------------------------------------------------------*/
 
+/*
+ * The last buffer of each WRITE is written to the medium, and the blocks
+ * following each READ are read from it, while the host is dealing with the
+ * status and sending the next command. Within a command the medium and USB
+ * already overlap, since each buffer is queued before the next is filled.
+ */
+
+/* Write any blocks left over from the last WRITE */
+static void fsg_write_behind_flush(struct fsg_common *common)
+{
+	ulong start;
+
+	if (!common->wb_count)
+		return;
+	start = get_timer(0);
+	if (ums_info->write_sector(&ums_info->ums_dev, common->wb_lba,
+				   common->wb_count, common->wb_buf)) {
+		printf("UMS: write of %u blocks at %#x failed\n",
+		       common->wb_count, common->wb_lba);
+		common->wb_failed = 1;
+	}
+	common->wb_count = 0;
+	common->write_ms += get_timer(start);
+}
+
+/* Take over a buffer's data to write later, giving it our spare buffer */
+static void fsg_write_behind(struct fsg_common *common, struct fsg_buffhd *bh,
+			     u32 lba, u32 count)
+{
+	void *buf = common->wb_buf;
+
+	fsg_write_behind_flush(common);
+	common->wb_buf = bh->buf;
+	common->wb_lba = lba;
+	common->wb_count = count;
+	bh->buf = buf;
+	bh->inreq->buf = buf;
+	bh->outreq->buf = buf;
+}
+
+/* Read the blocks following the last READ */
+static void fsg_read_ahead(struct fsg_common *common)
+{
+	struct fsg_lun *curlun = &common->luns[common->lun];
+	ulong start;
+	u32 count;
+
+	if (!common->ra_pending)
+		return;
+	common->ra_pending = 0;
+	common->ra_count = 0;
+	count = min_t(loff_t, FSG_BUFLEN / SECTOR_SIZE,
+		      curlun->num_sectors - common->ra_next);
+	start = get_timer(0);
+	if (!ums_info->read_sector(&ums_info->ums_dev, common->ra_next, count,
+				   common->ra_buf)) {
+		common->ra_lba = common->ra_next;
+		common->ra_count = count;
+	}
+	common->read_ms += get_timer(start);
+}
+
+/* Read blocks from the medium, using any that were read ahead */
+static int fsg_read_blocks(struct fsg_common *common, u32 lba, u32 count,
+			   char *buf)
+{
+	u32 ra_end = common->ra_lba + common->ra_count;
+	u32 n;
+
+	if (common->ra_count && lba >= common->ra_lba && lba < ra_end) {
+		n = min(count, ra_end - lba);
+		memcpy(buf, common->ra_buf +
+		       (lba - common->ra_lba) * SECTOR_SIZE, n * SECTOR_SIZE);
+		common->ra_hit_bytes += n * SECTOR_SIZE;
+		lba += n;
+		count -= n;
+		buf += n * SECTOR_SIZE;
+		if (!count)
+			return 0;
+	}
+
+	return ums_info->read_sector(&ums_info->ums_dev, lba, count, buf);
+}
+
+/*-------------------------------------------------------------------------*/
+
 static int do_read(struct fsg_common *common)
 {
 	struct fsg_lun		*curlun = &common->luns[common->lun];
@@ -789,13 +894,13 @@ static int do_read(struct fsg_common *common)
 
 		/* Perform the read */
 		nread = 0;
-		rc = ums_info->read_sector(&(ums_info->ums_dev),
-					   file_offset / SECTOR_SIZE,
-					   amount / SECTOR_SIZE,
-					   (char __user *)bh->buf);
+		rc = fsg_read_blocks(common, file_offset / SECTOR_SIZE,
+				     amount / SECTOR_SIZE,
+				     (char __user *)bh->buf);
 		if (rc)
 			return -EIO;
 		nread = amount;
+		common->read_bytes += nread;
 
 		VLDBG(curlun, "file read %u @ %llu -> %d\n", amount,
 				(unsigned long long) file_offset,
@@ -836,6 +941,12 @@ static int do_read(struct fsg_common *common)
 		common->next_buffhd_to_fill = bh->next;
 	}
 
+	/* Hosts usually read on from where they stopped */
+	if (common->ra_buf && (file_offset >> 9) < curlun->num_sectors) {
+		common->ra_next = file_offset >> 9;
+		common->ra_pending = 1;
+	}
+
 	return -EIO;		/* No default reply */
 }
 
@@ -852,6 +963,7 @@ static int do_write(struct fsg_common *common)
 	unsigned int		amount;
 	unsigned int		partial_page;
 	ssize_t			nwritten;
+	int			fua = 0;
 	int			rc;
 
 	if (curlun->ro) {
@@ -859,6 +971,10 @@ static int do_write(struct fsg_common *common)
 		return -EINVAL;
 	}
 
+	/* Blocks read ahead may be about to change */
+	common->ra_count = 0;
+	common->ra_pending = 0;
+
 	/* Get the starting Logical Block Address and check that it's
 	 * not too big */
 	if (common->cmnd[0] == SC_WRITE_6)
@@ -874,6 +990,7 @@ static int do_write(struct fsg_common *common)
 			curlun->sense_data = SS_INVALID_FIELD_IN_CDB;
 			return -EINVAL;
 		}
+		fua = common->cmnd[1] & 0x08;
 	}
 	if (lba >= curlun->num_sectors) {
 		curlun->sense_data = SS_LOGICAL_BLOCK_ADDRESS_OUT_OF_RANGE;
@@ -961,14 +1078,25 @@ static int do_write(struct fsg_common *common)
 
 			amount = bh->outreq->actual;
 
-			/* Perform the write */
-			rc = ums_info->write_sector(&(ums_info->ums_dev),
-					       file_offset / SECTOR_SIZE,
-					       amount / SECTOR_SIZE,
-					       (char __user *)bh->buf);
+			/* Perform the write, leaving the last buffer until
+			 * the host is dealing with the status, unless FUA */
+			if (amount == amount_left_to_write && !fua &&
+			    common->wb_buf) {
+				fsg_write_behind(common, bh,
+						 file_offset / SECTOR_SIZE,
+						 amount / SECTOR_SIZE);
+				rc = 0;
+			} else {
+				rc = ums_info->write_sector(
+					&(ums_info->ums_dev),
+					file_offset / SECTOR_SIZE,
+					amount / SECTOR_SIZE,
+					(char __user *)bh->buf);
+			}
 			if (rc)
 				return -EIO;
 			nwritten = amount;
+			common->write_bytes += nwritten;
 
 			VLDBG(curlun, "file write %u @ %llu -> %d\n", amount,
 					(unsigned long long) file_offset,
@@ -1016,6 +1144,14 @@ static int do_write(struct fsg_common *common)
 
 static int do_synchronize_cache(struct fsg_common *common)
 {
+	struct fsg_lun	*curlun = &common->luns[common->lun];
+
+	fsg_write_behind_flush(common);
+	if (common->wb_failed) {
+		common->wb_failed = 0;
+		curlun->sense_data = SS_WRITE_ERROR;
+	}
+
 	return 0;
 }
 
@@ -1763,6 +1899,14 @@ static int check_command(struct fsg_common *common, int cmnd_size,
 			curlun->sense_data = SS_NO_SENSE;
 			curlun->info_valid = 0;
 		}
+
+		/* Report a failed write-behind as a deferred error */
+		if (common->wb_failed && common->cmnd[0] != SC_INQUIRY &&
+		    common->cmnd[0] != SC_REQUEST_SENSE) {
+			common->wb_failed = 0;
+			curlun->sense_data = SS_WRITE_ERROR;
+			return -EINVAL;
+		}
 	} else {
 		curlun = NULL;
 		common->bad_lun_okay = 0;
@@ -2160,6 +2304,10 @@ static int get_next_command(struct fsg_common *common)
 	 * can reuse it for the next filling.  No need to advance
 	 * next_buffhd_to_fill. */
 
+	/* Keep the medium busy while the host sends the CBW */
+	fsg_write_behind_flush(common);
+	fsg_read_ahead(common);
+
 	/* Wait for the CBW to arrive */
 	while (bh->state != BUF_STATE_FULL) {
 		rc = sleep_thread(common);
@@ -2345,6 +2493,11 @@ static void handle_exception(struct fsg_common *common)
 			usb_ep_fifo_flush(common->fsg->bulk_out);
 	}
 
+	/* The host was told these blocks were written */
+	fsg_write_behind_flush(common);
+	common->ra_count = 0;
+	common->ra_pending = 0;
+
 	/* Reset the I/O buffer states and pointers, the SCSI
 	 * state, and the exception.  Then invoke the handler. */
 
@@ -2414,9 +2567,28 @@ static void handle_exception(struct fsg_common *common)
 
 /*-------------------------------------------------------------------------*/
 
+/* Charge the time taken by a command to reading or writing */
+static void fsg_account(struct fsg_common *common, ulong start)
+{
+	switch (common->cmnd[0]) {
+	case SC_READ_6:
+	case SC_READ_10:
+	case SC_READ_12:
+		common->read_ms += get_timer(start);
+		break;
+	case SC_WRITE_6:
+	case SC_WRITE_10:
+	case SC_WRITE_12:
+		common->write_ms += get_timer(start);
+		break;
+	}
+}
+
 int fsg_main_thread(void *common_)
 {
 	struct fsg_common	*common = the_fsg_common;
+	ulong			start;
+
 	/* The main loop */
 	do {
 		if (exception_in_progress(common)) {
@@ -2431,6 +2603,7 @@ int fsg_main_thread(void *common_)
 
 		if (get_next_command(common))
 			continue;
+		start = get_timer(0);
 
 		if (!exception_in_progress(common))
 			common->state = FSG_STATE_DATA_PHASE;
@@ -2443,6 +2616,7 @@ int fsg_main_thread(void *common_)
 
 		if (send_status(common))
 			continue;
+		fsg_account(common, start);
 
 		if (!exception_in_progress(common))
 			common->state = FSG_STATE_IDLE;
@@ -2534,6 +2708,13 @@ buffhds_first_it:
 	} while (--i);
 	bh->next = common->buffhds;
 
+	common->ra_buf = kmalloc(FSG_BUFLEN, GFP_KERNEL);
+	common->wb_buf = kmalloc(FSG_BUFLEN, GFP_KERNEL);
+	if (unlikely(!common->ra_buf || !common->wb_buf)) {
+		rc = -ENOMEM;
+		goto error_release;
+	}
+
 	snprintf(common->inquiry_string, sizeof common->inquiry_string,
 		 "%-8s%-16s%04x",
 		 "Linux   ",
@@ -2599,6 +2780,8 @@ static void fsg_common_release(struct kref *ref)
 			kfree(bh->buf);
 		} while (++bh, --i);
 	}
+	kfree(common->ra_buf);
+	kfree(common->wb_buf);
 
 	if (common->free_storage_on_release)
 		kfree(common);
@@ -2791,3 +2974,34 @@ int fsg_init(struct ums_board_info *ums)
 
 	return 0;
 }
+
+static void fsg_print_rate(const char *verb, u64 bytes, ulong ms)
+{
+	printf("UMS: %s %llu KiB in %lu.%03lus", verb, bytes >> 10,
+	       ms / 1000, ms % 1000);
+	if (ms)
+		printf(", %llu KiB/s", lldiv((bytes >> 10) * 1000, ms));
+}
+
+void fsg_cleanup(void)
+{
+	struct fsg_common *common = the_fsg_common;
+
+	if (!common)
+		return;
+	fsg_write_behind_flush(common);
+
+	fsg_print_rate("read", common->read_bytes, common->read_ms);
+	if (common->read_bytes)
+		printf(" (%llu%% read ahead)", lldiv(common->ra_hit_bytes * 100,
+						      common->read_bytes));
+	printf("\n");
+	fsg_print_rate("wrote", common->write_bytes, common->write_ms);
+	printf("\n");
+
+	common->read_bytes = 0;
+	common->write_bytes = 0;
+	common->ra_hit_bytes = 0;
+	common->read_ms = 0;
+	common->write_ms = 0;
+}
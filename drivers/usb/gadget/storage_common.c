@@ -323,11 +323,22 @@ static struct fsg_lun *fsg_lun_from_dev(struct device *dev)
 #define EP0_BUFSIZE	256
 #define DELAYED_STATUS	(EP0_BUFSIZE + 999)	/* An impossibly large value */
 
-/* Number of buffers we will use.  2 is enough for double-buffering */
+/*
+ * Number of buffers we will use.  2 is enough for double-buffering, but
+ * more lets further USB transfers be queued while the medium is busy.
+ */
+#ifdef CONFIG_USB_GADGET_FSG_NUM_BUFFERS
+#define FSG_NUM_BUFFERS	CONFIG_USB_GADGET_FSG_NUM_BUFFERS
+#else
 #define FSG_NUM_BUFFERS	2
+#endif
 
-/* Default size of buffer length. */
+/* Size of each buffer, which must be a multiple of the page size */
+#ifdef CONFIG_USB_GADGET_FSG_BUFLEN
+#define FSG_BUFLEN	((u32)CONFIG_USB_GADGET_FSG_BUFLEN)
+#else
 #define FSG_BUFLEN	((u32)16384)
+#endif
 
 /* Maximal number of LUNs supported in mass storage function */
 #define FSG_MAX_LUNS	8
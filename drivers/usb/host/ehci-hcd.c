@@ -27,6 +27,7 @@
 #include <usb.h>
 #include <asm/io.h>
 #include <malloc.h>
+#include <mempool.h>
 #include <watchdog.h>
 #include <linux/compiler.h>
 
@@ -243,6 +244,12 @@ static inline u8 ehci_encode_speed(enum usb_device_speed speed)
 	return QH_FULL_SPEED;
 }
 
+/*
+ * The qTDs for a transfer are allocated at the start and freed at the end,
+ * so take them from an arena rather than going to malloc() each time.
+ */
+static struct arena ehci_qtd_arena = ARENA_INIT("ehci-qtd", 4 << 10);
+
 static int
 ehci_submit_async(struct usb_device *dev, unsigned long pipe, void *buffer,
 		   int length, struct devrequest *req)
@@ -329,7 +336,8 @@ ehci_submit_async(struct usb_device *dev, unsigned long pipe, void *buffer,
 #if CONFIG_SYS_MALLOC_LEN <= 64 + 128 * 1024
 #warning CONFIG_SYS_MALLOC_LEN may be too small for EHCI
 #endif
-	qtd = memalign(USB_DMA_MINALIGN, qtd_count * sizeof(struct qTD));
+	qtd = arena_memalign(&ehci_qtd_arena, USB_DMA_MINALIGN,
+			     qtd_count * sizeof(struct qTD));
 	if (qtd == NULL) {
 		printf("unable to allocate TDs\n");
 		return -1;
@@ -595,11 +603,11 @@ ehci_submit_async(struct usb_device *dev, unsigned long pipe, void *buffer,
 		      ehci_readl(&ctrl->hcor->or_portsc[1]));
 	}
 
-	free(qtd);
+	arena_reset(&ehci_qtd_arena);
 	return (dev->status != USB_ST_NOT_PROC) ? 0 : -1;
 
 fail:
-	free(qtd);
+	arena_reset(&ehci_qtd_arena);
 	return -1;
 }
 
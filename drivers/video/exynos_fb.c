@@ -340,6 +340,13 @@ void lcd_ctrl_init(void *lcdbase)
 	exynos_lcd_init(&panel_info);
 }
 
+int lcd_set_display_offset(ulong offset)
+{
+	exynos_fimd_set_offset(offset);
+
+	return 0;
+}
+
 void lcd_enable(void)
 {
 	if (panel_info.logo_on) {
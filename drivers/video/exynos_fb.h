@@ -49,6 +49,7 @@ enum exynos_cpu_auto_cmd_rate {
 void exynos_fimd_lcd_init_mem(unsigned long screen_base, unsigned long fb_size,
 	unsigned long palette_size);
 void exynos_fimd_lcd_init(vidinfo_t *vid);
+void exynos_fimd_set_offset(unsigned long offset);
 unsigned long exynos_fimd_calc_fbsize(void);
 
 #endif
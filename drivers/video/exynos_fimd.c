@@ -121,11 +121,12 @@ static void exynos_fimd_set_par(unsigned int win_id)
 			EXYNOS_VIDOSD(win_id));
 }
 
-static void exynos_fimd_set_buffer_address(unsigned int win_id)
+static void exynos_fimd_set_buffer_address(unsigned int win_id,
+					   unsigned long offset)
 {
 	unsigned long start_addr, end_addr;
 
-	start_addr = (unsigned long)lcd_base_addr;
+	start_addr = (unsigned long)lcd_base_addr + offset;
 	end_addr = start_addr + ((pvid->vl_col * (NBITS(pvid->vl_bpix) / 8)) *
 				pvid->vl_row);
 
@@ -357,7 +358,7 @@ void exynos_fimd_lcd_init(vidinfo_t *vid)
 	exynos_fimd_set_par(pvid->win_id);
 
 	/* set memory address */
-	exynos_fimd_set_buffer_address(pvid->win_id);
+	exynos_fimd_set_buffer_address(pvid->win_id, 0);
 
 	/* set buffer size */
 	cfg = EXYNOS_VIDADDR_PAGEWIDTH(pvid->vl_col * NBITS(pvid->vl_bpix) / 8) |
@@ -383,6 +384,21 @@ void exynos_fimd_lcd_init(vidinfo_t *vid)
 	exynos_fimd_set_dp_clkcon(pvid->dp_enabled);
 }
 
+void exynos_fimd_set_offset(unsigned long offset)
+{
+	unsigned int cfg;
+
+	/*
+	 * Hold off the shadow register update so that the hardware never
+	 * sees a new start address with the old end address
+	 */
+	cfg = readl(&fimd_ctrl->winshmap);
+	writel(cfg | EXYNOS_WINSHMAP_PROTECT(1 << pvid->win_id),
+	       &fimd_ctrl->winshmap);
+	exynos_fimd_set_buffer_address(pvid->win_id, offset);
+	writel(cfg, &fimd_ctrl->winshmap);
+}
+
 unsigned long exynos_fimd_calc_fbsize(void)
 {
 	return pvid->vl_col * pvid->vl_row * (NBITS(pvid->vl_bpix) / 8);
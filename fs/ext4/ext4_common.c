@@ -35,6 +35,7 @@
 #include <ext_common.h>
 #include <ext4fs.h>
 #include <malloc.h>
+#include <mempool.h>
 #include <stddef.h>
 #include <linux/stat.h>
 #include <linux/time.h>
@@ -1506,6 +1507,9 @@ int ext4fs_read_inode(struct ext2_data *data, int ino, struct ext2_inode *inode)
 	return 1;
 }
 
+/* Extent blocks are read for every file block, so keep a buffer around */
+static struct mem_pool ext4_extent_pool = MEM_POOL_INIT("ext4-extent", 0, 2);
+
 long int read_allocated_block(struct ext2_inode *inode, int fileblock)
 {
 	long int blknr;
@@ -1522,12 +1526,16 @@ long int read_allocated_block(struct ext2_inode *inode, int fileblock)
 		- get_fs()->dev_desc->log2blksz;
 
 	if (le32_to_cpu(inode->flags) & EXT4_EXTENTS_FL) {
-		char *buf = zalloc(blksz);
-		if (!buf)
-			return -ENOMEM;
 		struct ext4_extent_header *ext_block;
 		struct ext4_extent *extent;
 		int i = -1;
+		char *buf;
+
+		if (mem_pool_set_size(&ext4_extent_pool, blksz))
+			return -EBUSY;
+		buf = mem_pool_alloc(&ext4_extent_pool);
+		if (!buf)
+			return -ENOMEM;
 		ext_block =
 			ext4fs_get_extent_block(ext4fs_root, buf,
 						(struct ext4_extent_header *)
@@ -1535,7 +1543,7 @@ long int read_allocated_block(struct ext2_inode *inode, int fileblock)
 						fileblock, log2_blksz);
 		if (!ext_block) {
 			printf("invalid extent block\n");
-			free(buf);
+			mem_pool_free(&ext4_extent_pool, buf);
 			return -EINVAL;
 		}
 
@@ -1549,19 +1557,19 @@ long int read_allocated_block(struct ext2_inode *inode, int fileblock)
 		if (--i >= 0) {
 			fileblock -= le32_to_cpu(extent[i].ee_block);
 			if (fileblock >= le32_to_cpu(extent[i].ee_len)) {
-				free(buf);
+				mem_pool_free(&ext4_extent_pool, buf);
 				return 0;
 			}
 
 			start = le32_to_cpu(extent[i].ee_start_hi);
 			start = (start << 32) +
 					le32_to_cpu(extent[i].ee_start_lo);
-			free(buf);
+			mem_pool_free(&ext4_extent_pool, buf);
 			return fileblock + start;
 		}
 
 		printf("Extent Error\n");
-		free(buf);
+		mem_pool_free(&ext4_extent_pool, buf);
 		return -1;
 	}
 
@@ -996,3 +996,18 @@ fail:
 
 	return -1;
 }
+
+int ext4_write_file(const char *filename, void *buf, int offset, int len)
+{
+	if (offset != 0) {
+		printf("** Cannot support non-zero offset **\n");
+		return -1;
+	}
+
+	if (ext4fs_write(filename, buf, len)) {
+		printf("** Unable to write file %s **\n", filename);
+		return -1;
+	}
+
+	return len;
+}
@@ -1091,3 +1091,21 @@ int file_fat_write(const char *filename, void *buffer, unsigned long maxsize)
 	printf("writing %s\n", filename);
 	return do_fat_write(filename, buffer, maxsize);
 }
+
+int fat_write_file(const char *filename, void *buf, int offset, int len)
+{
+	int len_written;
+
+	if (offset != 0) {
+		printf("** Cannot support non-zero offset **\n");
+		return -1;
+	}
+
+	len_written = file_fat_write(filename, buf, len);
+	if (len_written < 0) {
+		printf("** Unable to write file %s **\n", filename);
+		return -1;
+	}
+
+	return len_written;
+}
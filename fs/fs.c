@@ -75,6 +75,11 @@ static struct fstype_info fstypes[] = {
 		.close = fat_close,
 		.ls = file_fat_ls,
 		.read = fat_read_file,
+#ifdef CONFIG_FAT_WRITE
+		.write = fat_write_file,
+#else
+		.write = fs_write_unsupported,
+#endif
 	},
 #endif
 #ifdef CONFIG_FS_EXT4
@@ -84,6 +89,11 @@ static struct fstype_info fstypes[] = {
 		.close = ext4fs_close,
 		.ls = ext4fs_ls,
 		.read = ext4_read_file,
+#ifdef CONFIG_EXT4_WRITE
+		.write = ext4_write_file,
+#else
+		.write = fs_write_unsupported,
+#endif
 	},
 #endif
 #ifdef CONFIG_SANDBOX
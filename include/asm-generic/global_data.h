@@ -37,6 +37,8 @@
  */
 
 #ifndef __ASSEMBLY__
+#include <early_cache.h>
+
 typedef struct global_data {
 	bd_t *bd;
 	unsigned long flags;
@@ -87,6 +89,15 @@ typedef struct global_data {
 	char env_buf[32];	/* buffer for getenv() before reloc. */
 #ifdef CONFIG_TRACE
 	void		*trace_buff;	/* The trace buffer */
+#endif
+#ifdef CONFIG_CONSOLE_LOG
+	void		*console_log;	/* Console log, see console_log.h */
+#endif
+#ifdef CONFIG_SYS_MALLOC_F
+	unsigned long malloc_base;	/* Base of the pre-relocation heap */
+	unsigned long malloc_limit;	/* Size of the pre-relocation heap */
+	unsigned long malloc_ptr;	/* Bytes used in pre-relocation heap */
+	void *early_cache[EARLY_CACHE_COUNT];	/* See early_cache_get() */
 #endif
 	struct arch_global_data arch;	/* architecture-specific data */
 } gd_t;
@@ -103,5 +114,7 @@ typedef struct global_data {
 #define GD_FLG_LOGINIT		0x00020	/* Log Buffer has been initialized */
 #define GD_FLG_DISABLE_CONSOLE	0x00040	/* Disable console (in & out)	   */
 #define GD_FLG_ENV_READY	0x00080	/* Env. imported into hash table   */
+/* 0x00100 and 0x00200 are used by x86 */
+#define GD_FLG_FULL_MALLOC_INIT	0x00400	/* mem_malloc_init() has been run  */
 
 #endif /* __ASM_GENERIC_GBL_DATA_H */
@@ -24,5 +24,7 @@
 #define GD_FLG_LOGINIT		0x0020	/* Log Buffer has been initialized */
 #define GD_FLG_DISABLE_CONSOLE	0x0040	/* Disable console (in & out) */
 #define GD_FLG_ENV_READY	0x0080	/* Environment imported into hash table */
+/* 0x0100 and 0x0200 are used by x86 */
+#define GD_FLG_FULL_MALLOC_INIT	0x0400	/* mem_malloc_init() has been run */
 
 #endif
@@ -31,6 +31,11 @@
 #define CONFIG_BOOTSTAGE_USER_COUNT	20
 #endif
 
+/* The number of most recent spans to keep */
+#ifndef CONFIG_BOOTSTAGE_SPAN_COUNT
+#define CONFIG_BOOTSTAGE_SPAN_COUNT	256
+#endif
+
 /* Flags for each bootstage record */
 enum bootstage_flags {
 	BOOTSTAGEF_ERROR	= 1 << 0,	/* Error record */
@@ -211,6 +216,7 @@ enum bootstage_id {
 	BOOTSTAGE_ID_ACCUM_LCD,
 	BOOTSTAGE_ID_ACCUM_SPI,
 	BOOTSTAGE_ID_ACCUM_DECOMP,
+	BOOTSTAGE_ID_ACCUM_FIT_HASH,
 
 	/* a few spare for the user, from here */
 	BOOTSTAGE_ID_USER,
@@ -423,6 +429,70 @@ static inline void bootstage_set_next_id(int id)
 
 #endif /* CONFIG_BOOTSTAGE */
 
+#if defined(CONFIG_BOOTSTAGE) && defined(CONFIG_BOOTSTAGE_SPANS) && \
+	!defined(CONFIG_SPL_BUILD) && !defined(USE_HOSTCC)
+/**
+ * Mark the start of a span
+ *
+ * A span records the time taken by an activity, which may be nested
+ * inside other spans and may happen many times. Calls to
+ * bootstage_span_begin() and bootstage_span_end() must be properly nested.
+ * Spans are only recorded after relocation.
+ *
+ * @param name	Name of the span, which must remain valid (e.g. a string
+ *		constant)
+ * @return span handle to pass to bootstage_span_end(), or -1 if the span
+ *		is not being recorded
+ */
+int bootstage_span_begin(const char *name);
+
+/**
+ * Add optional information to a span
+ *
+ * @param span		Span handle from bootstage_span_begin()
+ * @param device	Name of device involved (must remain valid), or NULL
+ * @param bytes		Number of bytes processed, or 0 if not relevant
+ */
+void bootstage_span_args(int span, const char *device, ulong bytes);
+
+/**
+ * Mark the end of a span
+ *
+ * @param span	Span handle from bootstage_span_begin()
+ * @return time taken by the span in microseconds
+ */
+uint32_t bootstage_span_end(int span);
+
+/* Print a list of recorded spans */
+void bootstage_span_report(void);
+
+/**
+ * Export spans and marks in Chrome trace-event JSON format
+ *
+ * The output can be loaded into chrome://tracing or Perfetto.
+ *
+ * @param buf	Buffer to write to
+ * @param size	Size of buffer in bytes
+ * @return length of the output in bytes, or -ENOSPC if it does not fit
+ */
+int bootstage_export_json(char *buf, int size);
+#else
+static inline int bootstage_span_begin(const char *name)
+{
+	return -1;
+}
+
+static inline void bootstage_span_args(int span, const char *device,
+				       ulong bytes)
+{
+}
+
+static inline uint32_t bootstage_span_end(int span)
+{
+	return 0;
+}
+#endif /* CONFIG_BOOTSTAGE_SPANS */
+
 /* Helper macro for adding a bootstage to a line of code */
 #define BOOTSTAGE_MARKER()	\
 		bootstage_mark_code(__FILE__, __func__, __LINE__)
@@ -52,6 +52,24 @@
  * used directly) upon stop() call.
  */
 #define GEN_BB_RW	(GEN_BB_READ | GEN_BB_WRITE)
+/*
+ * GEN_BB_SPLIT -- The hardware can transfer to/from a list of segments (e.g.
+ * it has scatter-gather DMA) and does not care about address alignment
+ * beyond what the caller already provides. For an unaligned buffer only the
+ * partial cache lines at each end are bounced and the middle of the buffer
+ * is used in place, avoiding a copy of the whole buffer. The caller must
+ * transfer each of the segments in .seg[] in order. Small buffers may still
+ * be bounced in full, using a single segment.
+ */
+#define GEN_BB_SPLIT	(1 << 2)
+
+/* Maximum number of segments in a bounce buffer session */
+#define GEN_BB_MAX_SEGS	3
+
+struct bounce_segment {
+	void *addr;		/* Address to use for DMA */
+	size_t len;		/* Length of segment in bytes */
+};
 
 struct bounce_buffer {
 	/* Copy of data parameter passed to start() */
@@ -68,6 +86,14 @@ struct bounce_buffer {
 	size_t len_aligned;
 	/* Copy of flags parameter passed to start() */
 	unsigned int flags;
+	/*
+	 * Segments to use for DMA. Without GEN_BB_SPLIT there is one segment
+	 * which is the same as .bounce_buffer.
+	 */
+	struct bounce_segment seg[GEN_BB_MAX_SEGS];
+	int num_segs;
+	/* Buffer holding the ends of the data when split, else NULL */
+	void *edge_buffer;
 };
 
 /**
@@ -85,6 +85,17 @@ int _do_help (cmd_tbl_t *cmd_start, int cmd_items, cmd_tbl_t * cmdtp, int
 cmd_tbl_t *find_cmd(const char *cmd);
 cmd_tbl_t *find_cmd_tbl (const char *cmd, cmd_tbl_t *table, int table_len);
 
+/**
+ * cmd_hash_build() - Build a hash index of the command table
+ *
+ * After this, find_cmd() looks up full command names in the index instead
+ * of comparing against every command. It needs malloc(), so call it after
+ * relocation.
+ *
+ * @return 0 if OK, -1 if out of memory
+ */
+int cmd_hash_build(void);
+
 extern int cmd_usage(const cmd_tbl_t *cmdtp);
 
 #ifdef CONFIG_AUTO_COMPLETE
@@ -54,6 +54,16 @@
 #define HAVE_BLOCK_DEVICE
 #endif
 
+/* The pre-relocation heap is set up by the generic board_init_f() */
+#if defined(CONFIG_SYS_MALLOC_F) && \
+	(defined(CONFIG_SPL_BUILD) || defined(CONFIG_X86))
+#undef CONFIG_SYS_MALLOC_F
+#endif
+
+#if defined(CONFIG_SYS_MALLOC_F) && !defined(CONFIG_SYS_MALLOC_F_LEN)
+#define CONFIG_SYS_MALLOC_F_LEN	0x400
+#endif
+
 #ifndef CONFIG_CMDLINE
 /* Do all linking at the end to minimize image size */
 #define CONFIG_FINAL_LINK
@@ -74,6 +74,9 @@
 #define LCD_BPP LCD_COLOR16
 #define CONFIG_SYS_WHITE_ON_BLACK
 
+/* Keep vboot screen images in panel format to speed up redraws */
+#define CONFIG_CHROMEOS_DISPLAY_CACHE
+
 #define CONFIG_SYS_PROMPT	"SMDK5250 # "
 
 /*
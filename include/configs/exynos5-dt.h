@@ -34,6 +34,8 @@
 
 #define CONFIG_SYS_THUMB_BUILD
 #define CONFIG_SYS_GENERIC_BOARD
+#define CONFIG_SYS_MALLOC_F
+#define CONFIG_SYS_MALLOC_F_LEN		0x400
 #define CONFIG_ARCH_CPU_INIT
 #define CONFIG_DISPLAY_CPUINFO
 #define CONFIG_DISPLAY_BOARDINFO
@@ -127,6 +129,7 @@
 #define CONFIG_S5P_SDHCI
 #define CONFIG_DWMMC
 #define CONFIG_EXYNOS_DWMMC
+#define CONFIG_BOUNCE_BUFFER
 #define CONFIG_SUPPORT_EMMC_BOOT
 
 
@@ -259,6 +262,7 @@
 
 #define CONFIG_DOS_PARTITION
 #define CONFIG_EFI_PARTITION
+#define CONFIG_EFI_PARTITION_CACHE
 #define CONFIG_CMD_PART
 #define CONFIG_PARTITION_UUIDS
 
@@ -395,6 +399,7 @@
 #define LCD_YRES			1600
 #define LCD_BPP			LCD_COLOR16
 #define CONFIG_CMD_BMP
+#define CONFIG_LCD_HW_SCROLL
 #endif
 
 /* Enable Time Command */
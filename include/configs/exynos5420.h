@@ -51,4 +51,8 @@
 /* Multiple USB controller support */
 #define CONFIG_USB_MAX_CONTROLLER_COUNT		2
 
+/* Use the other A15 cores to hash FIT sub-images in parallel */
+#define CONFIG_CPU_WORK
+#define CONFIG_FIT_PARALLEL_HASH
+
 #endif
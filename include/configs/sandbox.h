@@ -29,11 +29,20 @@
 #define CONFIG_TRACE_EARLY_SIZE		(8 << 20)
 #define CONFIG_TRACE_EARLY
 #define CONFIG_TRACE_EARLY_ADDR		0x00100000
+#define CONFIG_TRACE_STATS
+#define CONFIG_TRACE_COMPACT
+#define CONFIG_TRACE_DRAIN
+#define CONFIG_TRACE_DEPTH_LIMIT	200
 
 #endif
 
 #define CONFIG_BOOTSTAGE
 #define CONFIG_BOOTSTAGE_REPORT
+#define CONFIG_BOOTSTAGE_SPANS
+#define CONFIG_CMD_BOOTSTAGE
+#define CONFIG_CMD_PROFILE
+#define CONFIG_CMD_MALLOC
+#define CONFIG_CONSOLE_LOG
 
 /* Number of bits in a C 'long' on this architecture */
 #define CONFIG_SANDBOX_BITS_PER_LONG	64
@@ -43,9 +52,12 @@
 #define CONFIG_OF_LIBFDT
 #define CONFIG_LMB
 #define CONFIG_FIT
+#define CONFIG_CPU_WORK
+#define CONFIG_FIT_PARALLEL_HASH
 #define CONFIG_CMD_FDT
 #define CONFIG_DEFAULT_DEVICE_TREE	sandbox
 #define CONFIG_TEST_FDTDEC
+#define CONFIG_FDTDEC_INDEX
 
 #define CONFIG_FS_FAT
 #define CONFIG_FS_EXT4
@@ -57,6 +69,7 @@
 #define CONFIG_DOS_PARTITION
 #define CONFIG_PARTITION_UUIDS
 #define CONFIG_EFI_PARTITION
+#define CONFIG_EFI_PARTITION_CACHE
 #define CONFIG_HOST_MAX_DEVICES 4
 
 #define CONFIG_SYS_VSNPRINTF
@@ -70,9 +83,13 @@
  * Size of malloc() pool, although we don't actually use this yet.
  */
 #define CONFIG_SYS_MALLOC_LEN		(32 << 20)	/* 32MB  */
+#define CONFIG_SYS_MALLOC_F
+#define CONFIG_SYS_MALLOC_F_LEN		0x400
 
 #define CONFIG_SYS_PROMPT		"=>"	/* Command Prompt */
 #define CONFIG_SYS_HUSH_PARSER
+#define CONFIG_HUSH_PARSE_CACHE
+#define CONFIG_SYS_CMD_LOOKUP_HASH
 #define CONFIG_SYS_LONGHELP			/* #undef to save memory */
 #define CONFIG_SYS_CBSIZE		1024	/* Console I/O Buffer Size */
 
@@ -98,6 +115,22 @@
 #define CONFIG_SPI_FLASH_STMICRO
 #define CONFIG_SPI_FLASH_WINBOND
 
+/* NAND, emulated using the file given with --nand */
+#define CONFIG_CMD_NAND
+#define CONFIG_NAND_SANDBOX
+#define CONFIG_SYS_MAX_NAND_DEVICE	1
+#define CONFIG_SYS_NAND_BASE		0
+
+/* UBI, using the whole NAND */
+#define CONFIG_CMD_MTDPARTS
+#define CONFIG_MTD_DEVICE
+#define CONFIG_MTD_PARTITIONS
+#define MTDIDS_DEFAULT			"nand0=nand0"
+#define MTDPARTS_DEFAULT		"mtdparts=nand0:-(ubi)"
+#define CONFIG_CMD_UBI
+#define CONFIG_RBTREE
+#define CONFIG_MTD_UBI_FASTMAP
+
 #define CONFIG_SYS_HZ			1000
 
 /* Memory things - we don't really want a memory test */
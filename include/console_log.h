@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2013 The Chromium OS Authors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#ifndef __CONSOLE_LOG_H
+#define __CONSOLE_LOG_H
+
+#include <lmb.h>
+
+#ifndef CONFIG_CONSOLE_LOG_SIZE
+#define CONFIG_CONSOLE_LOG_SIZE		(64 << 10)
+#endif
+
+#define CONSOLE_LOG_MAGIC	0x474f4c55	/* "ULOG" */
+
+enum {
+	CONSOLE_LOG_WRAPPED	= 1 << 0,	/* Older text was overwritten */
+	CONSOLE_LOG_IN_LINE	= 1 << 1,	/* Line started, stamp written */
+};
+
+/*
+ * The console log starts with this header, followed by 'size' bytes of
+ * text. The text is a ring: the next character goes at offset 'next', so
+ * if CONSOLE_LOG_WRAPPED is set the oldest text starts there, otherwise
+ * it starts at 0. Each line starts with "[seconds.microseconds] ".
+ *
+ * U-Boot is the only writer and the OS only reads the log once U-Boot has
+ * finished, so no locking is needed. All fields are in CPU byte order.
+ */
+struct console_log_hdr {
+	u32 magic;	/* CONSOLE_LOG_MAGIC */
+	u32 size;	/* Size of the text area in bytes */
+	u32 next;	/* Offset of the next character in the text area */
+	u32 flags;	/* CONSOLE_LOG_... */
+};
+
+#if defined(CONFIG_CONSOLE_LOG) && !defined(CONFIG_SPL_BUILD)
+/**
+ * console_log_init() - Start recording console output in a buffer
+ *
+ * The header is reset, so the log starts empty and anything recorded by a
+ * previous boot is no longer part of it. The text area is not cleared.
+ *
+ * @buf:	Buffer to use, including room for the header
+ * @size:	Size of buffer in bytes
+ * @return 0 if OK, -EINVAL if the buffer is too small
+ */
+int console_log_init(void *buf, ulong size);
+
+/**
+ * console_log_putc() - Record a character written to the console
+ *
+ * This does nothing until console_log_init() is called.
+ *
+ * @c:		Character to record
+ */
+void console_log_putc(const char c);
+
+/**
+ * console_log_puts() - Record a string written to the console
+ *
+ * @s:		String to record
+ */
+void console_log_puts(const char *s);
+
+/**
+ * console_log_fdt_setup() - Pass the console log to the OS
+ *
+ * This reserves the log in @lmb and in the device tree's memory reserve
+ * map, so that neither U-Boot nor the OS will overwrite it. It then adds
+ * a /chosen/u-boot-console-log node, with compatible "u-boot,console-log"
+ * and a 'reg' property holding the address and size of the log, using the
+ * root node's #address-cells and #size-cells.
+ *
+ * @blob:	Device tree to update
+ * @lmb:	Memory regions which U-Boot is using for the boot
+ * @return 0 if OK (or there is no log), -ve FDT error on failure (e.g.
+ *	-FDT_ERR_NOSPACE if the log is above 4GB and the tree uses one cell)
+ */
+int console_log_fdt_setup(void *blob, struct lmb *lmb);
+#else
+static inline void console_log_putc(const char c)
+{
+}
+
+static inline void console_log_puts(const char *s)
+{
+}
+
+static inline int console_log_fdt_setup(void *blob, struct lmb *lmb)
+{
+	return 0;
+}
+#endif
+
+#endif
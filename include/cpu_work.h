@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2013 The Chromium OS Authors.
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#ifndef _CPU_WORK_H
+#define _CPU_WORK_H
+
+/*
+ * Simple work dispatcher for secondary CPUs.
+ *
+ * Secondary CPUs are brought up by the architecture code and then sit in a
+ * parked loop waiting for work. The boot CPU posts work items, which are
+ * picked up by an idle secondary CPU. If no secondary CPU is idle (or none
+ * exist, as on sandbox) the work item is run on the boot CPU instead, so
+ * callers never need to care how many CPUs are available.
+ *
+ * Work functions run without console, timer or driver access: they must
+ * only touch memory. Anything else is not safe from a secondary CPU.
+ */
+
+#ifndef CONFIG_CPU_WORK_MAX_CPUS
+#define CONFIG_CPU_WORK_MAX_CPUS	8
+#endif
+
+/* Size of the stack given to each secondary CPU */
+#ifndef CONFIG_CPU_WORK_STACK_SIZE
+#define CONFIG_CPU_WORK_STACK_SIZE	(8 << 10)
+#endif
+
+/**
+ * struct cpu_work - a single item of work
+ *
+ * @func:	Function to call; its return value is placed in @ret
+ * @arg:	Argument to pass to @func
+ * @ret:	Return value of @func, valid once @done is set
+ * @done:	Set to 1 when the work item has completed
+ */
+struct cpu_work {
+	int (*func)(void *arg);
+	void *arg;
+	int ret;
+	volatile int done;
+};
+
+/**
+ * cpu_work_init() - Bring up secondary CPUs ready for work
+ *
+ * This may be called more than once; only the first call does anything. It
+ * is called automatically by cpu_work_post() if needed.
+ *
+ * @return number of CPUs available for work, including the boot CPU
+ */
+int cpu_work_init(void);
+
+/**
+ * cpu_work_shutdown() - Park secondary CPUs ready for the OS
+ *
+ * Stops all secondary CPUs and returns them to the state the OS expects to
+ * find them in. Any work in progress is completed first.
+ */
+void cpu_work_shutdown(void);
+
+/**
+ * cpu_work_post() - Post a work item
+ *
+ * The work item is handed to an idle secondary CPU. If there is none, it is
+ * run immediately on the calling CPU, so this function may take as long as
+ * the work item itself.
+ *
+ * @work:	Work item to run; must remain valid until cpu_work_wait()
+ *		returns
+ */
+void cpu_work_post(struct cpu_work *work);
+
+/**
+ * cpu_work_wait() - Wait for a work item to complete
+ *
+ * @work:	Work item previously passed to cpu_work_post()
+ * @return return value of the work function
+ */
+int cpu_work_wait(struct cpu_work *work);
+
+/**
+ * cpu_work_run() - Run a number of work items in parallel
+ *
+ * Posts all work items and waits for them all to complete.
+ *
+ * @work:	Array of work items
+ * @count:	Number of work items
+ * @return 0 if all work functions returned 0, else the first non-zero
+ * return value
+ */
+int cpu_work_run(struct cpu_work *work, int count);
+
+/**
+ * cpu_work_secondary_loop() - Parked loop for a secondary CPU
+ *
+ * This is called by the architecture code on a secondary CPU once it has
+ * a stack and its caches are coherent with the boot CPU. It never returns.
+ *
+ * @cpu:	CPU number (1 to cpu_work_arch_num_cpus() - 1)
+ */
+void cpu_work_secondary_loop(int cpu) __attribute__((noreturn));
+
+/*
+ * Architecture hooks. Weak defaults are provided which give a single CPU
+ * system, so that all work is run on the boot CPU.
+ */
+
+/**
+ * cpu_work_arch_num_cpus() - Get the number of CPUs which can run work
+ *
+ * @return number of CPUs, including the boot CPU (which is CPU 0)
+ */
+int cpu_work_arch_num_cpus(void);
+
+/**
+ * cpu_work_arch_start() - Start a secondary CPU
+ *
+ * The CPU should end up calling cpu_work_secondary_loop() with @cpu.
+ *
+ * @cpu:	CPU number to start
+ * @return 0 if OK, -ve on error
+ */
+int cpu_work_arch_start(int cpu);
+
+/**
+ * cpu_work_arch_stop() - Stop the calling secondary CPU
+ *
+ * This is called on a secondary CPU when cpu_work_shutdown() is called. It
+ * should flush the CPU's caches and power it down. It does not return.
+ *
+ * @cpu:	CPU number being stopped
+ */
+void cpu_work_arch_stop(int cpu);
+
+/**
+ * cpu_work_arch_stopped() - Check whether a secondary CPU has stopped
+ *
+ * @cpu:	CPU number to check
+ * @return 1 if the CPU is powered down, 0 if not
+ */
+int cpu_work_arch_stopped(int cpu);
+
+/**
+ * cpu_work_arch_notify() - Make memory writes visible and wake other CPUs
+ */
+void cpu_work_arch_notify(void);
+
+/**
+ * cpu_work_arch_wait() - Wait for a notification from another CPU
+ *
+ * This may return early, so callers must re-check their condition.
+ */
+void cpu_work_arch_wait(void);
+
+#endif /* _CPU_WORK_H */
@@ -109,6 +109,11 @@ struct dfu_entity {
 	u32 bad_skip;	/* for nand use */
 
 	unsigned int inited:1;
+	/*
+	 * Pass each chunk to write_medium() as it arrives, instead of
+	 * collecting it in a buffer first
+	 */
+	unsigned int stream:1;
 };
 
 int dfu_config_entities(char *s, char *interface, int num);
@@ -130,10 +130,23 @@
 #define RX_WMARK_MASK		(0xfff << RX_WMARK_SHIFT)
 
 #define DWMCI_IDMAC_OWN		(1 << 31)
+#define DWMCI_IDMAC_ER		(1 << 5)
 #define DWMCI_IDMAC_CH		(1 << 4)
 #define DWMCI_IDMAC_FS		(1 << 3)
 #define DWMCI_IDMAC_LD		(1 << 2)
 
+/* IDMAC descriptor buffer sizes, each a 13-bit field */
+#define DWMCI_IDMAC_BS1(x)	(x)
+#define DWMCI_IDMAC_BS2(x)	((x) << 13)
+
+/* Largest multiple of the block size which fits in a buffer size field */
+#define DWMCI_IDMAC_MAX_BUF	0x1e00
+
+/* Number of descriptors in each host's IDMAC descriptor ring */
+#ifndef CONFIG_DWMMC_IDMAC_DESC
+#define CONFIG_DWMMC_IDMAC_DESC	256
+#endif
+
 /*  Bus Mode Register */
 #define DWMCI_BMOD_IDMAC_RESET	(1 << 0)
 #define DWMCI_BMOD_IDMAC_FB	(1 << 1)
@@ -161,6 +174,7 @@ struct dwmci_host {
 	u32 clksel_val;
 	u32 fifoth_val;
 	struct mmc *mmc;
+	struct dwmci_idmac *idmac;	/* IDMAC descriptor ring */
 
 	void (*clksel)(struct dwmci_host *host);
 	unsigned int (*mmc_clk)(struct dwmci_host *host);
@@ -170,7 +184,7 @@ struct dwmci_idmac {
 	u32 flags;
 	u32 cnt;
 	u32 addr;
-	u32 next_addr;
+	u32 addr2;	/* Second buffer, since we use dual-buffer mode */
 };
 
 static inline void dwmci_writel(struct dwmci_host *host, int reg, u32 val)
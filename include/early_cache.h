@@ -0,0 +1,33 @@
+/*
+ * Copyright (c) 2013 The Chromium OS Authors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#ifndef __EARLY_CACHE_H
+#define __EARLY_CACHE_H
+
+/*
+ * Slots for data decoded before relocation which is handed over to the
+ * post-relocation code, so that it need not be decoded again
+ */
+enum early_cache_id {
+	EARLY_CACHE_BOARD_REV,		/* Board revision and sub-revision */
+
+	EARLY_CACHE_COUNT,
+};
+
+#endif
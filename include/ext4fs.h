@@ -126,6 +126,7 @@ void ext4fs_deinit(void);
 int ext4fs_filename_check(char *filename);
 int ext4fs_write(const char *fname, unsigned char *buffer,
 				unsigned long sizebytes);
+int ext4_write_file(const char *filename, void *buf, int offset, int len);
 #endif
 
 struct ext_filesystem *get_fs(void);
@@ -66,6 +66,21 @@ void do_fixup_by_compat_u32(void *fdt, const char *compat,
 			    const char *prop, u32 val, int create);
 int fdt_fixup_memory(void *blob, u64 start, u64 size);
 int fdt_fixup_memory_banks(void *blob, u64 start[], u64 size[], int banks);
+
+/**
+ * fdt_pack_reg() - Encode an address and size as a 'reg' property value
+ *
+ * This uses the root node's #address-cells and #size-cells, so suits a
+ * node whose parent does not set them, such as /chosen.
+ *
+ * @blob:	Device tree
+ * @buf:	Buffer to write to, which must hold 16 bytes
+ * @address:	Address to encode
+ * @size:	Size to encode
+ * @return number of bytes written, or -FDT_ERR_NOSPACE if a value does not
+ *	fit in the number of cells
+ */
+int fdt_pack_reg(void *blob, u8 *buf, u64 address, u64 size);
 void fdt_fixup_ethernet(void *fdt);
 int fdt_find_and_setprop(void *fdt, const char *node, const char *prop,
 			 const void *val, int len, int create);
@@ -324,6 +324,36 @@ int fdtdec_prepare_fdt(void);
  */
 int fdtdec_check_fdt(void);
 
+/**
+ * Build an index to speed up lookups in a device tree.
+ *
+ * The index maps each compatible ID to the nodes which have it, each
+ * phandle to its node and each alias to its node. Once built, it is used
+ * automatically by fdtdec_lookup(), fdtdec_next_compatible(),
+ * fdtdec_next_alias(), fdtdec_lookup_phandle() and the functions which
+ * use them, whenever they are passed the same blob. Other blobs are
+ * searched in the normal way.
+ *
+ * Only one index is kept; building a new one frees the old one. If the
+ * blob's total size or structure size changes, e.g. because a node or
+ * property was added, the index is ignored until it is built again.
+ * Changes which keep both sizes the same are not detected.
+ *
+ * This needs malloc(), so is called after relocation for the control FDT.
+ *
+ * @param blob		FDT blob to index
+ * @return 0 if ok, -FDT_ERR_BADMAGIC if there is no valid blob,
+ *	-FDT_ERR_NOSPACE if out of memory
+ */
+int fdtdec_index_build(const void *blob);
+
+/**
+ * Free the device tree index, if any.
+ *
+ * Lookups will then search the blob each time.
+ */
+void fdtdec_index_free(void);
+
 /**
  * Find the nodes for a peripheral and return a list of them in the correct
  * order. This is used to enumerate all the peripherals of a certain type.
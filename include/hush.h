@@ -32,6 +32,27 @@ extern int u_boot_hush_start(void);
 extern int parse_string_outer(const char *, int);
 extern int parse_file_outer(void);
 
+/**
+ * parse_var_outer() - Run a script held in an environment variable
+ *
+ * With CONFIG_HUSH_PARSE_CACHE the parsed script is kept, so running the
+ * same variable again does not need to parse it again, as long as its
+ * value has not changed.
+ *
+ * @name:	Variable name
+ * @s:		Value of the variable
+ * @flag:	Parser flags (FLAG_...)
+ * @return 0 on success, 1 on error
+ */
+#ifdef CONFIG_HUSH_PARSE_CACHE
+int parse_var_outer(const char *name, const char *s, int flag);
+#else
+static inline int parse_var_outer(const char *name, const char *s, int flag)
+{
+	return parse_string_outer(s, flag);
+}
+#endif
+
 int set_local_var(const char *s, int flg_export);
 void unset_local_var(const char *name);
 char *get_local_var(const char *s);
@@ -58,6 +58,33 @@ int bmp_display(ulong addr, int x, int y);
  */
 void lcd_set_flush_dcache(int flush);
 
+/**
+ * Mark part of the LCD image as changed, so that it will be flushed from the
+ * dcache on the next lcd_sync(). The area is clipped to the panel.
+ *
+ * @param x		X position of area in pixels
+ * @param y		Y position of area in pixels
+ * @param width		Width of area in pixels
+ * @param height	Height of area in pixels
+ */
+void lcd_mark_dirty(int x, int y, int width, int height);
+
+/**
+ * Flush any changed parts of the LCD image from the dcache, if needed.
+ */
+void lcd_sync(void);
+
+/**
+ * Set the offset of the visible screen within the framebuffer, used for
+ * hardware scrolling with CONFIG_LCD_HW_SCROLL. Drivers which can pan the
+ * display should implement this. The change should take effect at the next
+ * frame and must not show a mixture of the old and new positions.
+ *
+ * @param offset	Offset in bytes from the start of the framebuffer
+ * @return 0 if OK, -1 if panning is not supported
+ */
+int lcd_set_display_offset(ulong offset);
+
 #if defined CONFIG_MPC823
 /*
  * LCD controller stucture for MPC823 CPU
@@ -320,12 +347,43 @@ int lcd_get_screen_columns(void);
  */
 void lcd_position_cursor(unsigned col, unsigned row);
 
+/**
+ * Copy a rectangle of pixels from the LCD into a buffer, in the panel's
+ * pixel format. The rectangle must lie within the panel.
+ *
+ * @param x		X position of rectangle in pixels
+ * @param y		Y position of rectangle in pixels
+ * @param width		Width of rectangle in pixels
+ * @param height	Height of rectangle in pixels
+ * @param buf		Buffer to hold width * height pixels
+ */
+void lcd_read_rect(int x, int y, int width, int height, void *buf);
+
+/**
+ * Copy a rectangle of pixels from a buffer to the LCD. This is much faster
+ * than lcd_display_bitmap() since no conversion is needed. The rectangle
+ * must lie within the panel.
+ *
+ * @param x		X position of rectangle in pixels
+ * @param y		Y position of rectangle in pixels
+ * @param width		Width of rectangle in pixels
+ * @param height	Height of rectangle in pixels
+ * @param buf		Pixels in panel format, as from lcd_read_rect()
+ */
+void lcd_write_rect(int x, int y, int width, int height, const void *buf);
+
 /* Allow boards to customize the information displayed */
 void lcd_show_board_info(void);
 
 /* Return the size of the LCD frame buffer, and the line length */
 int lcd_get_size(int *line_length);
 
+/*
+ * Return the size of memory which lcd_setmem() reserves for the frame
+ * buffer, including any extra screens for hardware scrolling
+ */
+ulong lcd_get_reserved_size(void);
+
 /************************************************************************/
 /* ** BITMAP DISPLAY SUPPORT						*/
 /************************************************************************/
@@ -347,6 +405,7 @@ int lcd_get_size(int *line_length);
 #define LCD_COLOR4	2
 #define LCD_COLOR8	3
 #define LCD_COLOR16	4
+#define LCD_COLOR32	5
 
 /*----------------------------------------------------------------------*/
 #if defined(CONFIG_LCD_INFO_BELOW_LOGO)
@@ -398,6 +457,14 @@ int lcd_get_size(int *line_length);
 # define CONSOLE_COLOR_GREY	14
 # define CONSOLE_COLOR_WHITE	15	/* Must remain last / highest	*/
 
+#elif LCD_BPP == LCD_COLOR32
+
+/*
+ * 32bpp color definitions
+ */
+# define CONSOLE_COLOR_BLACK	0x00000000
+# define CONSOLE_COLOR_WHITE	0xffffffff	/* Must remain last / highest */
+
 #else
 
 /*
@@ -599,7 +599,7 @@ struct mallinfo {
   int smblks;   /* unused -- always zero */
   int hblks;    /* number of mmapped regions */
   int hblkhd;   /* total space in mmapped regions */
-  int usmblks;  /* unused -- always zero */
+  int usmblks;  /* maximum total space obtained (peak heap) */
   int fsmblks;  /* unused -- always zero */
   int uordblks; /* total allocated space */
   int fordblks; /* total non-inuse space */
@@ -938,6 +938,66 @@ extern unsigned long mem_malloc_brk;
 
 void mem_malloc_init(unsigned long start, unsigned long size);
 
+#ifdef CONFIG_SYS_MALLOC_F
+#include <early_cache.h>
+
+/*
+ * Simple allocator used before relocation, when malloc() is not yet set
+ * up. Memory comes from a small region carved out by board_init_f() and
+ * cannot be freed. It remains valid after relocation, so it can be used
+ * to hand decoded state over to the post-relocation code.
+ *
+ * malloc(), calloc() and memalign() use this automatically until
+ * mem_malloc_init() is called, and free() ignores memory from here.
+ */
+
+/**
+ * malloc_simple() - Allocate memory from the pre-relocation heap
+ *
+ * @size:	Number of bytes required
+ * @return pointer to memory, or NULL if there is not enough space
+ */
+void *malloc_simple(size_t size);
+
+/**
+ * memalign_simple() - Allocate aligned memory from the pre-relocation heap
+ *
+ * @align:	Alignment required (must be a power of 2)
+ * @size:	Number of bytes required
+ * @return pointer to memory, or NULL if there is not enough space
+ */
+void *memalign_simple(size_t align, size_t size);
+
+/**
+ * malloc_simple_owns() - Check if memory came from the pre-relocation heap
+ *
+ * @ptr:	Pointer to check
+ * @return 1 if @ptr is in the pre-relocation heap, 0 if not
+ */
+int malloc_simple_owns(const void *ptr);
+
+/**
+ * early_cache_get() - Find data cached by early_cache_alloc()
+ *
+ * @id:		Cache slot to look up
+ * @return pointer to the cached data, or NULL if none
+ */
+void *early_cache_get(enum early_cache_id id);
+
+/**
+ * early_cache_alloc() - Allocate space for cached data
+ *
+ * This allocates memory with malloc() and records it in the given slot so
+ * that early_cache_get() will find it, both before and after relocation.
+ * Before relocation the memory comes from the pre-relocation heap.
+ *
+ * @id:		Cache slot to use
+ * @size:	Number of bytes required
+ * @return pointer to memory, or NULL if out of memory
+ */
+void *early_cache_alloc(enum early_cache_id id, size_t size);
+#endif
+
 #ifdef __cplusplus
 };  /* end of extern "C" */
 #endif
@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2013 The Chromium OS Authors.
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#ifndef _MEMPOOL_H
+#define _MEMPOOL_H
+
+/*
+ * Arena and pool allocators layered on top of malloc().
+ *
+ * An arena hands out memory by bumping a pointer and frees it all at once
+ * with arena_reset(). This suits code which makes many allocations during
+ * a single operation (such as decompression or a USB transfer) and then
+ * throws them all away.
+ *
+ * A pool hands out objects of a single size from slabs, keeping freed
+ * objects on a free list for reuse. This suits code which allocates and
+ * frees the same kind of object over and over.
+ *
+ * Both take their memory from malloc() on first use and keep it, so that
+ * the heap sees a few large allocations instead of many small ones. Each
+ * arena and pool registers itself when first used so that its statistics
+ * can be shown by the 'malloc stats' command.
+ */
+
+struct arena_chunk;
+
+/**
+ * struct arena - a bump allocator
+ *
+ * Use ARENA_INIT() to set one up; all other fields start at zero.
+ *
+ * @name:	Name shown in statistics
+ * @chunk_size:	Size of each chunk obtained from malloc()
+ * @chunk:	List of chunks, most recent first
+ * @used:	Bytes allocated since the last reset
+ * @peak:	Largest value of @used seen
+ * @allocs:	Total number of allocations made
+ * @resets:	Number of times the arena has been reset
+ * @chunk_count: Number of chunks currently held
+ * @next:	Next arena in the list of registered arenas
+ * @registered:	1 if this arena is in the list
+ */
+struct arena {
+	const char *name;
+	size_t chunk_size;
+	struct arena_chunk *chunk;
+	size_t used;
+	size_t peak;
+	ulong allocs;
+	ulong resets;
+	int chunk_count;
+	struct arena *next;
+	int registered;
+};
+
+#define ARENA_INIT(_name, _chunk_size) {		\
+	.name = _name,					\
+	.chunk_size = _chunk_size,			\
+}
+
+/**
+ * arena_memalign() - Allocate aligned memory from an arena
+ *
+ * The size is rounded up to a multiple of @align, so that the whole
+ * allocation can be flushed or invalidated from the cache without touching
+ * anything else.
+ *
+ * @arena:	Arena to allocate from
+ * @align:	Alignment required (must be a power of 2)
+ * @size:	Number of bytes required
+ * @return pointer to memory, or NULL if out of memory
+ */
+void *arena_memalign(struct arena *arena, size_t align, size_t size);
+
+/**
+ * arena_alloc() - Allocate memory from an arena
+ *
+ * The memory is aligned in the same way as malloc().
+ *
+ * @arena:	Arena to allocate from
+ * @size:	Number of bytes required
+ * @return pointer to memory, or NULL if out of memory
+ */
+void *arena_alloc(struct arena *arena, size_t size);
+
+/**
+ * arena_reset() - Free all allocations in an arena
+ *
+ * The first chunk is kept for next time. If more than one chunk was needed
+ * the chunks are freed and the chunk size grown so that a single chunk will
+ * be enough for the same workload.
+ *
+ * @arena:	Arena to reset
+ */
+void arena_reset(struct arena *arena);
+
+/**
+ * arena_destroy() - Free all memory held by an arena
+ *
+ * @arena:	Arena to destroy; it may be used again afterwards
+ */
+void arena_destroy(struct arena *arena);
+
+struct mem_pool_slab;
+
+/**
+ * struct mem_pool - a pool of fixed-size objects
+ *
+ * Use MEM_POOL_INIT() to set one up; all other fields start at zero.
+ *
+ * @name:	Name shown in statistics
+ * @obj_size:	Size of each object in bytes
+ * @per_slab:	Number of objects in each slab
+ * @free_list:	List of free objects
+ * @slab:	List of slabs
+ * @in_use:	Number of objects currently allocated
+ * @peak:	Largest value of @in_use seen
+ * @allocs:	Total number of allocations made
+ * @slab_count:	Number of slabs held
+ * @next:	Next pool in the list of registered pools
+ * @registered:	1 if this pool is in the list
+ */
+struct mem_pool {
+	const char *name;
+	size_t obj_size;
+	int per_slab;
+	void *free_list;
+	struct mem_pool_slab *slab;
+	int in_use;
+	int peak;
+	ulong allocs;
+	int slab_count;
+	struct mem_pool *next;
+	int registered;
+};
+
+#define MEM_POOL_INIT(_name, _obj_size, _per_slab) {	\
+	.name = _name,					\
+	.obj_size = _obj_size,				\
+	.per_slab = _per_slab,				\
+}
+
+/**
+ * mem_pool_alloc() - Allocate an object from a pool
+ *
+ * The object's contents are undefined.
+ *
+ * @pool:	Pool to allocate from
+ * @return pointer to object, or NULL if out of memory
+ */
+void *mem_pool_alloc(struct mem_pool *pool);
+
+/**
+ * mem_pool_free() - Return an object to a pool
+ *
+ * @pool:	Pool the object came from
+ * @ptr:	Object to free (NULL is ignored)
+ */
+void mem_pool_free(struct mem_pool *pool, void *ptr);
+
+/**
+ * mem_pool_set_size() - Change the object size of a pool
+ *
+ * This is for pools whose object size is not known until run time, such
+ * as a filesystem block. Any slabs are freed if the size changes.
+ *
+ * @pool:	Pool to change
+ * @obj_size:	New object size in bytes
+ * @return 0 if OK, -EBUSY if objects are still allocated
+ */
+int mem_pool_set_size(struct mem_pool *pool, size_t obj_size);
+
+/**
+ * mem_pool_destroy() - Free all memory held by a pool
+ *
+ * All objects must have been freed first.
+ *
+ * @pool:	Pool to destroy; it may be used again afterwards
+ */
+void mem_pool_destroy(struct mem_pool *pool);
+
+/**
+ * arena_print_stats() - Print statistics for all arenas
+ */
+void arena_print_stats(void);
+
+/**
+ * mem_pool_print_stats() - Print statistics for all pools
+ */
+void mem_pool_print_stats(void);
+
+#endif
@@ -173,6 +173,21 @@ typedef struct NS16550 *NS16550_t;
 
 void NS16550_init(NS16550_t com_port, int baud_divisor);
 void NS16550_putc(NS16550_t com_port, char c);
+
+/**
+ * NS16550_write() - Write characters, a FIFO's worth at a time
+ *
+ * Each time the transmit FIFO is empty, this writes up to
+ * CONFIG_SYS_NS16550_FIFO_SIZE characters to it, rather than polling the
+ * line status before every character. No newline translation is done.
+ *
+ * @com_port:	UART to write to
+ * @s:		Characters to write
+ * @len:	Number of characters to write
+ * @nowait:	Return as soon as the FIFO is not empty, instead of waiting
+ * @return number of characters written, which is @len unless @nowait is set
+ */
+int NS16550_write(NS16550_t com_port, const char *s, int len, int nowait);
 char NS16550_getc(NS16550_t com_port);
 int NS16550_tstc(NS16550_t com_port);
 void NS16550_reinit(NS16550_t com_port, int baud_divisor);
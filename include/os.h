@@ -90,6 +90,7 @@ int os_open(const char *pathname, int flags);
 #define OS_O_RDWR	2
 #define OS_O_MASK	3	/* Mask for read/write flags */
 #define OS_O_CREAT	0100
+#define OS_O_TRUNC	01000
 
 /**
  * Access to the OS close() system call
@@ -261,4 +262,31 @@ int os_write_ram_buf(const char *fname);
  */
 int os_read_ram_buf(const char *fname);
 
+/**
+ * Start the sampling profiler
+ *
+ * This arms a SIGPROF interval timer. On each tick the interrupted PC and
+ * the return addresses of its callers are recorded in the next sample.
+ * Each sample is (@depth + 1) words: the number of addresses recorded,
+ * then the addresses, innermost first. When the buffer is full, the
+ * oldest samples are overwritten.
+ *
+ * @param buf		Buffer to hold samples
+ * @param size		Number of samples that fit in @buf
+ * @param depth		Maximum number of addresses to record per sample
+ * @param interval_us	Time between samples in microseconds of CPU time,
+ *			which must be at least 1
+ * @return 0 if OK, -1 on error (e.g. profiler already running, or a bad
+ *	argument)
+ */
+int os_profile_start(uintptr_t *buf, int size, int depth, int interval_us);
+
+/**
+ * Stop the sampling profiler
+ *
+ * @return number of samples taken since os_profile_start(), which may be
+ *	larger than the buffer size
+ */
+unsigned long os_profile_stop(void);
+
 #endif
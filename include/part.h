@@ -54,6 +54,9 @@ typedef struct block_dev_desc {
 				       unsigned long start,
 				       lbaint_t blkcnt);
 	void		*priv;		/* driver private struct pointer */
+#ifdef CONFIG_EFI_PARTITION_CACHE
+	struct gpt_cache *gpt_cache;	/* validated GPT, see part_efi.c */
+#endif
 }block_dev_desc_t;
 
 #define BLOCK_CNT(size, block_dev_desc) (PAD_COUNT(size, block_dev_desc->blksz))
@@ -247,4 +250,40 @@ int gpt_restore(block_dev_desc_t *dev_desc, char *str_disk_guid,
 		disk_partition_t *partitions, const int parts_count);
 #endif
 
+#ifdef CONFIG_EFI_PARTITION_CACHE
+/**
+ * part_efi_invalidate() - Drop any cached GPT for a device
+ *
+ * This must be called when the GPT on a device may have changed other than
+ * through write_gpt_table(), e.g. after a raw write to the device or when
+ * the medium is changed.
+ *
+ * @param dev_desc - block device descriptor
+ */
+void part_efi_invalidate(block_dev_desc_t *dev_desc);
+
+/**
+ * part_efi_note_write() - Tell the GPT cache that blocks are being written
+ *
+ * Block device drivers call this from their write and erase functions.
+ * The cached GPT is dropped if the blocks might hold part of the primary
+ * or backup GPT.
+ *
+ * @param dev_desc - block device descriptor
+ * @param start - first block being written
+ * @param blkcnt - number of blocks being written
+ */
+void part_efi_note_write(block_dev_desc_t *dev_desc, lbaint_t start,
+			 lbaint_t blkcnt);
+
+/**
+ * part_efi_print_cache_stats() - Show how well the GPT cache is doing
+ */
+void part_efi_print_cache_stats(void);
+#else
+static inline void part_efi_invalidate(block_dev_desc_t *dev_desc) {}
+static inline void part_efi_note_write(block_dev_desc_t *dev_desc,
+				       lbaint_t start, lbaint_t blkcnt) {}
+#endif
+
 #endif /* _PART_H */
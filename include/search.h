@@ -66,6 +66,9 @@ struct hsearch_data {
 	struct _ENTRY *table;
 	unsigned int size;
 	unsigned int filled;
+	unsigned int deleted;	/* slots holding a deleted entry */
+	unsigned int *sorted;	/* slots of the 'filled' entries, by key */
+	int busy;		/* callbacks running, so don't move entries */
 /*
  * Callback function which will check whether the given change for variable
  * "item" to "newval" may be applied or not, and possibly apply such change.
@@ -77,7 +80,10 @@ struct hsearch_data {
 		int flag);
 };
 
-/* Create a new hashing table which will at most contain NEL elements.  */
+/*
+ * Create a new hashing table with room for at least NEL elements. It grows
+ * as needed when entries are added.
+ */
 extern int hcreate_r(size_t __nel, struct hsearch_data *__htab);
 
 /* Destroy current internal hashing table.  */
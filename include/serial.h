@@ -14,6 +14,7 @@ struct serial_device {
 	int	(*tstc)(void);
 	void	(*putc)(const char c);
 	void	(*puts)(const char *s);
+	int	(*flush)(int wait);
 #if CONFIG_POST & CONFIG_SYS_POST_UART
 	void	(*loop)(int);
 #endif
@@ -47,6 +48,22 @@ extern void serial_stdio_init(void);
 extern int serial_assign(const char *name);
 extern void serial_reinit_all(void);
 
+#if defined(CONFIG_SERIAL_TX_BUFFER) && !defined(CONFIG_SPL_BUILD)
+/**
+ * serial_flush() - Send output which the serial drivers have buffered
+ *
+ * @wait:	1 to wait until all of it is sent, 0 to send only what the
+ *		UARTs will take without waiting
+ * @return number of characters still waiting to be sent
+ */
+int serial_flush(int wait);
+#else
+static inline int serial_flush(int wait)
+{
+	return 0;
+}
+#endif
+
 /* For usbtty */
 #ifdef CONFIG_USB_TTY
 
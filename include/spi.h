@@ -41,6 +41,12 @@
 /* SPI transfer flags */
 #define SPI_XFER_BEGIN	0x01			/* Assert CS before transfer */
 #define SPI_XFER_END	0x02			/* Deassert CS after transfer */
+#define SPI_XFER_DUAL	0x04			/* Receive data on 2 wires */
+#define SPI_XFER_QUAD	0x08			/* Receive data on 4 wires */
+
+/* Multi-wire receive modes, for spi_slave->rx_mode */
+#define SPI_RX_DUAL	0x01			/* Can receive on 2 wires */
+#define SPI_RX_QUAD	0x02			/* Can receive on 4 wires */
 
 /*-----------------------------------------------------------------------
  * Representation of a SPI slave, i.e. what we're communicating with.
@@ -57,6 +63,9 @@
  *		it is free running
  *   max_timeout_ms: maximum timeout to wait for reply in case of free
  *		running slave, in milliseconds
+ *   rx_mode:	Multi-wire receive modes supported by the controller
+ *		(SPI_RX_...). If non-zero, spi_xfer() accepts SPI_XFER_DUAL
+ *		and/or SPI_XFER_QUAD for receive-only transfers.
  */
 struct spi_slave {
 	unsigned int	bus;
@@ -65,6 +74,7 @@ struct spi_slave {
 	uint8_t	half_duplex;
 	uint8_t frame_header;
 	uint16_t max_timeout_ms;
+	uint8_t rx_mode;
 };
 
 /*-----------------------------------------------------------------------
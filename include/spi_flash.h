@@ -38,6 +38,16 @@ struct spi_flash {
 	u32		page_size;
 	/* Erase (sector) size */
 	u32		sector_size;
+	/*
+	 * Erase sizes supported by the chip, as a bitmask of sizes in bytes
+	 * (each a power of 2). The erase function uses the largest that
+	 * fits. If 0, only sector_size is used.
+	 */
+	u32		erase_sizes;
+	/* Multi-wire reads supported by the chip (SPI_RX_...) */
+	u8		read_modes;
+	/* Command used for reads, chosen when the chip is probed */
+	u8		read_cmd;
 
 	void *memory_map;	/* Address of read-only SPI flash access */
 	int		(*read)(struct spi_flash *flash, u32 offset,
@@ -151,6 +161,39 @@ int spi_flash_cmd_write_status(struct spi_flash *flash, unsigned int status,
  */
 int spi_flash_cmd_read_status(struct spi_flash *flash, unsigned int *status);
 
+/**
+ * struct spi_flash_update_stats - what spi_flash_update() had to do
+ *
+ * @erased: Number of bytes erased
+ * @programmed: Number of bytes programmed
+ * @unchanged: Number of bytes in sectors which already had the new data
+ */
+struct spi_flash_update_stats {
+	size_t erased;
+	size_t programmed;
+	size_t unchanged;
+};
+
+/**
+ * spi_flash_update() - Write to SPI flash, touching only what has changed
+ *
+ * Each sector in the range is read and compared with the new data.
+ * Sectors which already hold the new data are skipped, and sectors which
+ * only need bits cleared are programmed without being erased. Only pages
+ * which differ are programmed, so blank pages in an erased sector are
+ * skipped. Data outside the range in the first and last sectors is kept,
+ * so @offset and @len need not be aligned.
+ *
+ * @flash: SPI flash to update
+ * @offset: Offset to write to
+ * @len: Number of bytes to write
+ * @buf: Data to write
+ * @stats: Statistics, which are added to (so zero them first)
+ * @return 0 if ok, -ve on error
+ */
+int spi_flash_update(struct spi_flash *flash, u32 offset, size_t len,
+		     const void *buf, struct spi_flash_update_stats *stats);
+
 void spi_boot(void) __noreturn;
 
 #endif /* _SPI_FLASH_H_ */
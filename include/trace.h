@@ -42,6 +42,20 @@ enum {
 enum trace_chunk_type {
 	TRACE_CHUNK_FUNCS,
 	TRACE_CHUNK_CALLS,
+
+	/*
+	 * Profile samples from the 'profile' command. Each sample is a
+	 * uint32_t count followed by that many uint32_t function offsets,
+	 * innermost first.
+	 */
+	TRACE_CHUNK_SAMPLES,
+
+	/*
+	 * Compact call records (CONFIG_TRACE_COMPACT). The header is followed
+	 * by a uint32_t byte count and then that many bytes of records, as
+	 * described below.
+	 */
+	TRACE_CHUNK_COMPACT,
 };
 
 /* A trace record for a function, as written to the profile output file */
@@ -59,6 +73,18 @@ struct trace_output_hdr {
 /* Print statistics about traced function calls */
 void trace_print_stats(void);
 
+/**
+ * Print the functions which took the most time
+ *
+ * This needs CONFIG_TRACE_STATS. Functions are listed in order of their
+ * exclusive time, i.e. time spent in the function itself and not in
+ * functions that it called. Each is shown as an offset from the start of
+ * the U-Boot text.
+ *
+ * @param count		Maximum number of functions to list
+ */
+void trace_print_top(int count);
+
 /**
  * Dump a list of functions and call counts into a buffer
  *
@@ -93,6 +119,74 @@ struct trace_call {
 
 int trace_list_calls(void *buff, int buff_size, unsigned int *needed);
 
+/*
+ * Compact call records are three unsigned LEB128 varints:
+ *
+ *	(timestamp - prev_timestamp) << 2 | type
+ *	zigzag(func - prev_func)
+ *	zigzag(caller - func)
+ *
+ * where type is the top two bits of the trace_call flags and func/caller
+ * are function site numbers (offset / FUNC_SITE_SIZE). The previous
+ * function and timestamp are zero at the start of each chunk, so each
+ * chunk can be decoded on its own. A record is at most
+ * TRACE_COMPACT_MAX bytes.
+ */
+#define TRACE_COMPACT_MAX	15
+
+/**
+ * Decode a compact call record
+ *
+ * @param p		Pointer to the record
+ * @param call		On entry, the previous record decoded from this chunk
+ *			(zeroed for the first record). On exit, the decoded
+ *			record with func and caller as function site numbers.
+ * @return pointer to the next record
+ */
+static inline const uint8_t *trace_compact_decode(const uint8_t *p,
+						  struct trace_call *call)
+{
+	uint32_t val[3];
+	int i, shift;
+
+	for (i = 0; i < 3; i++) {
+		val[i] = 0;
+		shift = 0;
+		do {
+			val[i] |= (uint32_t)(*p & 0x7f) << shift;
+			shift += 7;
+		} while (*p++ & 0x80);
+	}
+	call->flags = (((call->flags + (val[0] >> 2)) & FUNCF_TIMESTAMP_MASK) |
+		       (val[0] & 3) << 30);
+	call->func += (val[1] >> 1) ^ -(val[1] & 1);
+	call->caller = call->func + ((val[2] >> 1) ^ -(val[2] & 1));
+
+	return p;
+}
+
+/**
+ * Write all compact trace records to the drain (CONFIG_TRACE_DRAIN)
+ *
+ * Records are normally drained a chunk at a time when the trace buffer
+ * fills up. This writes out whatever is left, e.g. before booting an OS.
+ *
+ * @return 0 if ok, -ve on error
+ */
+int trace_drain(void);
+
+/**
+ * Write a chunk of trace records to the drain (CONFIG_TRACE_DRAIN)
+ *
+ * This is called with tracing paused. The default implementation appends
+ * to the area at CONFIG_TRACE_DRAIN_ADDR. Boards can provide their own.
+ *
+ * @param buf		Chunk to write, starting with a trace_output_hdr
+ * @param size		Size of chunk in bytes
+ * @return 0 if ok, -ve on error, in which case draining stops
+ */
+int trace_drain_write(const void *buf, int size);
+
 /**
  * Turn function tracing on and off
  *
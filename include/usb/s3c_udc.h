@@ -31,8 +31,17 @@
 #define PHY0_SLEEP              (1 << 5)
 
 /*-------------------------------------------------------------------------*/
-/* DMA bounce buffer size, 16K is enough even for mass storage */
+/*
+ * DMA bounce buffer size, 16K is enough for mass storage unless it is
+ * configured with larger buffers. Each IN request is copied into this
+ * buffer, so it must hold a whole one.
+ */
+#if defined(CONFIG_USB_GADGET_FSG_BUFLEN) && \
+	CONFIG_USB_GADGET_FSG_BUFLEN > 4096 * 4
+#define DMA_BUFFER_SIZE	CONFIG_USB_GADGET_FSG_BUFLEN
+#else
 #define DMA_BUFFER_SIZE	(4096*4)
+#endif
 
 #define EP0_FIFO_SIZE		64
 #define EP_FIFO_SIZE		512
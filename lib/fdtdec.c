@@ -20,6 +20,7 @@
  */
 
 #include <common.h>
+#include <malloc.h>
 #include <serial.h>
 #include <libfdt.h>
 #include <fdtdec.h>
@@ -99,6 +100,334 @@ const char *fdtdec_get_compatible(enum fdt_compat_id id)
 	return compat_names[id];
 }
 
+struct fdtdec_phandle {
+	uint32_t phandle;
+	int node;
+};
+
+struct fdtdec_alias {
+	const char *name;
+	int node;
+};
+
+/**
+ * Index of a device tree, built by fdtdec_index_build()
+ *
+ * @blob:		Blob which was indexed
+ * @totalsize:		fdt_totalsize() of @blob when it was indexed
+ * @struct_size:	fdt_size_dt_struct() of @blob when it was indexed
+ * @compat_start:	For each compatible ID, index into @compat_node of
+ *			the first node with that ID. Entry COMPAT_COUNT is
+ *			the total number of entries in @compat_node
+ * @compat_node:	Node offsets, grouped by compatible ID and in
+ *			ascending order within each group
+ * @node_count:		Number of nodes with a known compatible ID
+ * @node:		Offsets of nodes with a known compatible ID, in
+ *			ascending order
+ * @node_id:		Lowest compatible ID of each node in @node
+ * @phandle_count:	Number of nodes with a phandle
+ * @phandle:		Phandles and their nodes, sorted by phandle
+ * @alias_count:	Number of aliases
+ * @alias:		Aliases and their nodes, sorted by name
+ */
+struct fdtdec_index {
+	const void *blob;
+	uint32_t totalsize;
+	uint32_t struct_size;
+	int compat_start[COMPAT_COUNT + 1];
+	int *compat_node;
+	int node_count;
+	int *node;
+	u8 *node_id;
+	int phandle_count;
+	struct fdtdec_phandle *phandle;
+	int alias_count;
+	struct fdtdec_alias *alias;
+};
+
+#ifdef CONFIG_FDTDEC_INDEX
+static struct fdtdec_index fdt_index;
+
+static struct fdtdec_index *fdtdec_index_get(const void *blob)
+{
+	if (!blob || blob != fdt_index.blob)
+		return NULL;
+
+	/* Adding or removing nodes or properties moves the node offsets */
+	if (fdt_totalsize(blob) != fdt_index.totalsize ||
+	    fdt_size_dt_struct(blob) != fdt_index.struct_size)
+		return NULL;
+
+	return &fdt_index;
+}
+
+/**
+ * Work out which compatible IDs a node has
+ *
+ * @param blob		FDT blob
+ * @param node		Node to check
+ * @param ids		Bitmap of IDs to fill in
+ * @return lowest ID found, or -1 if none
+ */
+static int fdtdec_index_node_ids(const void *blob, int node, u32 *ids)
+{
+	const char *compat, *end;
+	int lowest = -1;
+	int id, len;
+
+	compat = fdt_getprop(blob, node, "compatible", &len);
+	if (!compat)
+		return -1;
+	for (end = compat + len; compat < end; compat += strlen(compat) + 1) {
+		for (id = 0; id < COMPAT_COUNT; id++) {
+			if (strcmp(compat, compat_names[id]))
+				continue;
+			ids[id / 32] |= 1 << (id % 32);
+			if (lowest == -1 || id < lowest)
+				lowest = id;
+		}
+	}
+
+	return lowest;
+}
+
+static int fdtdec_phandle_cmp(const void *a, const void *b)
+{
+	const struct fdtdec_phandle *pa = a, *pb = b;
+
+	return pa->phandle < pb->phandle ? -1 : pa->phandle > pb->phandle;
+}
+
+static int fdtdec_alias_cmp(const void *a, const void *b)
+{
+	const struct fdtdec_alias *pa = a, *pb = b;
+
+	return strcmp(pa->name, pb->name);
+}
+
+/*
+ * Go through the tree, either counting (if idx->compat_node is NULL) or
+ * filling in the index
+ */
+static void fdtdec_index_scan(const void *blob, struct fdtdec_index *idx,
+			      int *fill)
+{
+	u32 ids[DIV_ROUND_UP(COMPAT_COUNT, 32)];
+	uint32_t phandle;
+	int node, id;
+
+	for (node = 0; node >= 0; node = fdt_next_node(blob, node, NULL)) {
+		memset(ids, '\0', sizeof(ids));
+		id = fdtdec_index_node_ids(blob, node, ids);
+		if (id != -1) {
+			if (idx->node) {
+				idx->node[idx->node_count] = node;
+				idx->node_id[idx->node_count] = id;
+			}
+			idx->node_count++;
+			for (id = 0; id < COMPAT_COUNT; id++) {
+				if (!(ids[id / 32] & (1 << (id % 32))))
+					continue;
+				if (fill)
+					idx->compat_node[fill[id]++] = node;
+				else
+					idx->compat_start[id + 1]++;
+			}
+		}
+		phandle = fdt_get_phandle(blob, node);
+		if (phandle) {
+			if (idx->phandle) {
+				idx->phandle[idx->phandle_count].phandle =
+					phandle;
+				idx->phandle[idx->phandle_count].node = node;
+			}
+			idx->phandle_count++;
+		}
+	}
+}
+
+void fdtdec_index_free(void)
+{
+	free(fdt_index.compat_node);
+	free(fdt_index.node);
+	free(fdt_index.node_id);
+	free(fdt_index.phandle);
+	free(fdt_index.alias);
+	memset(&fdt_index, '\0', sizeof(fdt_index));
+}
+
+int fdtdec_index_build(const void *blob)
+{
+	struct fdtdec_index *idx = &fdt_index;
+	int fill[COMPAT_COUNT];
+	int alias_node, offset;
+	int id, count;
+
+	fdtdec_index_free();
+	if (!blob || fdt_check_header(blob))
+		return -FDT_ERR_BADMAGIC;
+
+	/* Count everything first, so we know how much space we need */
+	fdtdec_index_scan(blob, idx, NULL);
+	for (id = 0; id < COMPAT_COUNT; id++)
+		idx->compat_start[id + 1] += idx->compat_start[id];
+
+	alias_node = fdt_path_offset(blob, "/aliases");
+	count = 0;
+	for (offset = fdt_first_property_offset(blob, alias_node);
+	     offset >= 0;
+	     offset = fdt_next_property_offset(blob, offset))
+		count++;
+
+	idx->compat_node = malloc(idx->compat_start[COMPAT_COUNT] *
+				  sizeof(int));
+	idx->node = malloc(idx->node_count * sizeof(int));
+	idx->node_id = malloc(idx->node_count);
+	idx->phandle = malloc(idx->phandle_count *
+			      sizeof(struct fdtdec_phandle));
+	idx->alias = malloc(count * sizeof(struct fdtdec_alias));
+	if (!idx->compat_node || !idx->node || !idx->node_id ||
+	    !idx->phandle || !idx->alias) {
+		fdtdec_index_free();
+		return -FDT_ERR_NOSPACE;
+	}
+
+	/* Now fill it in */
+	memcpy(fill, idx->compat_start, sizeof(fill));
+	idx->node_count = 0;
+	idx->phandle_count = 0;
+	fdtdec_index_scan(blob, idx, fill);
+	qsort(idx->phandle, idx->phandle_count, sizeof(struct fdtdec_phandle),
+	      fdtdec_phandle_cmp);
+
+	for (offset = fdt_first_property_offset(blob, alias_node);
+	     offset >= 0;
+	     offset = fdt_next_property_offset(blob, offset)) {
+		const struct fdt_property *prop;
+		struct fdtdec_alias *alias;
+		int node;
+
+		prop = fdt_get_property_by_offset(blob, offset, NULL);
+		node = fdt_path_offset(blob, prop->data);
+		if (node < 0)
+			continue;
+		alias = &idx->alias[idx->alias_count++];
+		alias->name = fdt_string(blob, fdt32_to_cpu(prop->nameoff));
+		alias->node = node;
+	}
+	qsort(idx->alias, idx->alias_count, sizeof(struct fdtdec_alias),
+	      fdtdec_alias_cmp);
+
+	idx->blob = blob;
+	idx->totalsize = fdt_totalsize(blob);
+	idx->struct_size = fdt_size_dt_struct(blob);
+	debug("%s: %d nodes with %d compatible IDs, %d phandles, %d aliases\n",
+	      __func__, idx->node_count, idx->compat_start[COMPAT_COUNT],
+	      idx->phandle_count, idx->alias_count);
+
+	return 0;
+}
+#else
+static inline struct fdtdec_index *fdtdec_index_get(const void *blob)
+{
+	return NULL;
+}
+#endif
+
+/* Find the first entry in a sorted list of offsets which is after node */
+static int fdtdec_index_after(const int *list, int count, int node)
+{
+	int low = 0, high = count;
+
+	while (low < high) {
+		int mid = (low + high) / 2;
+
+		if (list[mid] <= node)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	return low;
+}
+
+static int fdtdec_index_has_compat(struct fdtdec_index *idx, int node,
+				   enum fdt_compat_id id)
+{
+	const int *list = idx->compat_node + idx->compat_start[id];
+	int count = idx->compat_start[id + 1] - idx->compat_start[id];
+	int pos;
+
+	pos = fdtdec_index_after(list, count, node);
+
+	return pos > 0 && list[pos - 1] == node;
+}
+
+static enum fdt_compat_id fdtdec_index_lookup(struct fdtdec_index *idx,
+					      int node)
+{
+	int pos;
+
+	pos = fdtdec_index_after(idx->node, idx->node_count, node);
+	if (pos > 0 && idx->node[pos - 1] == node)
+		return idx->node_id[pos - 1];
+
+	return COMPAT_UNKNOWN;
+}
+
+static int fdtdec_index_next_compatible(struct fdtdec_index *idx, int node,
+					enum fdt_compat_id id)
+{
+	const int *list = idx->compat_node + idx->compat_start[id];
+	int count = idx->compat_start[id + 1] - idx->compat_start[id];
+	int pos;
+
+	pos = fdtdec_index_after(list, count, node);
+
+	return pos < count ? list[pos] : -FDT_ERR_NOTFOUND;
+}
+
+static int fdtdec_index_phandle(struct fdtdec_index *idx, uint32_t phandle)
+{
+	int low = 0, high = idx->phandle_count;
+
+	if (!phandle || phandle == -1)
+		return -FDT_ERR_BADPHANDLE;
+	while (low < high) {
+		int mid = (low + high) / 2;
+		struct fdtdec_phandle *entry = &idx->phandle[mid];
+
+		if (entry->phandle == phandle)
+			return entry->node;
+		if (entry->phandle < phandle)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	return -FDT_ERR_NOTFOUND;
+}
+
+/* Returns the same errors as fdt_path_offset() would for an alias */
+static int fdtdec_index_alias(struct fdtdec_index *idx, const char *name)
+{
+	int low = 0, high = idx->alias_count;
+
+	while (low < high) {
+		int mid = (low + high) / 2;
+		int cmp = strcmp(idx->alias[mid].name, name);
+
+		if (!cmp)
+			return idx->alias[mid].node;
+		if (cmp < 0)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	return -FDT_ERR_BADPATH;
+}
+
 fdt_addr_t fdtdec_get_addr_size(const void *blob, int node,
 		const char *prop_name, fdt_size_t *sizep)
 {
@@ -183,8 +512,12 @@ int fdtdec_get_is_enabled(const void *blob, int node)
 
 enum fdt_compat_id fdtdec_lookup(const void *blob, int node)
 {
+	struct fdtdec_index *idx = fdtdec_index_get(blob);
 	enum fdt_compat_id id;
 
+	if (idx)
+		return fdtdec_index_lookup(idx, node);
+
 	/* Search our drivers */
 	for (id = COMPAT_UNKNOWN; id < COMPAT_COUNT; id++)
 		if (0 == fdt_node_check_compatible(blob, node,
@@ -196,18 +529,27 @@ enum fdt_compat_id fdtdec_lookup(const void *blob, int node)
 int fdtdec_next_compatible(const void *blob, int node,
 		enum fdt_compat_id id)
 {
+	struct fdtdec_index *idx = fdtdec_index_get(blob);
+
+	if (idx)
+		return fdtdec_index_next_compatible(idx, node, id);
+
 	return fdt_node_offset_by_compatible(blob, node, compat_names[id]);
 }
 
 int fdtdec_next_compatible_subnode(const void *blob, int node,
 		enum fdt_compat_id id, int *depthp)
 {
+	struct fdtdec_index *idx = fdtdec_index_get(blob);
+
 	do {
 		node = fdt_next_node(blob, node, depthp);
 	} while (*depthp > 1);
 
 	/* If this is a direct subnode, and compatible, return it */
-	if (*depthp == 1 && 0 == fdt_node_check_compatible(
+	if (*depthp == 1 && idx && fdtdec_index_has_compat(idx, node, id))
+		return node;
+	if (*depthp == 1 && !idx && 0 == fdt_node_check_compatible(
 						blob, node, compat_names[id]))
 		return node;
 
@@ -218,16 +560,24 @@ int fdtdec_next_alias(const void *blob, const char *name,
 		enum fdt_compat_id id, int *upto)
 {
 #define MAX_STR_LEN 20
+	struct fdtdec_index *idx = fdtdec_index_get(blob);
 	char str[MAX_STR_LEN + 20];
 	int node, err;
 
 	/* snprintf() is not available */
 	assert(strlen(name) < MAX_STR_LEN);
 	sprintf(str, "%.*s%d", MAX_STR_LEN, name, *upto);
-	node = fdt_path_offset(blob, str);
-	if (node < 0)
-		return node;
-	err = fdt_node_check_compatible(blob, node, compat_names[id]);
+	if (idx) {
+		node = fdtdec_index_alias(idx, str);
+		if (node < 0)
+			return node;
+		err = !fdtdec_index_has_compat(idx, node, id);
+	} else {
+		node = fdt_path_offset(blob, str);
+		if (node < 0)
+			return node;
+		err = fdt_node_check_compatible(blob, node, compat_names[id]);
+	}
 	if (err < 0)
 		return err;
 	if (err)
@@ -384,6 +734,7 @@ int fdtdec_prepare_fdt(void)
 
 int fdtdec_lookup_phandle(const void *blob, int node, const char *prop_name)
 {
+	struct fdtdec_index *idx = fdtdec_index_get(blob);
 	const u32 *phandle;
 	int lookup;
 
@@ -392,6 +743,8 @@ int fdtdec_lookup_phandle(const void *blob, int node, const char *prop_name)
 	if (!phandle)
 		return -FDT_ERR_NOTFOUND;
 
+	if (idx)
+		return fdtdec_index_phandle(idx, fdt32_to_cpu(*phandle));
 	lookup = fdt_node_offset_by_phandle(blob, fdt32_to_cpu(*phandle));
 	return lookup;
 }
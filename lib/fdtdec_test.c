@@ -28,6 +28,8 @@
 #include <malloc.h>
 #include <os.h>
 
+DECLARE_GLOBAL_DATA_PTR;
+
 /* The size of our test fdt blob */
 #define FDT_SIZE	(16 * 1024)
 
@@ -78,6 +80,11 @@ static int checkval(const char *oper_name, int expected, int value)
 /* maximum number of nodes / aliases to generate */
 #define MAX_NODES	20
 
+#ifdef CONFIG_FDTDEC_INDEX
+/* Set to build an index of each test fdt, so that lookups use it */
+static int test_index;
+#endif
+
 /*
  * Make a test fdt
  *
@@ -151,6 +158,10 @@ static int run_test(const char *aliases, const char *nodes, const char *expect)
 
 	printf("aliases=%s, nodes=%s, expect=%s: ", aliases, nodes, expect);
 	CHECKVAL(make_fdt(blob, FDT_SIZE, aliases, nodes), 0);
+#ifdef CONFIG_FDTDEC_INDEX
+	if (test_index)
+		CHECKOK(fdtdec_index_build(blob));
+#endif
 	CHECKVAL(fdtdec_find_aliases_for_id(blob, "i2c",
 			COMPAT_UNKNOWN,
 			list, ARRAY_SIZE(list)), strlen(expect));
@@ -176,8 +187,155 @@ static int run_test(const char *aliases, const char *nodes, const char *expect)
 	return 0;
 }
 
-static int do_test_fdtdec(cmd_tbl_t *cmdtp, int flag, int argc,
-			  char * const argv[])
+#ifdef CONFIG_FDTDEC_INDEX
+/* Size of the blob used for benchmarking, and number of nodes in it */
+#define BENCH_FDT_SIZE		(128 * 1024)
+#define BENCH_NODES		500
+
+/*
+ * Make a larger fdt for benchmarking, with a node for each compatible ID
+ * in turn, each with a phandle and an alias. The last node is the one
+ * that the lookups look for, since that is the slowest to find without
+ * an index. The first node has a phandle reference to it.
+ */
+static int make_bench_fdt(void *fdt, int size, int count)
+{
+	char name[20], value[20];
+	int i;
+
+	CHECK(fdt_create(fdt, size));
+	CHECK(fdt_finish_reservemap(fdt));
+	CHECK(fdt_begin_node(fdt, ""));
+
+	CHECK(fdt_begin_node(fdt, "aliases"));
+	for (i = 0; i < count; i++) {
+		sprintf(name, "bench%d", i);
+		sprintf(value, "/bench%d@0", i);
+		CHECK(fdt_property_string(fdt, name, value));
+	}
+	CHECK(fdt_end_node(fdt));
+
+	CHECK(fdt_begin_node(fdt, "consumer"));
+	CHECK(fdt_property_cell(fdt, "target", count));
+	CHECK(fdt_end_node(fdt));
+
+	for (i = 0; i < count; i++) {
+		sprintf(value, "bench%d@0", i);
+		CHECK(fdt_begin_node(fdt, value));
+		CHECK(fdt_property_string(fdt, "compatible",
+			fdtdec_get_compatible(i == count - 1 ? COMPAT_COUNT - 1 :
+					      1 + i % (COMPAT_COUNT - 2))));
+		CHECK(fdt_property_cell(fdt, "phandle", i + 1));
+		CHECK(fdt_end_node(fdt));
+	}
+
+	CHECK(fdt_end_node(fdt));
+	CHECK(fdt_finish(fdt));
+
+	return 0;
+}
+
+/**
+ * Time a set of lookups on the benchmark fdt
+ *
+ * @param blob		Device tree to look in
+ * @param count		Number of nodes in the tree
+ * @param loops		Number of times to repeat each lookup
+ * @param result	Returns the node found by each lookup
+ * @param time_us	Returns the time taken by each lookup
+ */
+static void run_bench(const void *blob, int count, int loops, int result[4],
+		      ulong time_us[4])
+{
+	enum fdt_compat_id id = COMPAT_COUNT - 1;
+	int consumer, node, upto;
+	ulong start;
+	int i;
+
+	consumer = fdt_path_offset(blob, "/consumer");
+	node = fdtdec_next_compatible(blob, 0, id);
+
+	start = timer_get_us();
+	for (i = 0; i < loops; i++)
+		result[0] = fdtdec_next_compatible(blob, 0, id);
+	time_us[0] = timer_get_us() - start;
+
+	start = timer_get_us();
+	for (i = 0; i < loops; i++)
+		result[1] = fdtdec_lookup(blob, node);
+	time_us[1] = timer_get_us() - start;
+
+	start = timer_get_us();
+	for (i = 0; i < loops; i++)
+		result[2] = fdtdec_lookup_phandle(blob, consumer, "target");
+	time_us[2] = timer_get_us() - start;
+
+	start = timer_get_us();
+	for (i = 0; i < loops; i++) {
+		upto = count - 1;
+		result[3] = fdtdec_next_alias(blob, "bench", id, &upto);
+	}
+	time_us[3] = timer_get_us() - start;
+}
+
+static int do_bench_fdtdec(int count, int loops)
+{
+	static const char * const name[4] = {
+		"fdtdec_next_compatible", "fdtdec_lookup",
+		"fdtdec_lookup_phandle", "fdtdec_next_alias",
+	};
+	int before[4], after[4];
+	ulong before_us[4], after_us[4], build_us;
+	void *blob;
+	int ret = 0;
+	int i;
+
+	blob = malloc(BENCH_FDT_SIZE);
+	if (!blob) {
+		printf("%s: out of memory\n", __func__);
+		return 1;
+	}
+	if (make_bench_fdt(blob, BENCH_FDT_SIZE, count)) {
+		free(blob);
+		return 1;
+	}
+
+	/* Only one index is kept, so this drops the control FDT's index */
+	fdtdec_index_free();
+	run_bench(blob, count, loops, before, before_us);
+	build_us = timer_get_us();
+	if (fdtdec_index_build(blob)) {
+		printf("Cannot build index\n");
+		free(blob);
+		return 1;
+	}
+	build_us = timer_get_us() - build_us;
+	run_bench(blob, count, loops, after, after_us);
+	fdtdec_index_free();
+
+	printf("%d nodes, %d loops, index built in %lu us\n", count, loops,
+	       build_us);
+	printf("%-24s %10s %10s\n", "Lookup", "Without", "With");
+	for (i = 0; i < 4; i++) {
+		printf("%-24s %7lu us %7lu us\n", name[i], before_us[i],
+		       after_us[i]);
+		if (before[i] != after[i] || before[i] < 0) {
+			printf("%s: results differ: %d, %d\n", name[i],
+			       before[i], after[i]);
+			ret = 1;
+		}
+	}
+	free(blob);
+
+	/* Put back the index for the control FDT */
+	if (gd->fdt_blob)
+		fdtdec_index_build(gd->fdt_blob);
+
+	return ret;
+}
+#endif
+
+static int run_tests(void)
 {
 	/* basic tests */
 	CHECKOK(run_test("", "", ""));
@@ -217,6 +375,82 @@ static int do_test_fdtdec(cmd_tbl_t *cmdtp, int flag, int argc,
 	CHECKOK(run_test("2a 1a 0a", "a", "  a"));
 	CHECKOK(run_test("0a 1a 2a", "a", "a"));
 
+	return 0;
+}
+
+#ifdef CONFIG_FDTDEC_INDEX
+/* Check that the index is not used once nodes have moved */
+static int run_stale_index_test(void)
+{
+	const char *compat = fdtdec_get_compatible(COMPAT_UNKNOWN);
+	int list[MAX_NODES];
+	void *blob;
+	int node;
+
+	blob = malloc(FDT_SIZE);
+	if (!blob) {
+		printf("%s: out of memory\n", __func__);
+		return 1;
+	}
+
+	printf("stale index: ");
+	CHECKVAL(make_fdt(blob, FDT_SIZE, "", "bc"), 0);
+	CHECKOK(fdtdec_index_build(blob));
+
+	/*
+	 * Add a node at the start, which moves the others. Give it an extra
+	 * property so that they do not move into each other's old places.
+	 */
+	CHECK(fdt_open_into(blob, blob, FDT_SIZE));
+	node = fdt_add_subnode(blob, 0, "i2c0@0");
+	CHECKVAL(node < 0, 0);
+	CHECK(fdt_setprop_string(blob, node, "compatible", compat));
+	CHECK(fdt_setprop_string(blob, node, "status", "okay"));
+	CHECKVAL(fdtdec_find_aliases_for_id(blob, "i2c", COMPAT_UNKNOWN,
+					    list, ARRAY_SIZE(list)), 3);
+	CHECKVAL(fdtdec_next_compatible(blob, 0, COMPAT_UNKNOWN), node);
+	CHECKVAL(fdtdec_next_compatible(blob, node, COMPAT_UNKNOWN),
+		 fdt_node_offset_by_compatible(blob, node, compat));
+	fdtdec_index_free();
+	free(blob);
+
+	printf("pass\n");
+	return 0;
+}
+#endif
+
+static int do_test_fdtdec(cmd_tbl_t *cmdtp, int flag, int argc,
+			  char * const argv[])
+{
+	int ret;
+
+#ifdef CONFIG_FDTDEC_INDEX
+	if (argc > 1 && !strcmp(argv[1], "bench")) {
+		int loops = 1000;
+
+		if (argc > 2)
+			loops = simple_strtoul(argv[2], NULL, 10);
+		return do_bench_fdtdec(BENCH_NODES, loops);
+	}
+#endif
+	ret = run_tests();
+#ifdef CONFIG_FDTDEC_INDEX
+	/* Again, using an index; this drops the control FDT's index */
+	if (!ret) {
+		printf("With index:\n");
+		test_index = 1;
+		ret = run_tests();
+		test_index = 0;
+		if (!ret)
+			ret = run_stale_index_test();
+		fdtdec_index_free();
+		if (gd->fdt_blob)
+			fdtdec_index_build(gd->fdt_blob);
+	}
+#endif
+	if (ret)
+		return 1;
+
 	printf("Test passed\n");
 	return 0;
 }
@@ -224,4 +458,5 @@ static int do_test_fdtdec(cmd_tbl_t *cmdtp, int flag, int argc,
 U_BOOT_CMD(
 	test_fdtdec, 3, 1, do_test_fdtdec,
 	"test_fdtdec",
-	"Run tests for fdtdec library");
+	"- Run tests for fdtdec library\n"
+	"test_fdtdec bench [<loops>] - Time fdtdec lookups with/without index");
@@ -26,6 +26,7 @@
 #include <command.h>
 #include <image.h>
 #include <malloc.h>
+#include <mempool.h>
 #include <u-boot/zlib.h>
 
 #define	ZALLOC_ALIGNMENT	16
@@ -53,6 +54,22 @@ void gzfree(void *x, void *addr, unsigned nb)
 	free (addr);
 }
 
+/*
+ * zunzip() allocates the same inflate state and window every time it is
+ * called, which can be once per block when reading a compressed filesystem.
+ * Take these from an arena which is reset once inflation is complete.
+ */
+static struct arena zunzip_arena = ARENA_INIT("zunzip", 48 << 10);
+
+static void *zunzip_alloc(void *x, unsigned items, unsigned size)
+{
+	return arena_alloc(&zunzip_arena, items * size);
+}
+
+static void zunzip_free(void *x, void *addr, unsigned nb)
+{
+}
+
 int gunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp)
 {
 	int i, flags;
@@ -91,12 +108,13 @@ int zunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp,
 	z_stream s;
 	int r;
 
-	s.zalloc = gzalloc;
-	s.zfree = gzfree;
+	s.zalloc = zunzip_alloc;
+	s.zfree = zunzip_free;
 
 	r = inflateInit2(&s, -MAX_WBITS);
 	if (r != Z_OK) {
 		printf ("Error: inflateInit2() returned %d\n", r);
+		arena_reset(&zunzip_arena);
 		return -1;
 	}
 	s.next_in = src + offset;
@@ -108,6 +126,7 @@ int zunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp,
 		if (r != Z_STREAM_END && r != Z_BUF_ERROR && stoponerr == 1) {
 			printf("Error: inflate() returned %d\n", r);
 			inflateEnd(&s);
+			arena_reset(&zunzip_arena);
 			return -1;
 		}
 		s.avail_in = *lenp - offset - (int)(s.next_out - (unsigned char*)dst);
@@ -115,6 +134,7 @@ int zunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp,
 	} while (r == Z_BUF_ERROR);
 	*lenp = s.next_out - (unsigned char *) dst;
 	inflateEnd(&s);
+	arena_reset(&zunzip_arena);
 
 	return 0;
 }
@@ -26,6 +26,7 @@
 
 #include <common.h>
 #include <bootstage.h>
+#include <serial.h>
 
 /**
  * hang - stop processing by staying in an endless loop
@@ -41,6 +42,7 @@ void hang(void)
 		defined(CONFIG_SPL_SERIAL_SUPPORT))
 	puts("### ERROR ### Please RESET the board ###\n");
 #endif
+	serial_flush(1);
 	bootstage_error(BOOTSTAGE_ID_NEED_RESET);
 	for (;;)
 		;
@@ -101,6 +101,15 @@ static int isprime(unsigned int number)
 	return number % div != 0;
 }
 
+static unsigned int next_prime(unsigned int number)
+{
+	number |= 1;		/* make odd */
+	while (!isprime(number))
+		number += 2;
+
+	return number;
+}
+
 /*
  * Before using the hash table we must allocate memory for it.
  * Test for an existing table are done. We allocate one element
@@ -123,17 +132,22 @@ int hcreate_r(size_t nel, struct hsearch_data *htab)
 		return 0;
 
 	/* Change nel to the first prime number not smaller as nel. */
-	nel |= 1;		/* make odd */
-	while (!isprime(nel))
-		nel += 2;
-
-	htab->size = nel;
+	if (nel < 5)
+		nel = 5;	/* probing needs at least this many */
+	htab->size = next_prime(nel);
 	htab->filled = 0;
+	htab->deleted = 0;
 
 	/* allocate memory and zero out */
 	htab->table = (_ENTRY *) calloc(htab->size + 1, sizeof(_ENTRY));
 	if (htab->table == NULL)
 		return 0;
+	htab->sorted = malloc(htab->size * sizeof(*htab->sorted));
+	if (htab->sorted == NULL) {
+		free(htab->table);
+		htab->table = NULL;
+		return 0;
+	}
 
 	/* everything went alright */
 	return 1;
@@ -169,6 +183,10 @@ void hdestroy_r(struct hsearch_data *htab)
 		}
 	}
 	free(htab->table);
+	free(htab->sorted);
+	htab->sorted = NULL;
+	htab->filled = 0;
+	htab->deleted = 0;
 
 	/* the sign for an existing table is an value != NULL in htable */
 	htab->table = NULL;
@@ -181,17 +199,26 @@ void hdestroy_r(struct hsearch_data *htab)
 /*
  * This is the search function. It uses double hashing with open addressing.
  * The argument item.key has to be a pointer to an zero terminated, most
- * probably strings of chars. The function for generating a number of the
- * strings is simple but fast. It can be replaced by a more complex function
- * like ajw (see [Aho,Sethi,Ullman]) if the needs are shown.
+ * probably strings of chars. Keys are hashed with FNV-1a, which spreads
+ * the similar names common in environments (bootcmd, bootargs, ...) well.
  *
  * We use an trick to speed up the lookup. The table is created by hcreate
  * with one more element available. This enables us to use the index zero
- * special. This index will never be used because we store the first hash
- * index in the field used where zero means not used. Every other value
- * means used. The used field can be used as a first fast comparison for
- * equality of the stored and the parameter value. This helps to prevent
- * unnecessary expensive calls of strcmp.
+ * special. This index will never be used because we store the hash value
+ * in the field used where zero means not used and -1 means deleted. Every
+ * other value means used. The used field can be used as a first fast
+ * comparison for equality of the stored and the parameter value. This
+ * helps to prevent unnecessary expensive calls of strcmp.
+ *
+ * When an insert would make the table more than 3/4 full (counting
+ * deleted slots, which lengthen searches just as much), the entries are
+ * moved to a new table with room for about twice as many. This changes
+ * the slot numbers and ENTRY pointers, but not the key and data strings.
+ * The table is never resized while an entry's callback is running.
+ *
+ * A list of the slots in use, sorted by key, is kept up to date as
+ * entries are added and deleted, so that hexport_r() does not have to
+ * sort the entries each time.
  *
  * This implementation differs from the standard library version of
  * this function in a number of ways:
@@ -231,6 +258,130 @@ int hmatch_r(const char *match, int last_idx, ENTRY ** retval,
 	return 0;
 }
 
+/* FNV-1a hash of a key, kept positive for use in the 'used' field */
+static unsigned int hash_key(const char *key)
+{
+	unsigned int hval = 2166136261u;
+
+	while (*key)
+		hval = (hval ^ (unsigned char)*key++) * 16777619;
+	hval &= 0x7fffffff;
+
+	return hval ? hval : 1;
+}
+
+/*
+ * Find the slot holding a key, returning 0 if it is not in the table. In
+ * that case *freep is set to the slot where it should be added, or 0 if
+ * the table is full.
+ */
+static unsigned int find_slot(struct hsearch_data *htab, const char *key,
+			      unsigned int hval, unsigned int *freep)
+{
+	unsigned int idx, step, probes;
+	_ENTRY *slot;
+
+	*freep = 0;
+	idx = 1 + hval % htab->size;
+	step = 1 + hval % (htab->size - 2);	/* as suggested in [Knuth] */
+	for (probes = 0; probes < htab->size; probes++) {
+		slot = &htab->table[idx];
+		if (!slot->used) {
+			if (!*freep)
+				*freep = idx;
+			break;
+		}
+		if (slot->used == -1) {
+			if (!*freep)
+				*freep = idx;
+		} else if (slot->used == hval &&
+			   strcmp(key, slot->entry.key) == 0) {
+			return idx;
+		}
+
+		/* Because SIZE is prime this steps through every slot */
+		if (idx <= step)
+			idx += htab->size;
+		idx -= step;
+	}
+
+	return 0;
+}
+
+/* Find where a key is, or should go, in the sorted list of slots */
+static unsigned int sorted_pos(struct hsearch_data *htab, const char *key)
+{
+	unsigned int low = 0, high = htab->filled, mid;
+
+	while (low < high) {
+		mid = (low + high) / 2;
+		if (strcmp(htab->table[htab->sorted[mid]].entry.key, key) < 0)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	return low;
+}
+
+/*
+ * Move the entries to a new table big enough to keep it no more than half
+ * full, dropping deleted slots. Returns 0 if there is not enough memory,
+ * in which case the old table is still in place.
+ */
+static int hresize_r(struct hsearch_data *htab)
+{
+	unsigned int size, i, idx;
+	unsigned int *sorted;
+	_ENTRY *table, *old;
+
+	size = (htab->filled + 1) * 2;
+	size = next_prime(size > htab->size ? size : htab->size);
+	table = calloc(size + 1, sizeof(_ENTRY));
+	sorted = malloc(size * sizeof(*sorted));
+	if (!table || !sorted) {
+		free(table);
+		free(sorted);
+		return 0;
+	}
+	debug("hresize: %d -> %d slots, %d used, %d deleted\n", htab->size,
+	      size, htab->filled, htab->deleted);
+
+	old = htab->table;
+	htab->table = table;
+	htab->size = size;
+	for (i = 0; i < htab->filled; i++) {
+		_ENTRY *ent = &old[htab->sorted[i]];
+
+		/* Keys are unique, so this just finds a free slot */
+		find_slot(htab, ent->entry.key, ent->used, &idx);
+		table[idx] = *ent;
+		sorted[i] = idx;
+	}
+	free(old);
+	free(htab->sorted);
+	htab->sorted = sorted;
+	htab->deleted = 0;
+
+	return 1;
+}
+
+/* Call an entry's callback, making sure it cannot move any entries */
+static int do_callback(struct hsearch_data *htab, const ENTRY *ep,
+		       const char *name, const char *value, enum env_op op,
+		       int flag)
+{
+	int ret;
+
+	if (!ep->callback)
+		return 0;
+	htab->busy++;
+	ret = ep->callback(name, value, op, flag);
+	htab->busy--;
+
+	return ret;
+}
+
 /*
  * Compare an existing entry with the desired key, and overwrite if the action
  * is ENTER.  This is simply a helper function for hsearch_r().
@@ -255,9 +406,8 @@ static inline int _compare_and_overwrite_entry(ENTRY item, ACTION action,
 			}
 
 			/* If there is a callback, call it */
-			if (htab->table[idx].entry.callback &&
-			    htab->table[idx].entry.callback(item.key,
-			    item.data, env_op_overwrite, flag)) {
+			if (do_callback(htab, &htab->table[idx].entry, item.key,
+					item.data, env_op_overwrite, flag)) {
 				debug("callback() rejected setting variable "
 					"%s, skipping it!\n", item.key);
 				__set_errno(EINVAL);
@@ -285,86 +435,29 @@ int hsearch_r(ENTRY item, ACTION action, ENTRY ** retval,
 	      struct hsearch_data *htab, int flag)
 {
 	unsigned int hval;
-	unsigned int count;
-	unsigned int len = strlen(item.key);
 	unsigned int idx;
-	unsigned int first_deleted = 0;
-	int ret;
-
-	/* Compute an value for the given string. Perhaps use a better method. */
-	hval = len;
-	count = len;
-	while (count-- > 0) {
-		hval <<= 4;
-		hval += item.key[count];
-	}
-
-	/*
-	 * First hash function:
-	 * simply take the modul but prevent zero.
-	 */
-	hval %= htab->size;
-	if (hval == 0)
-		++hval;
-
-	/* The first index tried. */
-	idx = hval;
-
-	if (htab->table[idx].used) {
-		/*
-		 * Further action might be required according to the
-		 * action value.
-		 */
-		unsigned hval2;
-
-		if (htab->table[idx].used == -1
-		    && !first_deleted)
-			first_deleted = idx;
+	unsigned int free_idx;
+	unsigned int pos;
 
-		ret = _compare_and_overwrite_entry(item, action, retval, htab,
+	hval = hash_key(item.key);
+	idx = find_slot(htab, item.key, hval, &free_idx);
+	if (idx)
+		return _compare_and_overwrite_entry(item, action, retval, htab,
 			flag, hval, idx);
-		if (ret != -1)
-			return ret;
-
-		/*
-		 * Second hash function:
-		 * as suggested in [Knuth]
-		 */
-		hval2 = 1 + hval % (htab->size - 2);
-
-		do {
-			/*
-			 * Because SIZE is prime this guarantees to
-			 * step through all available indices.
-			 */
-			if (idx <= hval2)
-				idx = htab->size + idx - hval2;
-			else
-				idx -= hval2;
-
-			/*
-			 * If we visited all entries leave the loop
-			 * unsuccessfully.
-			 */
-			if (idx == hval)
-				break;
-
-			/* If entry is found use it. */
-			ret = _compare_and_overwrite_entry(item, action, retval,
-				htab, flag, hval, idx);
-			if (ret != -1)
-				return ret;
-		}
-		while (htab->table[idx].used);
-	}
 
-	/* An empty bucket has been found. */
+	/* The key is not there. */
 	if (action == ENTER) {
+		/* Keep the table at most 3/4 full so that searches are short */
+		if (!htab->busy &&
+		    (htab->filled + htab->deleted + 1) * 4 > htab->size * 3 &&
+		    hresize_r(htab))
+			find_slot(htab, item.key, hval, &free_idx);
+
 		/*
 		 * If table is full and another entry should be
 		 * entered return with error.
 		 */
-		if (htab->filled == htab->size) {
+		if (!free_idx) {
 			__set_errno(ENOMEM);
 			*retval = NULL;
 			return 0;
@@ -374,8 +467,9 @@ int hsearch_r(ENTRY item, ACTION action, ENTRY ** retval,
 		 * Create new entry;
 		 * create copies of item.key and item.data
 		 */
-		if (first_deleted)
-			idx = first_deleted;
+		idx = free_idx;
+		if (htab->table[idx].used == -1)
+			--htab->deleted;
 
 		htab->table[idx].used = hval;
 		htab->table[idx].entry.key = strdup(item.key);
@@ -387,6 +481,11 @@ int hsearch_r(ENTRY item, ACTION action, ENTRY ** retval,
 			return 0;
 		}
 
+		/* Add it to the sorted list */
+		pos = sorted_pos(htab, item.key);
+		memmove(&htab->sorted[pos + 1], &htab->sorted[pos],
+			(htab->filled - pos) * sizeof(*htab->sorted));
+		htab->sorted[pos] = idx;
 		++htab->filled;
 
 		/* This is a new entry, so look up a possible callback */
@@ -406,9 +505,8 @@ int hsearch_r(ENTRY item, ACTION action, ENTRY ** retval,
 		}
 
 		/* If there is a callback, call it */
-		if (htab->table[idx].entry.callback &&
-		    htab->table[idx].entry.callback(item.key, item.data,
-		    env_op_create, flag)) {
+		if (do_callback(htab, &htab->table[idx].entry, item.key,
+				item.data, env_op_create, flag)) {
 			debug("callback() rejected setting variable "
 				"%s, skipping it!\n", item.key);
 			_hdelete(item.key, htab, &htab->table[idx].entry, idx);
@@ -441,6 +539,13 @@ int hsearch_r(ENTRY item, ACTION action, ENTRY ** retval,
 static void _hdelete(const char *key, struct hsearch_data *htab, ENTRY *ep,
 	int idx)
 {
+	unsigned int pos;
+
+	/* drop it from the sorted list */
+	pos = sorted_pos(htab, ep->key);
+	memmove(&htab->sorted[pos], &htab->sorted[pos + 1],
+		(htab->filled - pos - 1) * sizeof(*htab->sorted));
+
 	/* free used ENTRY */
 	debug("hdelete: DELETING key \"%s\"\n", key);
 	free((void *)ep->key);
@@ -450,6 +555,7 @@ static void _hdelete(const char *key, struct hsearch_data *htab, ENTRY *ep,
 	htab->table[idx].used = -1;
 
 	--htab->filled;
+	++htab->deleted;
 }
 
 int hdelete_r(const char *key, struct hsearch_data *htab, int flag)
@@ -477,8 +583,8 @@ int hdelete_r(const char *key, struct hsearch_data *htab, int flag)
 	}
 
 	/* If there is a callback, call it */
-	if (htab->table[idx].entry.callback &&
-	    htab->table[idx].entry.callback(key, NULL, env_op_delete, flag)) {
+	if (do_callback(htab, &htab->table[idx].entry, key, NULL,
+			env_op_delete, flag)) {
 		debug("callback() rejected deleting variable "
 			"%s, skipping it!\n", key);
 		__set_errno(EINVAL);
@@ -533,14 +639,6 @@ int hdelete_r(const char *key, struct hsearch_data *htab, int flag)
  *		bytes in the string will be '\0'-padded.
  */
 
-static int cmpkey(const void *p1, const void *p2)
-{
-	ENTRY *e1 = *(ENTRY **) p1;
-	ENTRY *e2 = *(ENTRY **) p2;
-
-	return (strcmp(e1->key, e2->key));
-}
-
 static int match_string(int flag, const char *str, const char *pat, void *priv)
 {
 	switch (flag & H_MATCH_METHOD) {
@@ -604,7 +702,7 @@ ssize_t hexport_r(struct hsearch_data *htab, const char sep, int flag,
 		 char **resp, size_t size,
 		 int argc, char * const argv[])
 {
-	ENTRY *list[htab->size];
+	ENTRY **list;
 	char *res, *p;
 	size_t totlen;
 	int i, n;
@@ -617,61 +715,53 @@ ssize_t hexport_r(struct hsearch_data *htab, const char sep, int flag,
 
 	debug("EXPORT  table = %p, htab.size = %d, htab.filled = %d, "
 		"size = %zu\n", htab, htab->size, htab->filled, size);
+	list = malloc((htab->filled + 1) * sizeof(*list));
+	if (list == NULL) {
+		__set_errno(ENOMEM);
+		return (-1);
+	}
+
 	/*
 	 * Pass 1:
-	 * search used entries,
+	 * search used entries, which are kept sorted by key,
 	 * save addresses and compute total length
 	 */
-	for (i = 1, n = 0, totlen = 0; i <= htab->size; ++i) {
+	for (i = 0, n = 0, totlen = 0; i < htab->filled; ++i) {
+		ENTRY *ep = &htab->table[htab->sorted[i]].entry;
+		int found = match_entry(ep, flag, argc, argv);
 
-		if (htab->table[i].used > 0) {
-			ENTRY *ep = &htab->table[i].entry;
-			int found = match_entry(ep, flag, argc, argv);
-
-			if ((argc > 0) && (found == 0))
-				continue;
+		if ((argc > 0) && (found == 0))
+			continue;
 
-			if ((flag & H_HIDE_DOT) && ep->key[0] == '.')
-				continue;
+		if ((flag & H_HIDE_DOT) && ep->key[0] == '.')
+			continue;
 
-			list[n++] = ep;
+		list[n++] = ep;
 
-			totlen += strlen(ep->key) + 2;
+		totlen += strlen(ep->key) + 2;
 
-			if (sep == '\0') {
-				totlen += strlen(ep->data);
-			} else {	/* check if escapes are needed */
-				char *s = ep->data;
+		if (sep == '\0') {
+			totlen += strlen(ep->data);
+		} else {	/* check if escapes are needed */
+			char *s = ep->data;
 
-				while (*s) {
+			while (*s) {
+				++totlen;
+				/* add room for needed escape chars */
+				if ((*s == sep) || (*s == '\\'))
 					++totlen;
-					/* add room for needed escape chars */
-					if ((*s == sep) || (*s == '\\'))
-						++totlen;
-					++s;
-				}
+				++s;
 			}
-			totlen += 2;	/* for '=' and 'sep' char */
 		}
+		totlen += 2;	/* for '=' and 'sep' char */
 	}
 
-#ifdef DEBUG
-	/* Pass 1a: print unsorted list */
-	printf("Unsorted: n=%d\n", n);
-	for (i = 0; i < n; ++i) {
-		printf("\t%3d: %p ==> %-10s => %s\n",
-		       i, list[i], list[i]->key, list[i]->data);
-	}
-#endif
-
-	/* Sort list by keys */
-	qsort(list, n, sizeof(ENTRY *), cmpkey);
-
 	/* Check if the user supplied buffer size is sufficient */
 	if (size) {
 		if (size < totlen + 1) {	/* provided buffer too small */
 			printf("Env export buffer too small: %zu, "
 				"but need %zu\n", size, totlen + 1);
+			free(list);
 			__set_errno(ENOMEM);
 			return (-1);
 		}
@@ -688,6 +778,7 @@ ssize_t hexport_r(struct hsearch_data *htab, const char sep, int flag,
 		/* no, allocate and clear one */
 		*resp = res = calloc(1, size);
 		if (res == NULL) {
+			free(list);
 			__set_errno(ENOMEM);
 			return (-1);
 		}
@@ -714,6 +805,7 @@ ssize_t hexport_r(struct hsearch_data *htab, const char sep, int flag,
 		*p++ = sep;
 	}
 	*p = '\0';		/* terminate result */
+	free(list);
 
 	return size;
 }
@@ -0,0 +1,279 @@
+/*
+ * Copyright (c) 2013 The Chromium OS Authors.
+ * See file CREDITS for list of people who contributed to this
+ * project.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+ * MA 02111-1307 USA
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <malloc.h>
+#include <mempool.h>
+
+/* Alignment of allocations, matching malloc() */
+#define MEMPOOL_ALIGN		(2 * sizeof(size_t))
+
+struct arena_chunk {
+	struct arena_chunk *next;
+	size_t size;		/* Number of bytes available after header */
+	size_t used;		/* Number of bytes used after header */
+};
+
+struct mem_pool_slab {
+	struct mem_pool_slab *next;
+};
+
+#define ARENA_HDR_SIZE		ALIGN(sizeof(struct arena_chunk), MEMPOOL_ALIGN)
+#define SLAB_HDR_SIZE		ALIGN(sizeof(struct mem_pool_slab), \
+				      MEMPOOL_ALIGN)
+
+static struct arena *arena_list;
+static struct mem_pool *mem_pool_list;
+
+static void arena_register(struct arena *arena)
+{
+	arena->next = arena_list;
+	arena_list = arena;
+	arena->registered = 1;
+}
+
+static struct arena_chunk *arena_add_chunk(struct arena *arena, size_t size)
+{
+	struct arena_chunk *chunk;
+
+	size = max(size, arena->chunk_size);
+	chunk = malloc(ARENA_HDR_SIZE + size);
+	if (!chunk)
+		return NULL;
+	chunk->size = size;
+	chunk->used = 0;
+	chunk->next = arena->chunk;
+	arena->chunk = chunk;
+	arena->chunk_count++;
+
+	return chunk;
+}
+
+void *arena_memalign(struct arena *arena, size_t align, size_t size)
+{
+	struct arena_chunk *chunk = arena->chunk;
+	ulong base, start;
+
+	if (!arena->registered)
+		arena_register(arena);
+	if (align < MEMPOOL_ALIGN)
+		align = MEMPOOL_ALIGN;
+	size = ALIGN(size, align);
+
+	/* Only the most recent chunk has space; the others are full */
+	if (chunk) {
+		base = (ulong)chunk + ARENA_HDR_SIZE;
+		start = ALIGN(base + chunk->used, align);
+		if (start + size > base + chunk->size)
+			chunk = NULL;
+	}
+	if (!chunk) {
+		chunk = arena_add_chunk(arena, size + align);
+		if (!chunk)
+			return NULL;
+		base = (ulong)chunk + ARENA_HDR_SIZE;
+		start = ALIGN(base, align);
+	}
+	arena->used += start + size - (base + chunk->used);
+	chunk->used = start + size - base;
+	if (arena->used > arena->peak)
+		arena->peak = arena->used;
+	arena->allocs++;
+
+	return (void *)start;
+}
+
+void *arena_alloc(struct arena *arena, size_t size)
+{
+	return arena_memalign(arena, MEMPOOL_ALIGN, size);
+}
+
+void arena_reset(struct arena *arena)
+{
+	struct arena_chunk *chunk = arena->chunk;
+
+	if (!chunk)
+		return;
+	arena->resets++;
+	arena->used = 0;
+	if (arena->chunk_count == 1) {
+		chunk->used = 0;
+		return;
+	}
+
+	/* Grow so that next time a single chunk will hold everything */
+	arena->chunk_size = 0;
+	for (chunk = arena->chunk; chunk; chunk = chunk->next)
+		arena->chunk_size += chunk->size;
+	debug("%s: arena '%s' grown to %#zx\n", __func__, arena->name,
+	      arena->chunk_size);
+	arena_destroy(arena);
+}
+
+void arena_destroy(struct arena *arena)
+{
+	struct arena_chunk *chunk, *next;
+
+	for (chunk = arena->chunk; chunk; chunk = next) {
+		next = chunk->next;
+		free(chunk);
+	}
+	arena->chunk = NULL;
+	arena->chunk_count = 0;
+	arena->used = 0;
+}
+
+static void mem_pool_register(struct mem_pool *pool)
+{
+	pool->next = mem_pool_list;
+	mem_pool_list = pool;
+	pool->registered = 1;
+}
+
+/* Objects must be able to hold the free-list pointer */
+static size_t mem_pool_obj_size(struct mem_pool *pool)
+{
+	return ALIGN(max(pool->obj_size, sizeof(void *)), MEMPOOL_ALIGN);
+}
+
+static int mem_pool_add_slab(struct mem_pool *pool)
+{
+	size_t obj_size = mem_pool_obj_size(pool);
+	struct mem_pool_slab *slab;
+	char *obj;
+	int i;
+
+	slab = malloc(SLAB_HDR_SIZE + obj_size * pool->per_slab);
+	if (!slab)
+		return -ENOMEM;
+	slab->next = pool->slab;
+	pool->slab = slab;
+	pool->slab_count++;
+
+	/* Put the objects on the free list, lowest address first */
+	obj = (char *)slab + SLAB_HDR_SIZE + obj_size * pool->per_slab;
+	for (i = 0; i < pool->per_slab; i++) {
+		obj -= obj_size;
+		*(void **)obj = pool->free_list;
+		pool->free_list = obj;
+	}
+
+	return 0;
+}
+
+void *mem_pool_alloc(struct mem_pool *pool)
+{
+	void *obj;
+
+	if (!pool->registered)
+		mem_pool_register(pool);
+	if (!pool->free_list && mem_pool_add_slab(pool))
+		return NULL;
+	obj = pool->free_list;
+	pool->free_list = *(void **)obj;
+	pool->allocs++;
+	if (++pool->in_use > pool->peak)
+		pool->peak = pool->in_use;
+
+	return obj;
+}
+
+void mem_pool_free(struct mem_pool *pool, void *ptr)
+{
+	if (!ptr)
+		return;
+	*(void **)ptr = pool->free_list;
+	pool->free_list = ptr;
+	pool->in_use--;
+}
+
+int mem_pool_set_size(struct mem_pool *pool, size_t obj_size)
+{
+	if (obj_size == pool->obj_size)
+		return 0;
+	if (pool->in_use)
+		return -EBUSY;
+	mem_pool_destroy(pool);
+	pool->obj_size = obj_size;
+
+	return 0;
+}
+
+void mem_pool_destroy(struct mem_pool *pool)
+{
+	struct mem_pool_slab *slab, *next;
+
+	if (pool->in_use)
+		printf("Pool '%s': destroyed with %d objects in use\n",
+		       pool->name, pool->in_use);
+	for (slab = pool->slab; slab; slab = next) {
+		next = slab->next;
+		free(slab);
+	}
+	pool->slab = NULL;
+	pool->slab_count = 0;
+	pool->free_list = NULL;
+	pool->in_use = 0;
+}
+
+void arena_print_stats(void)
+{
+	struct arena *arena;
+	struct arena_chunk *chunk;
+	size_t held;
+
+	if (!arena_list) {
+		printf("No arenas\n");
+		return;
+	}
+	printf("%-16s %6s %9s %9s %9s %9s %7s\n", "Arena", "Chunks", "Held",
+	       "Used", "Peak", "Allocs", "Resets");
+	for (arena = arena_list; arena; arena = arena->next) {
+		held = 0;
+		for (chunk = arena->chunk; chunk; chunk = chunk->next)
+			held += ARENA_HDR_SIZE + chunk->size;
+		printf("%-16s %6d %9zu %9zu %9zu %9lu %7lu\n", arena->name,
+		       arena->chunk_count, held, arena->used, arena->peak,
+		       arena->allocs, arena->resets);
+	}
+}
+
+void mem_pool_print_stats(void)
+{
+	struct mem_pool *pool;
+
+	if (!mem_pool_list) {
+		printf("No pools\n");
+		return;
+	}
+	printf("%-16s %7s %6s %9s %6s %6s %6s %9s\n", "Pool", "ObjSize",
+	       "Slabs", "Held", "InUse", "Peak", "Free", "Allocs");
+	for (pool = mem_pool_list; pool; pool = pool->next) {
+		printf("%-16s %7zu %6d %9zu %6d %6d %6d %9lu\n", pool->name,
+		       pool->obj_size, pool->slab_count,
+		       pool->slab_count * (SLAB_HDR_SIZE +
+				mem_pool_obj_size(pool) * pool->per_slab),
+		       pool->in_use, pool->peak,
+		       pool->slab_count * pool->per_slab - pool->in_use,
+		       pool->allocs);
+	}
+}
@@ -23,12 +23,16 @@
 
 #include <common.h>
 #include <fthread.h>
+#include <serial.h>
 #include <watchdog.h>
 
 #ifndef CONFIG_WD_PERIOD
 # define CONFIG_WD_PERIOD	(10 * 1000 * 1000)	/* 10 seconds default*/
 #endif
 
+/* How often udelay() sends more buffered serial output, in microseconds */
+#define SERIAL_FLUSH_PERIOD	100
+
 /* ------------------------------------------------------------------------- */
 
 void udelay(unsigned long usec)
@@ -38,6 +42,8 @@ void udelay(unsigned long usec)
 	do {
 		WATCHDOG_RESET();
 		kv = usec > CONFIG_WD_PERIOD ? CONFIG_WD_PERIOD : usec;
+		if (serial_flush(0) && kv > SERIAL_FLUSH_PERIOD)
+			kv = SERIAL_FLUSH_PERIOD;
 #if defined(CONFIG_FTHREAD) && !defined(CONFIG_SPL_BUILD)
 		kv = fthread_usleep(kv);
 		if (kv > usec)
@@ -18,15 +18,54 @@
  */
 
 #include <common.h>
+#include <errno.h>
 #include <trace.h>
 #include <asm/io.h>
 #include <asm/sections.h>
+#include <linux/compiler.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
 static char trace_enabled __attribute__((section(".data")));
 static char trace_inited __attribute__((section(".data")));
 
+/* Maximum call depth to record after relocation */
+#ifndef CONFIG_TRACE_DEPTH_LIMIT
+#define CONFIG_TRACE_DEPTH_LIMIT	15
+#endif
+
+#if defined(CONFIG_TRACE_DRAIN) && !defined(CONFIG_TRACE_COMPACT)
+#error "CONFIG_TRACE_DRAIN needs CONFIG_TRACE_COMPACT"
+#endif
+
+#ifdef CONFIG_TRACE_COMPACT
+/* Space for the chunk header and byte count in front of compact records */
+#define TRACE_COMPACT_HDR_SIZE	(sizeof(struct trace_output_hdr) + \
+				 sizeof(uint32_t))
+#endif
+
+#ifdef CONFIG_TRACE_STATS
+#ifndef CONFIG_TRACE_STATS_DEPTH
+#define CONFIG_TRACE_STATS_DEPTH	64
+#endif
+
+/* Largest number of functions that 'trace stats' can list */
+#define TRACE_TOP_MAX	100
+
+/* Time spent in a function, indexed like call_accum */
+struct trace_func_time {
+	uint32_t incl_us;	/* Total time, including called functions */
+	uint32_t excl_us;	/* Time spent in the function itself */
+};
+
+/* A frame on the shadow call stack */
+struct trace_frame {
+	uintptr_t func;		/* Function number */
+	ulong start_us;		/* Time of function entry */
+	ulong child_us;		/* Time spent in functions it called */
+};
+#endif
+
 /* The header block at the start of the trace memory area */
 struct trace_hdr {
 	int func_count;		/* Total number of function call sites */
@@ -41,14 +80,38 @@ struct trace_hdr {
 	uintptr_t *call_accum;
 
 	/* Function trace list */
+#ifdef CONFIG_TRACE_COMPACT
+	uint8_t *compact;	/* Delta-encoded function call records */
+	ulong compact_size;	/* Bytes of space for compact records */
+	ulong compact_used;	/* Bytes of compact records written */
+	ulong compact_count;	/* Num. of records in the compact buffer */
+	uint32_t prev_func;	/* Function of previous record */
+	uint32_t prev_time;	/* Timestamp of previous record */
+	ulong dropped_count;	/* Num. of records lost as buffer was full */
+#ifdef CONFIG_TRACE_DRAIN
+	int drain_err;		/* Error from the drain, 0 if none */
+	ulong drain_chunks;	/* Num. of chunks drained */
+	u64 drain_count;	/* Num. of records drained */
+	u64 drain_bytes;	/* Num. of bytes drained, including headers */
+#endif
+#else
 	struct trace_call *ftrace;	/* The function call records */
 	ulong ftrace_size;	/* Num. of ftrace records we have space for */
+#endif
 	ulong ftrace_count;	/* Num. of ftrace records written */
 	ulong ftrace_too_deep_count;	/* Functions that were too deep */
 
 	int depth;
 	int depth_limit;
 	int max_depth;
+
+#ifdef CONFIG_TRACE_STATS
+	struct trace_func_time *func_time;	/* Time for each function */
+	int stack_depth;	/* Number of frames on the shadow stack */
+	ulong stack_skip;	/* Calls not timed due to stack overflow */
+	ulong untimed_count;	/* Total calls not timed for that reason */
+	struct trace_frame stack[CONFIG_TRACE_STATS_DEPTH];
+#endif
 };
 
 static struct trace_hdr *hdr;	/* Pointer to start of trace buffer */
@@ -69,6 +132,97 @@ static inline uintptr_t __attribute__((no_instrument_function))
 	return offset / FUNC_SITE_SIZE;
 }
 
+#ifdef CONFIG_TRACE_COMPACT
+static inline uint8_t * __attribute__((no_instrument_function))
+		put_varint(uint8_t *p, uint32_t val)
+{
+	while (val >= 0x80) {
+		*p++ = val | 0x80;
+		val >>= 7;
+	}
+	*p++ = val;
+
+	return p;
+}
+
+static inline uint32_t __attribute__((no_instrument_function))
+		zigzag(uint32_t val)
+{
+	return val << 1 ^ -(val >> 31);
+}
+
+#ifdef CONFIG_TRACE_DRAIN
+/**
+ * Write out the compact records as a chunk and empty the buffer
+ *
+ * Tracing is paused while the drain runs, so its time is charged to
+ * whichever function was being entered or left.
+ *
+ * @return 0 if ok (or nothing to do), -ve on error
+ */
+static int __attribute__((no_instrument_function)) trace_drain_chunk(void)
+{
+	struct trace_output_hdr *out;
+	int was_enabled = trace_enabled;
+	uint8_t *start;
+	int size;
+
+	if (hdr->drain_err || !hdr->compact_count)
+		return hdr->drain_err;
+
+	/* The chunk header goes in the space we left in front of the data */
+	start = hdr->compact - TRACE_COMPACT_HDR_SIZE;
+	out = (struct trace_output_hdr *)start;
+	out->type = TRACE_CHUNK_COMPACT;
+	out->rec_count = hdr->compact_count;
+	*(uint32_t *)(out + 1) = hdr->compact_used;
+	size = TRACE_COMPACT_HDR_SIZE + hdr->compact_used;
+
+	trace_enabled = 0;
+	hdr->drain_err = trace_drain_write(start, size);
+	trace_enabled = was_enabled;
+	if (hdr->drain_err)
+		return hdr->drain_err;
+
+	hdr->drain_chunks++;
+	hdr->drain_count += hdr->compact_count;
+	hdr->drain_bytes += size;
+	hdr->compact_used = 0;
+	hdr->compact_count = 0;
+	hdr->prev_func = 0;
+	hdr->prev_time = 0;
+
+	return 0;
+}
+#endif
+
+/* Add a delta-encoded record, see trace_compact_decode() for the format */
+static void __attribute__((no_instrument_function)) add_compact(uint32_t func,
+				uint32_t caller, ulong flags)
+{
+	uint32_t time = flags & FUNCF_TIMESTAMP_MASK;
+	uint8_t *p;
+
+#ifdef CONFIG_TRACE_DRAIN
+	if (hdr->compact_used + TRACE_COMPACT_MAX > hdr->compact_size)
+		trace_drain_chunk();
+#endif
+	if (hdr->compact_used + TRACE_COMPACT_MAX > hdr->compact_size) {
+		hdr->dropped_count++;
+		return;
+	}
+	p = hdr->compact + hdr->compact_used;
+	p = put_varint(p, ((time - hdr->prev_time) & FUNCF_TIMESTAMP_MASK) <<
+		       2 | flags >> 30);
+	p = put_varint(p, zigzag(func - hdr->prev_func));
+	p = put_varint(p, zigzag(caller - func));
+	hdr->compact_used = p - hdr->compact;
+	hdr->compact_count++;
+	hdr->prev_func = func;
+	hdr->prev_time = time;
+}
+#endif
+
 static void __attribute__((no_instrument_function)) add_ftrace(void *func_ptr,
 				void *caller, ulong flags)
 {
@@ -76,6 +230,10 @@ static void __attribute__((no_instrument_function)) add_ftrace(void *func_ptr,
 		hdr->ftrace_too_deep_count++;
 		return;
 	}
+#ifdef CONFIG_TRACE_COMPACT
+	add_compact(func_ptr_to_num(func_ptr), func_ptr_to_num(caller),
+		    flags | (timer_get_us() & FUNCF_TIMESTAMP_MASK));
+#else
 	if (hdr->ftrace_count < hdr->ftrace_size) {
 		struct trace_call *rec = &hdr->ftrace[hdr->ftrace_count];
 
@@ -83,11 +241,15 @@ static void __attribute__((no_instrument_function)) add_ftrace(void *func_ptr,
 		rec->caller = func_ptr_to_num(caller);
 		rec->flags = flags | (timer_get_us() & FUNCF_TIMESTAMP_MASK);
 	}
+#endif
 	hdr->ftrace_count++;
 }
 
 static void __attribute__((no_instrument_function)) add_textbase(void)
 {
+#ifdef CONFIG_TRACE_COMPACT
+	add_compact(CONFIG_SYS_TEXT_BASE, 0, FUNCF_TEXTBASE);
+#else
 	if (hdr->ftrace_count < hdr->ftrace_size) {
 		struct trace_call *rec = &hdr->ftrace[hdr->ftrace_count];
 
@@ -95,9 +257,132 @@ static void __attribute__((no_instrument_function)) add_textbase(void)
 		rec->caller = 0;
 		rec->flags = FUNCF_TEXTBASE;
 	}
+#endif
 	hdr->ftrace_count++;
 }
 
+/* Work out the size of the header and the per-function arrays */
+static size_t __attribute__((no_instrument_function))
+		trace_hdr_size(ulong func_count)
+{
+	size_t size = sizeof(*hdr) + func_count * sizeof(uintptr_t);
+
+#ifdef CONFIG_TRACE_STATS
+	size += func_count * sizeof(struct trace_func_time);
+#endif
+	return size;
+}
+
+/* Set up the pointers to the per-function arrays which follow the header */
+static void __attribute__((no_instrument_function)) trace_set_arrays(void)
+{
+	hdr->call_accum = (uintptr_t *)(hdr + 1);
+#ifdef CONFIG_TRACE_STATS
+	hdr->func_time = (struct trace_func_time *)
+			(hdr->call_accum + hdr->func_count);
+#endif
+}
+
+/* Use the space after the per-function arrays for the function trace */
+static void __attribute__((no_instrument_function))
+		trace_set_records(char *buff, size_t size)
+{
+#ifdef CONFIG_TRACE_COMPACT
+	/* Leave space in front of the records for a chunk header */
+	hdr->compact = (uint8_t *)buff + TRACE_COMPACT_HDR_SIZE;
+	hdr->compact_size = size > TRACE_COMPACT_HDR_SIZE ?
+			size - TRACE_COMPACT_HDR_SIZE : 0;
+#else
+	hdr->ftrace = (struct trace_call *)buff;
+	hdr->ftrace_size = size / sizeof(*hdr->ftrace);
+#endif
+}
+
+#ifdef CONFIG_TRACE_EARLY
+/* Copy the function trace records from the early trace buffer */
+static ulong __attribute__((no_instrument_function))
+		trace_copy_records(struct trace_hdr *early)
+{
+#ifdef CONFIG_TRACE_COMPACT
+	ulong size = early->compact_used;
+
+	if (size > hdr->compact_size) {
+		hdr->dropped_count += hdr->compact_count;
+		hdr->compact_used = 0;
+		hdr->compact_count = 0;
+		hdr->prev_func = 0;
+		hdr->prev_time = 0;
+		return 0;
+	}
+	memcpy(hdr->compact, early->compact, size);
+#else
+	ulong count = min(early->ftrace_count, early->ftrace_size);
+	ulong size;
+
+	count = min(count, hdr->ftrace_size);
+	size = count * sizeof(*hdr->ftrace);
+	memcpy(hdr->ftrace, early->ftrace, size);
+#endif
+
+	return size;
+}
+#endif
+
+#ifdef CONFIG_TRACE_STATS
+/* Push a new frame onto the shadow stack on function entry */
+static void __attribute__((no_instrument_function))
+		trace_stats_enter(uintptr_t func)
+{
+	struct trace_frame *frame;
+
+	if (hdr->stack_depth == CONFIG_TRACE_STATS_DEPTH) {
+		hdr->stack_skip++;
+		hdr->untimed_count++;
+		return;
+	}
+	frame = &hdr->stack[hdr->stack_depth++];
+	frame->func = func;
+	frame->child_us = 0;
+	frame->start_us = timer_get_us();
+}
+
+/* Pop a frame from the shadow stack, and add up the time it took */
+static void __attribute__((no_instrument_function))
+		trace_stats_exit(uintptr_t func)
+{
+	struct trace_frame *frame;
+	ulong elapsed;
+	int i;
+
+	if (hdr->stack_skip) {
+		hdr->stack_skip--;
+		return;
+	}
+
+	/*
+	 * Exits are lost if tracing is paused, so look down the stack for
+	 * the matching frame. If there is none, this function was entered
+	 * before tracing started.
+	 */
+	for (i = hdr->stack_depth - 1; i >= 0; i--) {
+		if (hdr->stack[i].func == func)
+			break;
+	}
+	if (i < 0)
+		return;
+
+	frame = &hdr->stack[i];
+	elapsed = timer_get_us() - frame->start_us;
+	if (func < hdr->func_count) {
+		hdr->func_time[func].incl_us += elapsed;
+		hdr->func_time[func].excl_us += elapsed - frame->child_us;
+	}
+	if (i)
+		hdr->stack[i - 1].child_us += elapsed;
+	hdr->stack_depth = i;
+}
+#endif
+
 /**
  * This is called on every function entry
  *
@@ -124,13 +409,16 @@ void __attribute__((no_instrument_function)) __cyg_profile_func_enter(
 		hdr->depth++;
 		if (hdr->depth > hdr->depth_limit)
 			hdr->max_depth = hdr->depth;
+#ifdef CONFIG_TRACE_STATS
+		trace_stats_enter(func);
+#endif
 	}
 }
 
 /**
  * This is called on every function exit
  *
- * We do nothing here.
+ * We record the exit, and the time taken if CONFIG_TRACE_STATS is enabled.
  *
  * @param func_ptr	Pointer to function being entered
  * @param caller	Pointer to function which called this function
@@ -141,6 +429,9 @@ void __attribute__((no_instrument_function)) __cyg_profile_func_exit(
 	if (trace_enabled) {
 		add_ftrace(func_ptr, caller, FUNCF_EXIT);
 		hdr->depth--;
+#ifdef CONFIG_TRACE_STATS
+		trace_stats_exit(func_ptr_to_num(func_ptr));
+#endif
 	}
 }
 
@@ -206,6 +497,15 @@ int trace_list_calls(void *buff, int buff_size, unsigned *needed)
 	void *end, *ptr = buff;
 	int rec, upto;
 	int count;
+#ifdef CONFIG_TRACE_COMPACT
+	int was_enabled = trace_enabled;
+	const uint8_t *cp = hdr->compact;
+	struct trace_call call;
+
+	/* Stop the buffer from being drained while we decode it */
+	trace_enabled = 0;
+	memset(&call, '\0', sizeof(call));
+#endif
 
 	end = buff ? buff + buff_size : NULL;
 
@@ -215,21 +515,35 @@ int trace_list_calls(void *buff, int buff_size, unsigned *needed)
 	ptr += sizeof(struct trace_output_hdr);
 
 	/* Add information about each call */
+#ifdef CONFIG_TRACE_COMPACT
+	count = hdr->compact_count;
+#else
 	count = hdr->ftrace_count;
 	if (count > hdr->ftrace_size)
 		count = hdr->ftrace_size;
+#endif
 	for (rec = upto = 0; rec < count; rec++) {
+#ifdef CONFIG_TRACE_COMPACT
+		cp = trace_compact_decode(cp, &call);
+#endif
 		if (ptr + sizeof(struct trace_call) < end) {
-			struct trace_call *call = &hdr->ftrace[rec];
+#ifdef CONFIG_TRACE_COMPACT
+			struct trace_call *call_rec = &call;
+#else
+			struct trace_call *call_rec = &hdr->ftrace[rec];
+#endif
 			struct trace_call *out = ptr;
 
-			out->func = call->func * FUNC_SITE_SIZE;
-			out->caller = call->caller * FUNC_SITE_SIZE;
-			out->flags = call->flags;
+			out->func = call_rec->func * FUNC_SITE_SIZE;
+			out->caller = call_rec->caller * FUNC_SITE_SIZE;
+			out->flags = call_rec->flags;
 			upto++;
 		}
 		ptr += sizeof(struct trace_call);
 	}
+#ifdef CONFIG_TRACE_COMPACT
+	trace_enabled = was_enabled;
+#endif
 
 	/* Update the header */
 	if (output_hdr) {
@@ -247,7 +561,7 @@ int trace_list_calls(void *buff, int buff_size, unsigned *needed)
 /* Print basic information about tracing */
 void trace_print_stats(void)
 {
-	ulong count;
+	ulong count, dropped;
 
 #ifndef FTRACE
 	puts("Warning: make U-Boot with FTRACE to enable function instrumenting.\n");
@@ -263,25 +577,127 @@ void trace_print_stats(void)
 	puts(" function calls\n");
 	print_grouped_ull(hdr->untracked_count, 10);
 	puts(" untracked function calls\n");
-	count = min(hdr->ftrace_count, hdr->ftrace_size);
+#ifdef CONFIG_TRACE_COMPACT
+	dropped = hdr->dropped_count;
+#else
+	dropped = 0;
+	if (hdr->ftrace_count > hdr->ftrace_size)
+		dropped = hdr->ftrace_count - hdr->ftrace_size;
+#endif
+	count = hdr->ftrace_count - dropped;
 	print_grouped_ull(count, 10);
 	puts(" traced function calls");
-	if (hdr->ftrace_count > hdr->ftrace_size) {
-		printf(" (%lu dropped due to overflow)",
-		       hdr->ftrace_count - hdr->ftrace_size);
-	}
+	if (dropped)
+		printf(" (%lu dropped due to overflow)", dropped);
+	puts("\n");
+#ifdef CONFIG_TRACE_COMPACT
+	print_grouped_ull(hdr->compact_used, 10);
+	printf(" bytes used by %lu buffered calls", hdr->compact_count);
+	if (hdr->compact_count)
+		printf(" (%lu.%02lu bytes each)",
+		       hdr->compact_used / hdr->compact_count,
+		       hdr->compact_used * 100 / hdr->compact_count % 100);
 	puts("\n");
+#endif
+#ifdef CONFIG_TRACE_DRAIN
+	print_grouped_ull(hdr->drain_count, 10);
+	printf(" calls drained in %lu chunks\n", hdr->drain_chunks);
+	print_grouped_ull(hdr->drain_bytes, 10);
+	puts(" bytes drained\n");
+	if (hdr->drain_err)
+		printf("%15d error from drain\n", hdr->drain_err);
+#endif
 	printf("%15d maximum observed call depth\n", hdr->max_depth);
 	printf("%15d call depth limit\n", hdr->depth_limit);
 	print_grouped_ull(hdr->ftrace_too_deep_count, 10);
 	puts(" calls not traced due to depth\n");
+#ifdef CONFIG_TRACE_STATS
+	print_grouped_ull(hdr->untimed_count, 10);
+	puts(" calls not timed due to depth\n");
+#endif
+}
+
+#ifdef CONFIG_TRACE_STATS
+void trace_print_top(int count)
+{
+	struct trace_func_time *ft;
+	int top[TRACE_TOP_MAX];
+	int was_enabled;
+	int func, used;
+	int i;
+
+	if (!trace_inited) {
+		printf("Trace is disabled\n");
+		return;
+	}
+
+	/* Don't let our own function calls upset the figures */
+	was_enabled = trace_enabled;
+	trace_enabled = 0;
+	count = min(count, TRACE_TOP_MAX);
+
+	/* Keep a sorted list of the functions with most exclusive time */
+	for (func = used = 0; func < hdr->func_count; func++) {
+		if (!hdr->call_accum[func])
+			continue;
+		ft = &hdr->func_time[func];
+		for (i = used; i > 0; i--) {
+			if (hdr->func_time[top[i - 1]].excl_us >= ft->excl_us)
+				break;
+			if (i < count)
+				top[i] = top[i - 1];
+		}
+		if (i < count) {
+			top[i] = func;
+			if (used < count)
+				used++;
+		}
+	}
+
+	printf("Top %d functions by exclusive time:\n", used);
+	printf("%15s%15s%15s  %s\n", "Excl us", "Incl us", "Calls", "Offset");
+	for (i = 0; i < used; i++) {
+		func = top[i];
+		ft = &hdr->func_time[func];
+		print_grouped_ull(ft->excl_us, 10);
+		print_grouped_ull(ft->incl_us, 10);
+		print_grouped_ull(hdr->call_accum[func], 10);
+		printf("  %08x\n", func * FUNC_SITE_SIZE);
+	}
+	trace_enabled = was_enabled;
 }
+#endif
 
 void __attribute__((no_instrument_function)) trace_set_enabled(int enabled)
 {
 	trace_enabled = enabled != 0;
 }
 
+#ifdef CONFIG_TRACE_DRAIN
+int __weak trace_drain_write(const void *buf, int size)
+{
+#ifdef CONFIG_TRACE_DRAIN_ADDR
+	ulong offset = hdr->drain_bytes;
+
+	if (offset + size > CONFIG_TRACE_DRAIN_SIZE)
+		return -ENOSPC;
+	memcpy(map_sysmem(CONFIG_TRACE_DRAIN_ADDR + offset, size), buf, size);
+
+	return 0;
+#else
+	return -ENOSYS;
+#endif
+}
+
+int trace_drain(void)
+{
+	if (!trace_inited)
+		return -ENOENT;
+
+	return trace_drain_chunk();
+}
+#endif
+
 /**
  * Init the tracing system ready for used, and enable it
  *
@@ -295,48 +711,58 @@ int __attribute__((no_instrument_function)) trace_init(void *buff,
 	size_t needed;
 	int was_disabled = !trace_enabled;
 
-	if (!was_disabled) {
 #ifdef CONFIG_TRACE_EARLY
-		char *end;
-		ulong used;
+	struct trace_hdr *early = NULL;
+#endif
 
+	if (!was_disabled) {
+#ifdef CONFIG_TRACE_EARLY
 		/*
-		 * Copy over the early trace data if we have it. Disable
-		 * tracing while we are doing this.
+		 * Copy over the early trace header if we have it. Disable
+		 * tracing while we are doing this. The records are copied
+		 * below, once we know where they go.
 		 */
 		trace_enabled = 0;
-		hdr = map_sysmem(CONFIG_TRACE_EARLY_ADDR,
-				 CONFIG_TRACE_EARLY_SIZE);
-		end = (char *)&hdr->ftrace[hdr->ftrace_count];
-		used = end - (char *)hdr;
-		printf("trace: copying %08lx bytes of early data from %x to %08lx\n",
-		       used, CONFIG_TRACE_EARLY_ADDR, map_to_sysmem(buff));
-		memcpy(buff, hdr, used);
+		early = map_sysmem(CONFIG_TRACE_EARLY_ADDR,
+				   CONFIG_TRACE_EARLY_SIZE);
+		memcpy(buff, early, sizeof(*early));
 #else
 		puts("trace: already enabled\n");
 		return -1;
 #endif
 	}
 	hdr = (struct trace_hdr *)buff;
-	needed = sizeof(*hdr) + func_count * sizeof(uintptr_t);
+	needed = trace_hdr_size(func_count);
 	if (needed > buff_size) {
 		printf("trace: buffer size %zd bytes: at least %zd needed\n",
 		       buff_size, needed);
 		return -1;
 	}
 
+	/*
+	 * The early per-function arrays were sized before gd->mon_len was
+	 * set up, so start them afresh
+	 */
 	if (was_disabled)
 		memset(hdr, '\0', needed);
+	else
+		memset(hdr + 1, '\0', needed - sizeof(*hdr));
 	hdr->func_count = func_count;
-	hdr->call_accum = (uintptr_t *)(hdr + 1);
+	trace_set_arrays();
 
 	/* Use any remaining space for the timed function trace */
-	hdr->ftrace = (struct trace_call *)(buff + needed);
-	hdr->ftrace_size = (buff_size - needed) / sizeof(*hdr->ftrace);
+	trace_set_records(buff + needed, buff_size - needed);
+#ifdef CONFIG_TRACE_EARLY
+	if (early) {
+		printf("trace: copied %08lx bytes of early data from %x to %08lx\n",
+		       trace_copy_records(early), CONFIG_TRACE_EARLY_ADDR,
+		       map_to_sysmem(buff));
+	}
+#endif
 	add_textbase();
 
 	puts("trace: enabled\n");
-	hdr->depth_limit = 15;
+	hdr->depth_limit = CONFIG_TRACE_DEPTH_LIMIT;
 	trace_enabled = 1;
 	trace_inited = 1;
 	return 0;
@@ -354,7 +780,7 @@ int __attribute__((no_instrument_function)) trace_early_init(void)
 		return 0;
 
 	hdr = map_sysmem(CONFIG_TRACE_EARLY_ADDR, CONFIG_TRACE_EARLY_SIZE);
-	needed = sizeof(*hdr) + func_count * sizeof(uintptr_t);
+	needed = trace_hdr_size(func_count);
 	if (needed > buff_size) {
 		printf("trace: buffer size is %zd bytes, at least %zd needed\n",
 		       buff_size, needed);
@@ -362,12 +788,11 @@ int __attribute__((no_instrument_function)) trace_early_init(void)
 	}
 
 	memset(hdr, '\0', needed);
-	hdr->call_accum = (uintptr_t *)(hdr + 1);
 	hdr->func_count = func_count;
+	trace_set_arrays();
 
 	/* Use any remaining space for the timed function trace */
-	hdr->ftrace = (struct trace_call *)((char *)hdr + needed);
-	hdr->ftrace_size = (buff_size - needed) / sizeof(*hdr->ftrace);
+	trace_set_records((char *)hdr + needed, buff_size - needed);
 	add_textbase();
 	hdr->depth_limit = 200;
 	printf("trace: early enable at %08x\n", CONFIG_TRACE_EARLY_ADDR);
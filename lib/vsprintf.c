@@ -18,6 +18,7 @@
 #include <errno.h>
 
 #include <common.h>
+#include <serial.h>
 #if !defined(CONFIG_PANIC_HANG)
 #include <command.h>
 #endif
@@ -839,6 +840,7 @@ void panic(const char *fmt, ...)
 	vprintf(fmt, args);
 	putc('\n');
 	va_end(args);
+	serial_flush(1);
 #if defined(CONFIG_PANIC_HANG)
 	hang();
 #else
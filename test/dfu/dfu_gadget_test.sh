@@ -0,0 +1,81 @@
+#!/bin/sh
+# Copyright (c) 2013 The Chromium OS Authors.
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License as
+# published by the Free Software Foundation; either version 2 of
+# the License, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston,
+# MA 02111-1307 USA
+#
+
+# Test DFU writes to a raw MMC entity, using dfu-util on the host
+#
+# The board must be running 'dfu mmc <dev>' with a raw ("mmc" or "part")
+# entity whose alt setting is given as the first argument. Its contents
+# are overwritten.
+#
+# Each file is downloaded with a transfer size which is not a multiple of
+# the block size as well as the usual one, so that chunks end part-way
+# through a block. The file is then uploaded again and compared.
+
+if [ $# -ne 1 ]; then
+	echo "Usage: $0 <alt>"
+	exit 1
+fi
+alt=$1
+
+# Sizes either side of the 512-byte block size and of a 1 MiB boundary
+sizes="1 511 512 513 4095 4096 4097 1048575 1048576 1048577"
+
+# dfu-util transfer sizes: the usual 4096, then two odd ones
+xfer_sizes="4096 1000 4095"
+
+dir=$(mktemp -d)
+ok=true
+
+fail() {
+	echo "Test failed: $1"
+	ok=false
+}
+
+for size in ${sizes}; do
+	head -c ${size} /dev/urandom >${dir}/dat.bin
+	for xfer in ${xfer_sizes}; do
+		echo "Size ${size}, transfer size ${xfer}"
+		rm -f ${dir}/readback.bin
+		if ! dfu-util -a ${alt} -t ${xfer} -D ${dir}/dat.bin \
+				>${dir}/log 2>&1; then
+			fail "download of ${size} bytes"
+			continue
+		fi
+		if ! dfu-util -a ${alt} -U ${dir}/readback.bin \
+				>${dir}/log 2>&1; then
+			fail "upload after ${size} bytes"
+			continue
+		fi
+
+		# The entity is larger than the file, so only check our part
+		if ! cmp -n ${size} ${dir}/dat.bin ${dir}/readback.bin; then
+			fail "readback of ${size} bytes, transfer size ${xfer}"
+		fi
+	done
+done
+
+rm -rf ${dir}
+
+echo
+if ${ok}; then
+	echo "Test passed"
+else
+	echo "Test failed"
+	exit 1
+fi
@@ -44,6 +44,8 @@ struct func_info {
 	const char *name;
 	unsigned long code_size;
 	unsigned long call_count;
+	unsigned long self_samples;	/* Samples in this function itself */
+	unsigned long total_samples;	/* Samples in it or its callees */
 	unsigned flags;
 	/* the section this function is in */
 	struct objsection_info *objsection;
@@ -68,6 +70,9 @@ struct func_info *func_list;
 int func_count;
 struct trace_call *call_list;
 int call_count;
+uint32_t *sample_list;	/* Samples, each a count and that many offsets */
+int sample_count;
+int sample_words;	/* Number of words in sample_list */
 int verbose;	/* Verbosity level 0=none, 1=warn, 2=notice, 3=info, 4=debug */
 unsigned long text_offset;		/* text address of first function */
 
@@ -98,6 +103,8 @@ static void usage(void)
 		"\n"
 		"Commands\n"
 		"   dump-ftrace\t\tDump out textual data in ftrace format\n"
+		"   dump-profile\t\tDump a flat profile from profile samples\n"
+		"   dump-folded\t\tDump folded stacks (for flamegraph.pl)\n"
 		"\n"
 		"Options:\n"
 		"   -m <map>\tSpecify Systen.map file\n"
@@ -239,6 +246,80 @@ static int read_calls(FILE *fin, int count)
 	return 0;
 }
 
+/* Decode a chunk of compact records, adding them to the call list */
+static int read_compact(FILE *fin, int count)
+{
+	struct trace_call call, *call_data;
+	const uint8_t *ptr, *end;
+	uint8_t *buff;
+	uint32_t size;
+	int i;
+
+	notice("compact call count: %d\n", count);
+	if (read_data(fin, &size, sizeof(size)))
+		return 1;
+	/* Allow for a corrupt last record running off the end */
+	buff = calloc(1, size + TRACE_COMPACT_MAX);
+	call_list = realloc(call_list, (call_count + count) *
+			    sizeof(*call_data));
+	if (!buff || !call_list) {
+		error("Cannot allocate call_list\n");
+		return -1;
+	}
+	if (read_data(fin, buff, size)) {
+		free(buff);
+		return 1;
+	}
+
+	memset(&call, '\0', sizeof(call));
+	ptr = buff;
+	end = buff + size;
+	call_data = call_list + call_count;
+	for (i = 0; i < count && ptr < end; i++, call_data++) {
+		ptr = trace_compact_decode(ptr, &call);
+		call_data->func = call.func * FUNC_SITE_SIZE;
+		call_data->caller = call.caller * FUNC_SITE_SIZE;
+		call_data->flags = call.flags;
+	}
+	call_count += i;
+	free(buff);
+	if (i != count || ptr != end) {
+		error("Corrupt compact chunk at pos %ld\n", ftell(fin));
+		return -1;
+	}
+
+	return 0;
+}
+
+static int read_samples(FILE *fin, int count)
+{
+	int alloced = 0;
+	uint32_t depth;
+	int i;
+
+	notice("sample count: %d\n", count);
+	sample_count = count;
+	for (i = 0; i < count; i++) {
+		if (read_data(fin, &depth, sizeof(depth)))
+			return 1;
+		if (sample_words + depth + 1 > alloced) {
+			alloced += 4096 + depth;
+			sample_list = realloc(sample_list,
+					      alloced * sizeof(uint32_t));
+			if (!sample_list) {
+				error("Cannot allocate sample_list\n");
+				return -1;
+			}
+		}
+		sample_list[sample_words] = depth;
+		if (depth && read_data(fin, &sample_list[sample_words + 1],
+				       depth * sizeof(uint32_t)))
+			return 1;
+		sample_words += depth + 1;
+	}
+	return 0;
+}
+
 static int read_profile(FILE *fin, int *not_found)
 {
 	struct trace_output_hdr hdr;
@@ -262,6 +343,16 @@ static int read_profile(FILE *fin, int *not_found)
 			if (read_calls(fin, hdr.rec_count))
 				return 1;
 			break;
+
+		case TRACE_CHUNK_SAMPLES:
+			if (read_samples(fin, hdr.rec_count))
+				return 1;
+			break;
+
+		case TRACE_CHUNK_COMPACT:
+			if (read_compact(fin, hdr.rec_count))
+				return 1;
+			break;
 		}
 	}
 	return 0;
@@ -544,6 +635,147 @@ static int make_ftrace(void)
 	return 0;
 }
 
+static int h_cmp_samples(const void *v1, const void *v2)
+{
+	const struct func_info *f1 = *(const struct func_info **)v1;
+	const struct func_info *f2 = *(const struct func_info **)v2;
+
+	if (f1->self_samples != f2->self_samples)
+		return f1->self_samples < f2->self_samples ? 1 : -1;
+	return f1->total_samples < f2->total_samples ? 1 : -1;
+}
+
+/*
+ * Each sample holds the interrupted PC followed by return addresses, so
+ * look up the function containing each one.
+ */
+static struct func_info *sample_func(uint32_t offset)
+{
+	/* Addresses outside U-Boot (e.g. in the C library) are unknown */
+	if (!func_count || offset < func_list[0].offset ||
+	    offset >= func_list[func_count - 1].offset)
+		return NULL;
+	return find_caller_by_offset(offset);
+}
+
+static int make_flat_profile(void)
+{
+	struct func_info **sorted, *func, *outer;
+	uint32_t *sample;
+	int i, j, n;
+
+	if (!sample_count) {
+		error("No profile samples found\n");
+		return -1;
+	}
+	for (i = 0, sample = sample_list; i < sample_count;
+	     i++, sample += *sample + 1) {
+		for (j = 0; j < *sample; j++) {
+			func = sample_func(sample[j + 1]);
+			if (!func)
+				continue;
+			if (!j)
+				func->self_samples++;
+
+			/* Count recursive functions only once per sample */
+			for (n = 0; n < j; n++) {
+				outer = sample_func(sample[n + 1]);
+				if (outer == func)
+					break;
+			}
+			if (n == j)
+				func->total_samples++;
+		}
+	}
+
+	sorted = calloc(func_count, sizeof(*sorted));
+	if (!sorted) {
+		error("Cannot allocate sorted list\n");
+		return -1;
+	}
+	for (i = n = 0; i < func_count; i++) {
+		if (func_list[i].total_samples)
+			sorted[n++] = &func_list[i];
+	}
+	qsort(sorted, n, sizeof(*sorted), h_cmp_samples);
+
+	printf("%d samples\n", sample_count);
+	printf("%7s %7s %9s  %s\n", "self%", "total%", "samples", "function");
+	for (i = 0; i < n; i++) {
+		func = sorted[i];
+		printf("%6.2f%% %6.2f%% %9lu  %s\n",
+		       func->self_samples * 100.0 / sample_count,
+		       func->total_samples * 100.0 / sample_count,
+		       func->self_samples, func->name);
+	}
+	free(sorted);
+
+	return 0;
+}
+
+static int h_cmp_string(const void *v1, const void *v2)
+{
+	return strcmp(*(char * const *)v1, *(char * const *)v2);
+}
+
+/*
+ * Output the samples in the 'folded' format used by flamegraph.pl, i.e. one
+ * line per unique stack, like 'outer;inner;innermost <count>'
+ */
+static int make_folded(void)
+{
+	struct func_info *func;
+	char buf[MAX_LINE_LEN * 4], **stacks;
+	uint32_t *sample;
+	int i, j, count;
+
+	if (!sample_count) {
+		error("No profile samples found\n");
+		return -1;
+	}
+	stacks = calloc(sample_count, sizeof(*stacks));
+	if (!stacks) {
+		error("Cannot allocate stack list\n");
+		return -1;
+	}
+	for (i = 0, sample = sample_list; i < sample_count;
+	     i++, sample += *sample + 1) {
+		const char *name, *prev = NULL;
+		char *ptr = buf, *end = buf + sizeof(buf);
+
+		*ptr = '\0';
+		for (j = *sample - 1; j >= 0; j--) {
+			func = sample_func(sample[j + 1]);
+			name = func ? func->name : "[unknown]";
+
+			/* Merge runs of unknown functions */
+			if (!func && prev == name)
+				continue;
+			ptr += snprintf(ptr, end - ptr, "%s%s",
+					ptr == buf ? "" : ";", name);
+			if (ptr >= end)
+				ptr = end - 1;
+			prev = name;
+		}
+		stacks[i] = strdup(buf);
+	}
+
+	/* Sort the stacks so that identical ones can be counted */
+	qsort(stacks, sample_count, sizeof(*stacks), h_cmp_string);
+	for (i = 0; i < sample_count; i += count) {
+		for (count = 1; i + count < sample_count; count++) {
+			if (strcmp(stacks[i], stacks[i + count]))
+				break;
+		}
+		printf("%s %d\n", stacks[i], count);
+	}
+	for (i = 0; i < sample_count; i++)
+		free(stacks[i]);
+	free(stacks);
+
+	return 0;
+}
+
 static int prof_tool(int argc, char * const argv[],
 		     const char *prof_fname, const char *map_fname,
 		     const char *trace_config_fname)
@@ -564,6 +796,10 @@ static int prof_tool(int argc, char * const argv[],
 
 		if (0 == strcmp(cmd, "dump-ftrace"))
 			err = make_ftrace();
+		else if (0 == strcmp(cmd, "dump-profile"))
+			err = make_flat_profile();
+		else if (0 == strcmp(cmd, "dump-folded"))
+			err = make_folded();
 		else
 			warn("Unknown command '%s'\n", cmd);
 	}